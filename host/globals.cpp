@@ -0,0 +1,9 @@
+// State that minecraft.cpp owns in the console build.
+
+#include <cstdint>
+
+bool should_destroy_block = false;
+bool should_place_block = false;
+int cursor_x = 0;
+int cursor_y = 0;
+uint8_t light_map[1024] __attribute__((aligned(32))) = {0};
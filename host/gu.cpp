@@ -0,0 +1,276 @@
+#include <ogc/gu.h>
+
+#include <cmath>
+#include <cstring>
+
+void guMtxIdentity(Mtx mt)
+{
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            mt[i][j] = i == j ? 1.0f : 0.0f;
+}
+
+void guMtxCopy(const Mtx src, Mtx dst)
+{
+    if (src != dst)
+        std::memcpy(dst, src, sizeof(Mtx));
+}
+
+void guMtxConcat(const Mtx a, const Mtx b, Mtx ab)
+{
+    Mtx tmp;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            tmp[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+            if (j == 3)
+                tmp[i][j] += a[i][3];
+        }
+    }
+    guMtxCopy(tmp, ab);
+}
+
+void guMtxScale(Mtx mt, f32 xs, f32 ys, f32 zs)
+{
+    guMtxIdentity(mt);
+    mt[0][0] = xs;
+    mt[1][1] = ys;
+    mt[2][2] = zs;
+}
+
+void guMtxScaleApply(const Mtx src, Mtx dst, f32 xs, f32 ys, f32 zs)
+{
+    const f32 scale[3] = {xs, ys, zs};
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            dst[i][j] = src[i][j] * scale[i];
+}
+
+void guMtxTrans(Mtx mt, f32 xt, f32 yt, f32 zt)
+{
+    guMtxIdentity(mt);
+    mt[0][3] = xt;
+    mt[1][3] = yt;
+    mt[2][3] = zt;
+}
+
+void guMtxTransApply(const Mtx src, Mtx dst, f32 xt, f32 yt, f32 zt)
+{
+    guMtxCopy(src, dst);
+    dst[0][3] += xt;
+    dst[1][3] += yt;
+    dst[2][3] += zt;
+}
+
+// The Apply variants multiply from the right, so the scale or translation happens first
+void guMtxApplyScale(const Mtx src, Mtx dst, f32 xs, f32 ys, f32 zs)
+{
+    const f32 scale[3] = {xs, ys, zs};
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            dst[i][j] = src[i][j] * scale[j];
+        dst[i][3] = src[i][3];
+    }
+}
+
+void guMtxApplyTrans(const Mtx src, Mtx dst, f32 xt, f32 yt, f32 zt)
+{
+    Mtx result;
+    guMtxCopy(src, result);
+    for (int i = 0; i < 3; i++)
+        result[i][3] = src[i][0] * xt + src[i][1] * yt + src[i][2] * zt + src[i][3];
+    guMtxCopy(result, dst);
+}
+
+void guMtxRotRad(Mtx mt, const char axis, f32 rad)
+{
+    f32 s = std::sin(rad);
+    f32 c = std::cos(rad);
+    guMtxIdentity(mt);
+    switch (axis)
+    {
+    case 'x':
+    case 'X':
+        mt[1][1] = c;
+        mt[1][2] = -s;
+        mt[2][1] = s;
+        mt[2][2] = c;
+        break;
+    case 'y':
+    case 'Y':
+        mt[0][0] = c;
+        mt[0][2] = s;
+        mt[2][0] = -s;
+        mt[2][2] = c;
+        break;
+    case 'z':
+    case 'Z':
+        mt[0][0] = c;
+        mt[0][1] = -s;
+        mt[1][0] = s;
+        mt[1][1] = c;
+        break;
+    default:
+        break;
+    }
+}
+
+void guMtxRotAxisRad(Mtx mt, guVector *axis, f32 rad)
+{
+    guVector n = *axis;
+    guVecNormalize(&n);
+    f32 s = std::sin(rad);
+    f32 c = std::cos(rad);
+    f32 t = 1.0f - c;
+
+    mt[0][0] = t * n.x * n.x + c;
+    mt[0][1] = t * n.x * n.y - s * n.z;
+    mt[0][2] = t * n.x * n.z + s * n.y;
+    mt[0][3] = 0.0f;
+    mt[1][0] = t * n.x * n.y + s * n.z;
+    mt[1][1] = t * n.y * n.y + c;
+    mt[1][2] = t * n.y * n.z - s * n.x;
+    mt[1][3] = 0.0f;
+    mt[2][0] = t * n.x * n.z - s * n.y;
+    mt[2][1] = t * n.y * n.z + s * n.x;
+    mt[2][2] = t * n.z * n.z + c;
+    mt[2][3] = 0.0f;
+}
+
+u32 guMtxInverse(const Mtx src, Mtx inv)
+{
+    f32 det = src[0][0] * (src[1][1] * src[2][2] - src[1][2] * src[2][1]) -
+              src[0][1] * (src[1][0] * src[2][2] - src[1][2] * src[2][0]) +
+              src[0][2] * (src[1][0] * src[2][1] - src[1][1] * src[2][0]);
+    if (det == 0.0f)
+        return 0;
+    f32 d = 1.0f / det;
+
+    Mtx tmp;
+    tmp[0][0] = (src[1][1] * src[2][2] - src[1][2] * src[2][1]) * d;
+    tmp[0][1] = (src[0][2] * src[2][1] - src[0][1] * src[2][2]) * d;
+    tmp[0][2] = (src[0][1] * src[1][2] - src[0][2] * src[1][1]) * d;
+    tmp[1][0] = (src[1][2] * src[2][0] - src[1][0] * src[2][2]) * d;
+    tmp[1][1] = (src[0][0] * src[2][2] - src[0][2] * src[2][0]) * d;
+    tmp[1][2] = (src[0][2] * src[1][0] - src[0][0] * src[1][2]) * d;
+    tmp[2][0] = (src[1][0] * src[2][1] - src[1][1] * src[2][0]) * d;
+    tmp[2][1] = (src[0][1] * src[2][0] - src[0][0] * src[2][1]) * d;
+    tmp[2][2] = (src[0][0] * src[1][1] - src[0][1] * src[1][0]) * d;
+    for (int i = 0; i < 3; i++)
+        tmp[i][3] = -(tmp[i][0] * src[0][3] + tmp[i][1] * src[1][3] + tmp[i][2] * src[2][3]);
+    guMtxCopy(tmp, inv);
+    return 1;
+}
+
+void guVecMultiply(const Mtx mt, const guVector *src, guVector *dst)
+{
+    guVector v = *src;
+    dst->x = mt[0][0] * v.x + mt[0][1] * v.y + mt[0][2] * v.z + mt[0][3];
+    dst->y = mt[1][0] * v.x + mt[1][1] * v.y + mt[1][2] * v.z + mt[1][3];
+    dst->z = mt[2][0] * v.x + mt[2][1] * v.y + mt[2][2] * v.z + mt[2][3];
+}
+
+void guVecMultiplySR(const Mtx mt, const guVector *src, guVector *dst)
+{
+    guVector v = *src;
+    dst->x = mt[0][0] * v.x + mt[0][1] * v.y + mt[0][2] * v.z;
+    dst->y = mt[1][0] * v.x + mt[1][1] * v.y + mt[1][2] * v.z;
+    dst->z = mt[2][0] * v.x + mt[2][1] * v.y + mt[2][2] * v.z;
+}
+
+void guVecNormalize(guVector *v)
+{
+    f32 length = std::sqrt(v->x * v->x + v->y * v->y + v->z * v->z);
+    if (length == 0.0f)
+        return;
+    v->x /= length;
+    v->y /= length;
+    v->z /= length;
+}
+
+void guVecCross(const guVector *a, const guVector *b, guVector *axb)
+{
+    guVector result = {a->y * b->z - a->z * b->y, a->z * b->x - a->x * b->z, a->x * b->y - a->y * b->x};
+    *axb = result;
+}
+
+f32 guVecDotProduct(const guVector *a, const guVector *b)
+{
+    return a->x * b->x + a->y * b->y + a->z * b->z;
+}
+
+void guLookAt(Mtx mt, const guVector *camPos, const guVector *camUp, const guVector *target)
+{
+    guVector look = {camPos->x - target->x, camPos->y - target->y, camPos->z - target->z};
+    guVecNormalize(&look);
+    guVector right;
+    guVecCross(camUp, &look, &right);
+    guVecNormalize(&right);
+    guVector up;
+    guVecCross(&look, &right, &up);
+
+    mt[0][0] = right.x;
+    mt[0][1] = right.y;
+    mt[0][2] = right.z;
+    mt[0][3] = -guVecDotProduct(camPos, &right);
+    mt[1][0] = up.x;
+    mt[1][1] = up.y;
+    mt[1][2] = up.z;
+    mt[1][3] = -guVecDotProduct(camPos, &up);
+    mt[2][0] = look.x;
+    mt[2][1] = look.y;
+    mt[2][2] = look.z;
+    mt[2][3] = -guVecDotProduct(camPos, &look);
+}
+
+void guMtx44Identity(Mtx44 mt)
+{
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            mt[i][j] = i == j ? 1.0f : 0.0f;
+}
+
+void guMtx44Copy(const Mtx44 src, Mtx44 dst)
+{
+    if (src != dst)
+        std::memcpy(dst, src, sizeof(Mtx44));
+}
+
+void guPerspective(Mtx44 mt, f32 fovy, f32 aspect, f32 n, f32 f)
+{
+    f32 cot = 1.0f / std::tan(DegToRad(fovy) * 0.5f);
+    f32 tmp = 1.0f / (f - n);
+    guMtx44Identity(mt);
+    mt[0][0] = cot / aspect;
+    mt[1][1] = cot;
+    mt[2][2] = -n * tmp;
+    mt[2][3] = -(f * n) * tmp;
+    mt[3][2] = -1.0f;
+    mt[3][3] = 0.0f;
+}
+
+void guOrtho(Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f)
+{
+    guMtx44Identity(mt);
+    mt[0][0] = 2.0f / (r - l);
+    mt[0][3] = -(r + l) / (r - l);
+    mt[1][1] = 2.0f / (t - b);
+    mt[1][3] = -(t + b) / (t - b);
+    mt[2][2] = -1.0f / (f - n);
+    mt[2][3] = -f / (f - n);
+}
+
+void guFrustum(Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f)
+{
+    guMtx44Identity(mt);
+    mt[0][0] = 2.0f * n / (r - l);
+    mt[0][2] = (r + l) / (r - l);
+    mt[1][1] = 2.0f * n / (t - b);
+    mt[1][2] = (t + b) / (t - b);
+    mt[2][2] = -n / (f - n);
+    mt[2][3] = -(f * n) / (f - n);
+    mt[3][2] = -1.0f;
+    mt[3][3] = 0.0f;
+}
@@ -0,0 +1,497 @@
+// Draws generated terrain meshed by ChunkRenderer through gertex and the software
+// GX, writes the frame to a PNG and prints the counters. Then checks that merged
+// faces draw like the faces they replace, and optionally that the frame matches
+// a reference image. Exits with 1 if any image check fails.
+//
+// Usage: gx_host [output.png] [terrain.png] [frames] [reference.png]
+//
+// It also reports the heap held by the display lists and the scratch lists of the
+// mesher after meshing a wider area of the same terrain.
+
+#include "gx_soft.hpp"
+
+#include <gertex/gertex.hpp>
+#include <gertex/displaylist.hpp>
+#include <pnguin/png_loader.hpp>
+#include <render/base3d.hpp>
+#include <render/buffer.hpp>
+#include <render/render.hpp>
+#include <render/render_chunks.hpp>
+#include <registry/textures.hpp>
+#include <world/chunk.hpp>
+#include <world/world.hpp>
+
+#include "headless.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Same order as the FACE_* constants
+static const int face_normals[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+// Corners of each face in the winding of cube_vertex_offsets in render.cpp
+static const int face_corners[6][4][3] = {
+    {{0, -1, -1}, {0, 1, -1}, {0, 1, 1}, {0, -1, 1}},
+    {{0, -1, 1}, {0, 1, 1}, {0, 1, -1}, {0, -1, -1}},
+    {{-1, 0, -1}, {-1, 0, 1}, {1, 0, 1}, {1, 0, -1}},
+    {{1, 0, -1}, {1, 0, 1}, {-1, 0, 1}, {-1, 0, -1}},
+    {{1, -1, 0}, {1, 1, 0}, {-1, 1, 0}, {-1, -1, 0}},
+    {{-1, -1, 0}, {-1, 1, 0}, {1, 1, 0}, {1, -1, 0}},
+};
+
+constexpr int SCENE_SIZE = 16;
+
+// Chunks meshed and drawn around the origin. The ring of chunks around them is generated too.
+constexpr int WORLD_RADIUS = 1;
+constexpr int64_t WORLD_SEED = 1;
+
+// An image check fails if more than this share of the pixels differs by more than PIXEL_TOLERANCE in a channel
+constexpr double MAX_DIFFERENT_PIXELS = 0.002;
+constexpr int PIXEL_TOLERANCE = 8;
+
+// Sections meshed by the heap measurement, and the radius of the chunks around the origin they are taken from
+constexpr uint32_t HEAP_SECTIONS = 17 * 17;
+constexpr int HEAP_RADIUS = 4;
+
+// Bytes in aligned allocations, which gertex and the display list arena use for their buffers
+static size_t heap_bytes = 0;
+static size_t heap_peak = 0;
+static std::unordered_map<void *, size_t> *heap_blocks = nullptr;
+
+void *operator new[](std::size_t size, std::align_val_t align)
+{
+    void *ptr = std::aligned_alloc(size_t(align), (size + size_t(align) - 1) & ~(size_t(align) - 1));
+    if (!ptr)
+        throw std::bad_alloc();
+    if (!heap_blocks)
+        heap_blocks = new std::unordered_map<void *, size_t>();
+    (*heap_blocks)[ptr] = size;
+    heap_bytes += size;
+    heap_peak = std::max(heap_peak, heap_bytes);
+    return ptr;
+}
+
+// gertex frees its lists with a plain delete[], so every array delete has to check for a counted block
+void operator delete[](void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    if (heap_blocks)
+    {
+        auto it = heap_blocks->find(ptr);
+        if (it != heap_blocks->end())
+        {
+            heap_bytes -= it->second;
+            heap_blocks->erase(it);
+        }
+    }
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+static void put_face(gertex::DisplayListCompact16 &list, int x, int y, int z, int face, int texture_index)
+{
+    static const float corner_uv[4][2] = {{0, 1}, {0, 0}, {1, 0}, {1, 1}};
+    for (int i = 0; i < 4; i++)
+    {
+        const int *corner = face_corners[face][i];
+        gertex::Vertex16 vertex{};
+        vertex.x = int16_t((x * 2 + 1 + face_normals[face][0] + corner[0]) * 16);
+        vertex.y = int16_t((y * 2 + 1 + face_normals[face][1] + corner[1]) * 16);
+        vertex.z = int16_t((z * 2 + 1 + face_normals[face][2] + corner[2]) * 16);
+        vertex.i = 255;
+        vertex.nrm = face;
+        vertex.u = float(TEXTURE_X(texture_index) + corner_uv[i][0] * BASE3D_BLOCK_UV_SCALE);
+        vertex.v = float(TEXTURE_Y(texture_index) + corner_uv[i][1] * BASE3D_BLOCK_UV_SCALE);
+        list.put(vertex);
+    }
+}
+
+// Builds the tile map of the terrain atlas like registry::init_terrain_texture.
+static void init_tile_map()
+{
+    static uint8_t map[512] __attribute__((aligned(32)));
+    for (int y = 0; y < 16; y++)
+    {
+        for (int x = 0; x < 16; x++)
+        {
+            uint8_t *texel = map + (((y >> 2) << 2) + (x >> 2)) * 32 + (((y & 3) << 2) + (x & 3)) * 2;
+            texel[0] = x;
+            texel[1] = y;
+        }
+    }
+    GX_InitTexObj(&terrain_tile_map, map, 16, 16, GX_TF_IA8, GX_CLAMP, GX_CLAMP, GX_FALSE);
+    GX_InitTexObjFilterMode(&terrain_tile_map, GX_NEAR, GX_NEAR);
+}
+
+static std::vector<uint8_t> copy_frame()
+{
+    uint32_t width, height;
+    const uint8_t *frame = gx_soft::get_frame(width, height);
+    return std::vector<uint8_t>(frame, frame + width * height * 4);
+}
+
+// Returns the number of pixels that differ by more than PIXEL_TOLERANCE in any channel.
+static uint32_t count_different(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    uint32_t different = 0;
+    for (size_t i = 0; i < a.size(); i += 4)
+        for (int j = 0; j < 4; j++)
+            if (std::abs(int(a[i + j]) - int(b[i + j])) > PIXEL_TOLERANCE)
+            {
+                different++;
+                break;
+            }
+    return different;
+}
+
+// Prints the result of an image check and returns whether it passed.
+static bool check_image(const std::string &name, uint32_t different, size_t pixels)
+{
+    bool passed = different <= pixels * MAX_DIFFERENT_PIXELS;
+    std::printf("%s: %u of %zu pixels differ, %s\n", name.c_str(), different, pixels, passed ? "pass" : "FAIL");
+    return passed;
+}
+
+// Draws a floor of top faces over the scene, one face per block or as a single quad that
+// repeats its tile with the indirect stage like use_tiled_terrain. Returns the frame.
+static std::vector<uint8_t> draw_floor(const Mtx &view, int texture_index, bool tiled, uint32_t &vertices)
+{
+    gertex::DisplayListCompact16 list(SCENE_SIZE * SCENE_SIZE * 4 + 4, VERTEX_ATTR_LENGTH_TERRAIN, tiled ? BASE3D_TILED_VTXFMT : BASE3D_TERRAIN_VTXFMT, tiled ? BASE3D_TILED_UV_FRAC_BITS : BASE3D_TERRAIN_UV_FRAC_BITS);
+    list.begin(GX_QUADS);
+    if (tiled)
+    {
+        static const float corner_uv[4][2] = {{0, 1}, {0, 0}, {1, 0}, {1, 1}};
+        for (int i = 0; i < 4; i++)
+        {
+            const int *corner = face_corners[3][i];
+            gertex::Vertex16 vertex{};
+            vertex.x = int16_t((corner[0] + 1) * SCENE_SIZE * 16);
+            vertex.y = 32;
+            vertex.z = int16_t((corner[2] + 1) * SCENE_SIZE * 16);
+            vertex.i = 255;
+            vertex.nrm = 3;
+            vertex.u = float(texture_index & 15) + corner_uv[i][0] * SCENE_SIZE * BASE3D_BLOCK_UV_SCALE;
+            vertex.v = float(texture_index >> 4) + corner_uv[i][1] * SCENE_SIZE * BASE3D_BLOCK_UV_SCALE;
+            list.put(vertex);
+        }
+    }
+    else
+    {
+        for (int z = 0; z < SCENE_SIZE; z++)
+            for (int x = 0; x < SCENE_SIZE; x++)
+                put_face(list, x, 0, z, 3, texture_index);
+    }
+    vertices = uint32_t(list.size() - 3) / VERTEX_ATTR_LENGTH_TERRAIN;
+    std::memcpy(&list.buffer[1], &vertices, 2);
+    uint32_t length = list.aligned_size();
+    uint8_t *buffer = list.build();
+
+    use_tiled_terrain(tiled);
+    gertex::use_matrix(view);
+    gertex::call_display_list(buffer, length, VERTEX_ATTR_LENGTH_TERRAIN);
+    use_tiled_terrain(false);
+    GX_CopyDisp(nullptr, GX_TRUE);
+    delete[] buffer;
+    return copy_frame();
+}
+
+static void draw_pass(World &world, const Mtx &view, BufferPass Section::*pass, uint32_t vertex_length)
+{
+    for (Chunk *chunk : world.chunks)
+    {
+        if (std::abs(chunk->x) > WORLD_RADIUS || std::abs(chunk->z) > WORLD_RADIUS)
+            continue;
+        for (Section &section : chunk->sections)
+        {
+            VBO &buffer = (section.*pass).cached;
+            if (!buffer)
+                continue;
+            gertex::GXMatrix matrix;
+            guMtxApplyTrans(view, matrix.mtx, section.x + 0.5f, section.y + 0.5f, section.z + 0.5f);
+            gertex::use_matrix(matrix);
+            gertex::call_display_list(buffer.buffer, buffer.length, vertex_length);
+        }
+    }
+}
+
+// Draws the meshed sections of the world with the passes and state of World::draw.
+static void draw_world(World &world, const Mtx &view)
+{
+    GX_SetZMode(GX_TRUE, GX_LEQUAL, GX_TRUE);
+    gertex::set_blending(gertex::GXBlendMode::overwrite);
+    gertex::set_alpha_cutoff(0);
+    draw_pass(world, view, &Section::solid, VERTEX_ATTR_LENGTH_TERRAIN);
+    use_tiled_terrain(true);
+    draw_pass(world, view, &Section::tiled, VERTEX_ATTR_LENGTH_TERRAIN);
+    use_tiled_terrain(false);
+
+    gertex::set_blending(gertex::GXBlendMode::normal);
+    gertex::set_alpha_cutoff(1);
+    draw_pass(world, view, &Section::transparent, VERTEX_ATTR_LENGTH_TERRAIN);
+    gertex::GXState state = gertex::get_state();
+    gertex::set_color_format(0, GX_DIRECT);
+    draw_pass(world, view, &Section::colored, VERTEX_ATTR_LENGTH_TERRAIN_DIRECTCOLOR);
+    gertex::set_state(state);
+    GX_CopyDisp(nullptr, GX_TRUE);
+}
+
+// Meshes the chunks within WORLD_RADIUS, with or without merging faces.
+static void mesh_world(World &world, bool greedy)
+{
+    world.greedy_meshing = greedy;
+    for (Chunk *chunk : world.chunks)
+        if (std::abs(chunk->x) <= WORLD_RADIUS && std::abs(chunk->z) <= WORLD_RADIUS)
+            headless::mesh_chunk(*chunk);
+}
+
+struct HeapUse
+{
+    size_t peak;
+    size_t steady;
+};
+
+// Generates terrain around the origin and meshes HEAP_SECTIONS sections that are not empty
+// through ChunkRenderer like the section updates do, with the default settings of the game.
+// Then meshes them all again, as block changes and light updates do. Returns the heap use
+// relative to the start, with the display lists of the sections still held and the scratch
+// lists kept by the mesher.
+static HeapUse mesh_terrain_heap(VBOStats &vbo_stats)
+{
+    size_t start = heap_bytes;
+    heap_peak = heap_bytes;
+    World *world = headless::create_world(WORLD_SEED);
+    headless::generate_chunks(*world, HEAP_RADIUS + 1);
+    headless::light_world(*world);
+    world->greedy_meshing = false;
+    world->smooth_lighting = false;
+    std::vector<std::pair<Chunk *, int>> meshed;
+    for (Chunk *chunk : world->chunks)
+    {
+        if (std::abs(chunk->x) > HEAP_RADIUS || std::abs(chunk->z) > HEAP_RADIUS)
+            continue;
+        for (int i = 0; i < VERTICAL_SECTION_COUNT && meshed.size() < HEAP_SECTIONS; i++)
+        {
+            headless::mesh_section(*chunk, i);
+            vbo_frame_done();
+            Section &section = chunk->sections[i];
+            if (section.solid.cached || section.transparent.cached || section.colored.cached || section.tiled.cached)
+                meshed.emplace_back(chunk, i);
+        }
+    }
+    for (auto &section : meshed)
+    {
+        headless::mesh_section(*section.first, section.second);
+        vbo_frame_done();
+    }
+    vbo_stats = get_vbo_stats();
+    HeapUse use = {heap_peak - start, heap_bytes - start};
+    headless::destroy_world(world);
+    vbo_frame_done();
+    vbo_frame_done();
+    vbo_release_arena();
+    return use;
+}
+
+// Loads the light map like the game does, or falls back to a ramp over the light level.
+static void load_light_map()
+{
+    try
+    {
+        pnguin::PNGFile file("textures/light_day.png");
+        if (file.get_width() * file.get_height() * 4 == sizeof(light_map))
+        {
+            std::memcpy(light_map, file.get_data(), sizeof(light_map));
+            return;
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::fprintf(stderr, "%s, using a generated light map\n", e.what());
+    }
+    for (int i = 0; i < 256; i++)
+    {
+        uint8_t level = uint8_t(std::max(i >> 4, i & 15) * 17);
+        light_map[i * 4] = light_map[i * 4 + 1] = light_map[i * 4 + 2] = level;
+        light_map[i * 4 + 3] = 255;
+    }
+}
+
+// Generates a 256x256 atlas of 16x16 tiles with a different checker pattern in each tile.
+static uint8_t *generate_terrain()
+{
+    const int size = 256;
+    uint8_t *tiles = new (std::align_val_t(32)) uint8_t[size * size * 4];
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            int tile = (y >> 4) * 16 + (x >> 4);
+            bool dark = ((x >> 2) ^ (y >> 2)) & 1;
+            uint8_t rgba[4] = {uint8_t(tile * 53), uint8_t(96 + tile * 31), uint8_t(tile * 97), 255};
+            if (dark)
+                for (int i = 0; i < 3; i++)
+                    rgba[i] = rgba[i] * 3 / 4;
+            int index = (size << 2) * (y & ~3) + ((x & ~3) << 4);
+            int index_within = ((x & 3) + ((y & 3) << 2)) << 1;
+            tiles[index + index_within + 1] = rgba[0];
+            tiles[index + index_within + 32] = rgba[1];
+            tiles[index + index_within + 33] = rgba[2];
+            tiles[index + index_within] = rgba[3];
+        }
+    }
+    return tiles;
+}
+
+int main(int argc, char **argv)
+{
+    std::string output = argc > 1 ? argv[1] : "gx_host.png";
+    std::string terrain = argc > 2 ? argv[2] : "";
+    int frames = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1;
+    std::string reference = argc > 4 ? argv[4] : "";
+
+    GXRModeObj rmode{};
+    rmode.fbWidth = 640;
+    rmode.efbHeight = 480;
+    rmode.xfbHeight = 480;
+    rmode.viHeight = 480;
+    gertex::init(&rmode);
+    gertex::perspective(gertex::GXView(640, 480, false, 70, gertex::CAMERA_NEAR, gertex::CAMERA_FAR));
+    GX_SetCopyClear(GXColor{120, 160, 255, 255}, GX_MAX_Z24);
+
+    bool loaded = false;
+    if (!terrain.empty())
+    {
+        try
+        {
+            pnguin::PNGFile(terrain).to_tpl(terrain_texture);
+            loaded = true;
+        }
+        catch (std::exception &e)
+        {
+            std::fprintf(stderr, "%s, using a generated terrain texture\n", e.what());
+        }
+    }
+    if (!loaded)
+        GX_InitTexObj(&terrain_texture, generate_terrain(), 256, 256, GX_TF_RGBA8, GX_CLAMP, GX_CLAMP, GX_FALSE);
+    GX_InitTexObjFilterMode(&terrain_texture, GX_NEAR, GX_NEAR);
+    GX_LoadTexObj(&terrain_texture, GX_TEXMAP0);
+    init_tile_map();
+
+    load_light_map();
+    GX_SetArray(GX_VA_CLR0, light_map, 4 * sizeof(u8));
+    init_face_normals();
+
+    // Set up like World::draw_scene
+    gertex::set_color_format(0, GX_INDEX8);
+    gertex::set_color_format(1, GX_INDEX8);
+    gertex::set_pos_precision(GX_S16, BASE3D_POS_FRAC_BITS);
+    use_terrain_vertex_format();
+    GX_SetCullMode(GX_CULL_BACK);
+    GX_SetZMode(GX_TRUE, GX_LEQUAL, GX_TRUE);
+
+    // Heap held by the meshes of generated terrain, measured first so that it includes the scratch lists
+    headless::register_game();
+    VBOStats vbo_stats;
+    HeapUse heap = mesh_terrain_heap(vbo_stats);
+    std::printf("heap for %u sections: peak %zu KB, steady %zu KB, of which %zu KB scratch (arena %u KB, %u KB of it used, largest free %u KB, %u KB on the heap, %u lists dropped)\n",
+                HEAP_SECTIONS, heap.peak >> 10, heap.steady >> 10, ChunkRenderer::get_scratch_size() >> 10, vbo_stats.arena_size >> 10, vbo_stats.arena_used >> 10,
+                vbo_stats.arena_largest_free >> 10, vbo_stats.heap_bytes >> 10, vbo_stats.failed_allocs);
+    std::printf("%u bytes of display lists per section\n", vbo_stats.bytes / HEAP_SECTIONS);
+
+    // Generated terrain meshed the way the game meshes it, with faces merged like the default settings
+    World *world = headless::create_world(WORLD_SEED);
+    headless::generate_chunks(*world, WORLD_RADIUS + 1);
+    headless::light_world(*world);
+    mesh_world(*world, true);
+
+    guVector camera = {-20.0f, 96.0f, -20.0f};
+    guVector up = {0.0f, 1.0f, 0.0f};
+    guVector target = {8.0f, 64.0f, 8.0f};
+    Mtx view;
+    guLookAt(view, &camera, &up, &target);
+
+    // The embedded framebuffer is cleared by each copy, so start from a cleared one
+    GX_CopyDisp(nullptr, GX_TRUE);
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        gx_soft::reset_raster_stats();
+        draw_world(*world, view);
+        gertex::end_frame();
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::vector<uint8_t> greedy_frame = copy_frame();
+
+    gertex::GXStats stats = gertex::get_frame_stats();
+    const gx_soft::RasterStats &raster = gx_soft::get_raster_stats();
+    std::printf("display list: %u bytes, %u draw calls, %u primitives, %u vertices\n", stats.display_list_bytes, stats.draw_calls, stats.primitives, stats.vertices);
+    std::printf("rasteriser: %u triangles, %u culled, %u pixels\n", raster.triangles, raster.culled, raster.pixels);
+    std::printf("%d frames in %.1f ms (%.2f ms per frame)\n", frames, elapsed, elapsed / frames);
+
+    if (!gx_soft::save_png(output))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", output.c_str());
+        return 1;
+    }
+    std::printf("wrote %s\n", output.c_str());
+
+    bool passed = true;
+    size_t pixels = greedy_frame.size() / 4;
+    if (!reference.empty())
+    {
+        try
+        {
+            pnguin::PNGFile file(reference);
+            if (file.get_width() * file.get_height() != pixels)
+                throw std::runtime_error("The size of " + reference + " does not match the frame");
+            std::vector<uint8_t> expected(file.get_data(), file.get_data() + pixels * 4);
+            passed &= check_image("frame against " + reference, count_different(greedy_frame, expected), pixels);
+        }
+        catch (std::exception &e)
+        {
+            std::printf("%s: FAIL\n", e.what());
+            passed = false;
+        }
+    }
+
+    // The tiled pass has to draw merged faces exactly like the faces it replaces
+    mesh_world(*world, false);
+    draw_world(*world, view);
+    gertex::end_frame();
+    passed &= check_image("terrain with merged faces (" + std::to_string(stats.vertices) + " vertices instead of " + std::to_string(gertex::get_frame_stats().vertices) + ")",
+                          count_different(greedy_frame, copy_frame()), pixels);
+    for (int texture_index : {0, 2, 19})
+    {
+        uint32_t block_vertices, tiled_vertices;
+        std::vector<uint8_t> blocks = draw_floor(view, texture_index, false, block_vertices);
+        std::vector<uint8_t> tiled = draw_floor(view, texture_index, true, tiled_vertices);
+        passed &= check_image("tiled floor of tile " + std::to_string(texture_index) + " (" + std::to_string(tiled_vertices) + " vertices instead of " + std::to_string(block_vertices) + ")",
+                              count_different(blocks, tiled), pixels);
+    }
+    headless::destroy_world(world);
+    vbo_frame_done();
+    vbo_frame_done();
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,1792 @@
+#include "gx_soft.hpp"
+
+#include <ogc/gx.h>
+#include <miniz/miniz.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace gx_soft
+{
+    constexpr int EFB_WIDTH = 640;
+    constexpr int EFB_HEIGHT = 528;
+
+    // Colour 0 and 1, then s and t of every texture coordinate
+    constexpr int MAX_VARYINGS = 8 + 2 * GX_MAXCOORD;
+
+    struct AttrFormat
+    {
+        u8 count = 0;
+        u8 type = 0;
+        u8 frac = 0;
+    };
+
+    struct AttrArray
+    {
+        const u8 *data = nullptr;
+        u8 stride = 0;
+    };
+
+    struct TevStage
+    {
+        u8 texcoord = GX_TEXCOORDNULL;
+        u16 texmap = GX_TEXMAP_NULL;
+        u8 channel = GX_COLORNULL;
+        u8 color_in[4] = {GX_CC_ZERO, GX_CC_ZERO, GX_CC_ZERO, GX_CC_RASC};
+        u8 alpha_in[4] = {GX_CA_ZERO, GX_CA_ZERO, GX_CA_ZERO, GX_CA_RASA};
+        u8 color_op = GX_TEV_ADD;
+        u8 color_bias = GX_TB_ZERO;
+        u8 color_scale = GX_CS_SCALE_1;
+        u8 color_clamp = GX_TRUE;
+        u8 color_reg = GX_TEVPREV;
+        u8 alpha_op = GX_TEV_ADD;
+        u8 alpha_bias = GX_TB_ZERO;
+        u8 alpha_scale = GX_CS_SCALE_1;
+        u8 alpha_clamp = GX_TRUE;
+        u8 alpha_reg = GX_TEVPREV;
+        u8 kcolor_sel = GX_TEV_KCSEL_1;
+        u8 kalpha_sel = GX_TEV_KASEL_1;
+        u8 ind_stage = GX_INDTEXSTAGE0;
+        u8 ind_format = GX_ITF_8;
+        u8 ind_bias = GX_ITB_NONE;
+        u8 ind_mtx = GX_ITM_OFF;
+        u8 ind_wrap_s = GX_ITW_OFF;
+        u8 ind_wrap_t = GX_ITW_OFF;
+    };
+
+    struct IndStage
+    {
+        u8 texcoord = GX_TEXCOORD0;
+        u8 texmap = GX_TEXMAP0;
+        u8 scale_s = GX_ITS_1;
+        u8 scale_t = GX_ITS_1;
+    };
+
+    struct TexGen
+    {
+        u32 type = GX_TG_MTX2x4;
+        u32 src = GX_TG_TEX0;
+        u32 mtx = GX_IDENTITY;
+    };
+
+    // TEV registers are wider than 8 bits and may go out of range when not clamped
+    struct TevColor
+    {
+        int c[4];
+    };
+
+    struct State
+    {
+        u8 vtx_desc[GX_VA_MAXATTR] = {};
+        AttrFormat formats[GX_MAXVTXFMT][GX_VA_MAXATTR];
+        AttrArray arrays[GX_VA_MAXATTR];
+
+        Mtx pos_mtx[10];
+        Mtx tex_mtx[10];
+        u32 current_mtx = GX_PNMTX0;
+        Mtx44 proj;
+
+        float viewport[6] = {0, 0, 640, 480, 0, 1};
+        int scissor[4] = {0, 0, 640, 480};
+
+        u8 chan_matsrc[2] = {GX_SRC_VTX, GX_SRC_VTX};
+        GXColor chan_mat[2] = {{255, 255, 255, 255}, {255, 255, 255, 255}};
+        u8 num_texgens = 1;
+        TexGen texgens[GX_MAXCOORD];
+        u8 num_stages = 1;
+        TevStage stages[GX_MAX_TEVSTAGE];
+        u8 num_ind_stages = 0;
+        IndStage ind_stages[GX_MAX_INDTEXSTAGE];
+        float ind_mtx[3][2][3] = {};
+        TevColor tev_regs[4] = {};
+        GXColor kcolors[4] = {};
+        GXTexObj textures[GX_MAX_TEXMAP] = {};
+        bool texture_loaded[GX_MAX_TEXMAP] = {};
+
+        u8 alpha_comp[2] = {GX_ALWAYS, GX_ALWAYS};
+        u8 alpha_ref[2] = {0, 0};
+        u8 alpha_op = GX_AOP_AND;
+        u8 blend_type = GX_BM_NONE;
+        u8 blend_src = GX_BL_ONE;
+        u8 blend_dst = GX_BL_ZERO;
+        u8 blend_logic = GX_LO_COPY;
+        bool z_enable = true;
+        u8 z_func = GX_LEQUAL;
+        bool z_update = true;
+        u8 cull = GX_CULL_BACK;
+        bool color_update = true;
+        bool alpha_update = true;
+
+        u16 copy_src[4] = {0, 0, 640, 480};
+        GXColor clear_color = {0, 0, 0, 255};
+        float clear_z = 1.0f;
+    };
+
+    struct ClipVertex
+    {
+        float pos[4];
+        float varyings[MAX_VARYINGS];
+    };
+
+    struct ScreenVertex
+    {
+        float x, y, z;
+        float inv_w;
+        float varyings[MAX_VARYINGS]; // Divided by w for perspective correct interpolation
+    };
+
+    static State state;
+    static std::vector<u8> efb_color(EFB_WIDTH * EFB_HEIGHT * 4);
+    static std::vector<float> efb_depth(EFB_WIDTH * EFB_HEIGHT, 1.0f);
+    static std::vector<u8> frame;
+    static u32 frame_width = 0;
+    static u32 frame_height = 0;
+    static RasterStats raster_stats;
+
+    // Immediate mode primitive being written through wgPipe
+    static std::vector<u8> pending;
+
+    // Display list being recorded by GX_BeginDispList. Primitives go there instead of being drawn.
+    static u8 *record_buffer = nullptr;
+    static u32 record_capacity = 0;
+    static u32 record_size = 0;
+    static bool record_overflow = false;
+
+    static void warn_once(bool &warned, const char *message, u32 value)
+    {
+        if (warned)
+            return;
+        warned = true;
+        std::fprintf(stderr, message, value);
+    }
+
+    const RasterStats &get_raster_stats()
+    {
+        return raster_stats;
+    }
+
+    void reset_raster_stats()
+    {
+        raster_stats = RasterStats();
+    }
+
+    const uint8_t *get_frame(uint32_t &width, uint32_t &height)
+    {
+        width = frame_width;
+        height = frame_height;
+        return frame.data();
+    }
+
+    bool save_png(const std::string &filename)
+    {
+        if (frame.empty())
+            return false;
+        size_t png_size = 0;
+        void *png = tdefl_write_image_to_png_file_in_memory_ex(frame.data(), frame_width, frame_height, 4, &png_size, 6, MZ_FALSE);
+        if (!png)
+            return false;
+        FILE *file = std::fopen(filename.c_str(), "wb");
+        bool written = file && std::fwrite(png, 1, png_size, file) == png_size;
+        if (file)
+            written &= std::fclose(file) == 0;
+        mz_free(png);
+        return written;
+    }
+
+    void pipe_write(const void *data, u32 size)
+    {
+        const u8 *bytes = static_cast<const u8 *>(data);
+        if (record_buffer)
+        {
+            if (record_size + size > record_capacity)
+            {
+                record_overflow = true;
+                return;
+            }
+            std::memcpy(record_buffer + record_size, bytes, size);
+            record_size += size;
+            return;
+        }
+        pending.insert(pending.end(), bytes, bytes + size);
+    }
+
+    static u32 component_size(u8 type)
+    {
+        switch (type)
+        {
+        case GX_U8:
+        case GX_S8:
+            return 1;
+        case GX_U16:
+        case GX_S16:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    // The list was written by the host, so its values are in host byte order
+    static float read_component(const u8 *data, u8 type, u8 frac)
+    {
+        float scale = 1.0f / float(1 << frac);
+        switch (type)
+        {
+        case GX_U8:
+            return data[0] * scale;
+        case GX_S8:
+            return int8_t(data[0]) * scale;
+        case GX_U16:
+        {
+            u16 value;
+            std::memcpy(&value, data, 2);
+            return value * scale;
+        }
+        case GX_S16:
+        {
+            s16 value;
+            std::memcpy(&value, data, 2);
+            return value * scale;
+        }
+        default:
+        {
+            f32 value;
+            std::memcpy(&value, data, 4);
+            return value;
+        }
+        }
+    }
+
+    static void read_color(const u8 *data, u8 type, float *out)
+    {
+        switch (type)
+        {
+        case GX_RGB565:
+        {
+            u16 value;
+            std::memcpy(&value, data, 2);
+            out[0] = ((value >> 11) & 31) * 255 / 31;
+            out[1] = ((value >> 5) & 63) * 255 / 63;
+            out[2] = (value & 31) * 255 / 31;
+            out[3] = 255;
+            break;
+        }
+        case GX_RGBA4:
+        {
+            u16 value;
+            std::memcpy(&value, data, 2);
+            for (int i = 0; i < 4; i++)
+                out[i] = ((value >> (12 - i * 4)) & 15) * 17;
+            break;
+        }
+        case GX_RGBA6:
+        {
+            u32 value = (data[0] << 16) | (data[1] << 8) | data[2];
+            for (int i = 0; i < 4; i++)
+                out[i] = ((value >> (18 - i * 6)) & 63) * 255 / 63;
+            break;
+        }
+        case GX_RGB8:
+        case GX_RGBX8:
+            out[0] = data[0];
+            out[1] = data[1];
+            out[2] = data[2];
+            out[3] = 255;
+            break;
+        default:
+            for (int i = 0; i < 4; i++)
+                out[i] = data[i];
+            break;
+        }
+    }
+
+    // Size of an attribute sent directly in the vertex data
+    static u32 direct_size(int attr, const AttrFormat &format)
+    {
+        if (attr <= GX_VA_TEX7MTXIDX)
+            return 1;
+        switch (attr)
+        {
+        case GX_VA_POS:
+            return (format.count == GX_POS_XY ? 2 : 3) * component_size(format.type);
+        case GX_VA_NRM:
+            return (format.count == GX_NRM_XYZ ? 3 : 9) * component_size(format.type);
+        case GX_VA_CLR0:
+        case GX_VA_CLR1:
+            switch (format.type)
+            {
+            case GX_RGB565:
+            case GX_RGBA4:
+                return 2;
+            case GX_RGB8:
+            case GX_RGBA6:
+                return 3;
+            default:
+                return 4;
+            }
+        default:
+            return (format.count == GX_TEX_S ? 1 : 2) * component_size(format.type);
+        }
+    }
+
+    static u32 attr_size(int attr, const AttrFormat &format)
+    {
+        u32 indices = (attr == GX_VA_NRM && format.count == GX_NRM_NBT3) ? 3 : 1;
+        switch (state.vtx_desc[attr])
+        {
+        case GX_DIRECT:
+            return direct_size(attr, format);
+        case GX_INDEX8:
+            return indices;
+        case GX_INDEX16:
+            return indices * 2;
+        default:
+            return 0;
+        }
+    }
+
+    static u32 vertex_size(u8 vtxfmt)
+    {
+        u32 size = 0;
+        for (int attr = 0; attr < GX_VA_MAXATTR; attr++)
+            size += attr_size(attr, state.formats[vtxfmt][attr]);
+        return size;
+    }
+
+    // Returns the data of an attribute, following the index into its array if it is indexed.
+    static const u8 *attr_data(int attr, const u8 *data)
+    {
+        const AttrArray &array = state.arrays[attr];
+        switch (state.vtx_desc[attr])
+        {
+        case GX_INDEX8:
+            return array.data ? array.data + data[0] * array.stride : nullptr;
+        case GX_INDEX16:
+        {
+            u16 index;
+            std::memcpy(&index, data, 2);
+            return array.data ? array.data + index * array.stride : nullptr;
+        }
+        default:
+            return data;
+        }
+    }
+
+    static void mtx_multiply(const Mtx mt, const float *in, float *out)
+    {
+        for (int i = 0; i < 3; i++)
+            out[i] = mt[i][0] * in[0] + mt[i][1] * in[1] + mt[i][2] * in[2] + mt[i][3];
+    }
+
+    // Decodes a vertex and transforms it to clip space. Returns the data after the vertex.
+    static const u8 *decode_vertex(u8 vtxfmt, const u8 *data, ClipVertex &out)
+    {
+        const AttrFormat *formats = state.formats[vtxfmt];
+        u32 pos_mtx = state.current_mtx;
+        float position[3] = {0, 0, 0};
+        float colors[2][4];
+        bool has_color[2] = {false, false};
+        float tex[GX_MAXCOORD][2] = {};
+
+        for (int attr = 0; attr < GX_VA_MAXATTR; attr++)
+        {
+            if (!state.vtx_desc[attr])
+                continue;
+            const AttrFormat &format = formats[attr];
+            const u8 *value = attr_data(attr, data);
+            data += attr_size(attr, format);
+            if (!value)
+                continue;
+
+            if (attr == GX_VA_PTNMTXIDX)
+            {
+                pos_mtx = value[0];
+            }
+            else if (attr == GX_VA_POS)
+            {
+                int count = format.count == GX_POS_XY ? 2 : 3;
+                for (int i = 0; i < count; i++)
+                    position[i] = read_component(value + i * component_size(format.type), format.type, format.frac);
+            }
+            else if (attr == GX_VA_CLR0 || attr == GX_VA_CLR1)
+            {
+                int channel = attr - GX_VA_CLR0;
+                read_color(value, format.type, colors[channel]);
+                if (format.count == GX_CLR_RGB)
+                    colors[channel][3] = 255;
+                has_color[channel] = true;
+            }
+            else if (attr >= GX_VA_TEX0 && attr <= GX_VA_TEX7)
+            {
+                int count = format.count == GX_TEX_S ? 1 : 2;
+                for (int i = 0; i < count; i++)
+                    tex[attr - GX_VA_TEX0][i] = read_component(value + i * component_size(format.type), format.type, format.frac);
+            }
+            // Normals and texture matrix indices do not affect the output
+        }
+
+        float eye[3];
+        mtx_multiply(state.pos_mtx[(pos_mtx / 3) % 10], position, eye);
+        for (int i = 0; i < 4; i++)
+            out.pos[i] = state.proj[i][0] * eye[0] + state.proj[i][1] * eye[1] + state.proj[i][2] * eye[2] + state.proj[i][3];
+
+        // Lighting is not emulated, so the channels take the vertex or material colour
+        for (int channel = 0; channel < 2; channel++)
+        {
+            const GXColor &mat = state.chan_mat[channel];
+            bool vertex = state.chan_matsrc[channel] == GX_SRC_VTX && has_color[channel];
+            for (int i = 0; i < 4; i++)
+                out.varyings[channel * 4 + i] = vertex ? colors[channel][i] : (&mat.r)[i];
+        }
+
+        for (int i = 0; i < state.num_texgens; i++)
+        {
+            const TexGen &texgen = state.texgens[i];
+            float src[3] = {0, 0, 1};
+            if (texgen.src >= GX_TG_TEX0 && texgen.src <= GX_TG_TEX7)
+            {
+                src[0] = tex[texgen.src - GX_TG_TEX0][0];
+                src[1] = tex[texgen.src - GX_TG_TEX0][1];
+            }
+            else if (texgen.src == GX_TG_POS)
+            {
+                std::memcpy(src, position, sizeof(src));
+            }
+
+            float s = src[0];
+            float t = src[1];
+            if (texgen.mtx != GX_IDENTITY)
+            {
+                float result[3];
+                mtx_multiply(state.tex_mtx[((texgen.mtx - GX_TEXMTX0) / 3) % 10], src, result);
+                s = result[0];
+                t = result[1];
+                if (texgen.type == GX_TG_MTX3x4 && result[2] != 0.0f)
+                {
+                    s /= result[2];
+                    t /= result[2];
+                }
+            }
+            out.varyings[8 + i * 2] = s;
+            out.varyings[9 + i * 2] = t;
+        }
+        return data;
+    }
+
+    static int wrap(int coord, int size, u8 mode)
+    {
+        switch (mode)
+        {
+        case GX_CLAMP:
+            return std::clamp(coord, 0, size - 1);
+        case GX_MIRROR:
+        {
+            int period = coord % (size * 2);
+            if (period < 0)
+                period += size * 2;
+            return period < size ? period : size * 2 - 1 - period;
+        }
+        default:
+        {
+            int repeat = coord % size;
+            return repeat < 0 ? repeat + size : repeat;
+        }
+        }
+    }
+
+    // Reads a texel from a texture in the GX tile layout. The texture data is in the hardware byte order.
+    static void fetch_texel(const GXTexObj &texture, int x, int y, int *out)
+    {
+        const u8 *data = static_cast<const u8 *>(texture.data);
+        int width = texture.width;
+        switch (texture.format)
+        {
+        case GX_TF_RGBA8:
+        {
+            const u8 *block = data + ((y >> 2) * ((width + 3) >> 2) + (x >> 2)) * 64;
+            int i = ((y & 3) * 4 + (x & 3)) * 2;
+            out[0] = block[i + 1];
+            out[1] = block[32 + i];
+            out[2] = block[32 + i + 1];
+            out[3] = block[i];
+            break;
+        }
+        case GX_TF_RGB565:
+        case GX_TF_RGB5A3:
+        case GX_TF_IA8:
+        {
+            const u8 *block = data + ((y >> 2) * ((width + 3) >> 2) + (x >> 2)) * 32;
+            int i = ((y & 3) * 4 + (x & 3)) * 2;
+            u16 value = (block[i] << 8) | block[i + 1];
+            if (texture.format == GX_TF_IA8)
+            {
+                out[0] = out[1] = out[2] = value & 0xFF;
+                out[3] = value >> 8;
+            }
+            else if (texture.format == GX_TF_RGB565)
+            {
+                out[0] = ((value >> 11) & 31) * 255 / 31;
+                out[1] = ((value >> 5) & 63) * 255 / 63;
+                out[2] = (value & 31) * 255 / 31;
+                out[3] = 255;
+            }
+            else if (value & 0x8000)
+            {
+                out[0] = ((value >> 10) & 31) * 255 / 31;
+                out[1] = ((value >> 5) & 31) * 255 / 31;
+                out[2] = (value & 31) * 255 / 31;
+                out[3] = 255;
+            }
+            else
+            {
+                out[0] = ((value >> 8) & 15) * 17;
+                out[1] = ((value >> 4) & 15) * 17;
+                out[2] = (value & 15) * 17;
+                out[3] = ((value >> 12) & 7) * 255 / 7;
+            }
+            break;
+        }
+        case GX_TF_I8:
+        case GX_TF_IA4:
+        {
+            const u8 *block = data + ((y >> 2) * ((width + 7) >> 3) + (x >> 3)) * 32;
+            u8 value = block[(y & 3) * 8 + (x & 7)];
+            if (texture.format == GX_TF_I8)
+            {
+                out[0] = out[1] = out[2] = out[3] = value;
+            }
+            else
+            {
+                out[0] = out[1] = out[2] = (value & 15) * 17;
+                out[3] = (value >> 4) * 17;
+            }
+            break;
+        }
+        case GX_TF_I4:
+        {
+            const u8 *block = data + ((y >> 3) * ((width + 7) >> 3) + (x >> 3)) * 32;
+            u8 value = block[(y & 7) * 4 + ((x & 7) >> 1)];
+            value = (x & 1) ? (value & 15) : (value >> 4);
+            out[0] = out[1] = out[2] = out[3] = value * 17;
+            break;
+        }
+        default:
+            out[0] = out[1] = out[2] = out[3] = 255;
+            break;
+        }
+    }
+
+    static void sample_texture(const GXTexObj &texture, float s, float t, int *out)
+    {
+        if (!texture.data || !texture.width || !texture.height)
+        {
+            out[0] = out[1] = out[2] = out[3] = 255;
+            return;
+        }
+        int x = wrap(int(std::floor(s * texture.width)), texture.width, texture.wrap_s);
+        int y = wrap(int(std::floor(t * texture.height)), texture.height, texture.wrap_t);
+        fetch_texel(texture, x, y, out);
+    }
+
+    // Texture coordinates are scaled to texels by the texture of the first TEV stage that reads them
+    static void texcoord_scale(u8 texcoord, float *scale)
+    {
+        scale[0] = scale[1] = 1.0f;
+        for (int i = 0; i < state.num_stages; i++)
+        {
+            const TevStage &stage = state.stages[i];
+            if (stage.texcoord == texcoord && stage.texmap < GX_MAX_TEXMAP && state.texture_loaded[stage.texmap])
+            {
+                scale[0] = state.textures[stage.texmap].width;
+                scale[1] = state.textures[stage.texmap].height;
+                return;
+            }
+        }
+    }
+
+    // Samples the texture of a TEV stage, after wrapping and offsetting its coordinates by the indirect stage
+    static void sample_stage(const TevStage &stage, const float *varyings, int *out)
+    {
+        const GXTexObj &texture = state.textures[stage.texmap];
+        float s = varyings[8 + stage.texcoord * 2];
+        float t = varyings[9 + stage.texcoord * 2];
+        if ((stage.ind_mtx == GX_ITM_OFF && stage.ind_wrap_s == GX_ITW_OFF && stage.ind_wrap_t == GX_ITW_OFF) || !texture.data || !texture.width || !texture.height)
+        {
+            sample_texture(texture, s, t, out);
+            return;
+        }
+
+        // The indirect stage works in texels of the texture
+        static const float wrap_sizes[7] = {0, 256, 128, 64, 32, 16, 0};
+        float coord[2] = {s * texture.width, t * texture.height};
+        const u8 wraps[2] = {stage.ind_wrap_s, stage.ind_wrap_t};
+        for (int i = 0; i < 2; i++)
+        {
+            if (wraps[i] == GX_ITW_0)
+                coord[i] = 0.0f;
+            else if (wraps[i] != GX_ITW_OFF && wraps[i] < GX_ITW_0)
+                coord[i] -= std::floor(coord[i] / wrap_sizes[wraps[i]]) * wrap_sizes[wraps[i]];
+        }
+
+        if (stage.ind_stage < state.num_ind_stages && stage.ind_mtx >= GX_ITM_0 && stage.ind_mtx <= GX_ITM_2)
+        {
+            const IndStage &ind = state.ind_stages[stage.ind_stage];
+            int ind_tex[4] = {0, 0, 0, 0};
+            if (ind.texmap < GX_MAX_TEXMAP && ind.texcoord < state.num_texgens && state.texture_loaded[ind.texmap])
+            {
+                const GXTexObj &map = state.textures[ind.texmap];
+                float scale[2];
+                texcoord_scale(ind.texcoord, scale);
+                int x = int(std::floor(varyings[8 + ind.texcoord * 2] * scale[0])) >> ind.scale_s;
+                int y = int(std::floor(varyings[9 + ind.texcoord * 2] * scale[1])) >> ind.scale_t;
+                if (map.data && map.width && map.height)
+                    fetch_texel(map, wrap(x, map.width, map.wrap_s), wrap(y, map.height, map.wrap_t), ind_tex);
+            }
+
+            // The offsets are read from alpha, blue and green, keeping the low bits of the format
+            static const int format_masks[4] = {0xFF, 0x1F, 0x0F, 0x07};
+            int mask = format_masks[stage.ind_format & 3];
+            int values[3] = {ind_tex[3] & mask, ind_tex[2] & mask, ind_tex[1] & mask};
+            for (int i = 0; i < 3; i++)
+                if (stage.ind_bias & (1 << i))
+                    values[i] += stage.ind_format == GX_ITF_8 ? -128 : 1;
+
+            const float (&mtx)[2][3] = state.ind_mtx[stage.ind_mtx - GX_ITM_0];
+            for (int i = 0; i < 2; i++)
+                coord[i] += mtx[i][0] * values[0] + mtx[i][1] * values[1] + mtx[i][2] * values[2];
+        }
+
+        int x = wrap(int(std::floor(coord[0])), texture.width, texture.wrap_s);
+        int y = wrap(int(std::floor(coord[1])), texture.height, texture.wrap_t);
+        fetch_texel(texture, x, y, out);
+    }
+
+    static int konst_fraction(u8 sel)
+    {
+        static const int fractions[8] = {255, 223, 191, 159, 128, 96, 64, 32};
+        return fractions[sel & 7];
+    }
+
+    static int konst_color(u8 sel, int component)
+    {
+        if (sel < 8)
+            return konst_fraction(sel);
+        if (sel >= GX_TEV_KCSEL_K0 && sel <= GX_TEV_KCSEL_K3)
+            return (&state.kcolors[sel - GX_TEV_KCSEL_K0].r)[component];
+        if (sel >= GX_TEV_KCSEL_K0_R)
+            return (&state.kcolors[(sel - GX_TEV_KCSEL_K0_R) & 3].r)[(sel - GX_TEV_KCSEL_K0_R) >> 2];
+        return 0;
+    }
+
+    static int konst_alpha(u8 sel)
+    {
+        if (sel < 8)
+            return konst_fraction(sel);
+        if (sel >= GX_TEV_KASEL_K0_R)
+            return (&state.kcolors[(sel - GX_TEV_KASEL_K0_R) & 3].r)[(sel - GX_TEV_KASEL_K0_R) >> 2];
+        return 0;
+    }
+
+    static int color_input(u8 input, int component, const TevColor *regs, const int *tex, const int *ras, int konst)
+    {
+        switch (input)
+        {
+        case GX_CC_CPREV:
+        case GX_CC_C0:
+        case GX_CC_C1:
+        case GX_CC_C2:
+            return regs[input >> 1].c[component];
+        case GX_CC_APREV:
+        case GX_CC_A0:
+        case GX_CC_A1:
+        case GX_CC_A2:
+            return regs[input >> 1].c[3];
+        case GX_CC_TEXC:
+            return tex[component];
+        case GX_CC_TEXA:
+            return tex[3];
+        case GX_CC_RASC:
+            return ras[component];
+        case GX_CC_RASA:
+            return ras[3];
+        case GX_CC_ONE:
+            return 255;
+        case GX_CC_HALF:
+            return 128;
+        case GX_CC_KONST:
+            return konst;
+        default:
+            return 0;
+        }
+    }
+
+    static int alpha_input(u8 input, const TevColor *regs, const int *tex, const int *ras, int konst)
+    {
+        switch (input)
+        {
+        case GX_CA_APREV:
+        case GX_CA_A0:
+        case GX_CA_A1:
+        case GX_CA_A2:
+            return regs[input].c[3];
+        case GX_CA_TEXA:
+            return tex[3];
+        case GX_CA_RASA:
+            return ras[3];
+        case GX_CA_KONST:
+            return konst;
+        default:
+            return 0;
+        }
+    }
+
+    // One TEV operation: d + lerp(a, b, c) with the bias, scale and clamp of the stage
+    static int tev_combine(int a, int b, int c, int d, u8 op, u8 bias, u8 scale, u8 clamp)
+    {
+        a = std::clamp(a, 0, 255);
+        b = std::clamp(b, 0, 255);
+        c = std::clamp(c, 0, 255);
+        c += c >> 7;
+        int lerp = (a * (256 - c) + b * c) >> 8;
+        int value = op == GX_TEV_SUB ? d - lerp : d + lerp;
+        if (bias == GX_TB_ADDHALF)
+            value += 128;
+        else if (bias == GX_TB_SUBHALF)
+            value -= 128;
+        switch (scale)
+        {
+        case GX_CS_SCALE_2:
+            value *= 2;
+            break;
+        case GX_CS_SCALE_4:
+            value *= 4;
+            break;
+        case GX_CS_DIVIDE_2:
+            value /= 2;
+            break;
+        default:
+            break;
+        }
+        return clamp ? std::clamp(value, 0, 255) : std::clamp(value, -1024, 1023);
+    }
+
+    static void run_tev(const float *varyings, int *out)
+    {
+        TevColor regs[4];
+        std::memcpy(regs, state.tev_regs, sizeof(regs));
+
+        int ras[2][4];
+        for (int i = 0; i < 8; i++)
+            ras[i >> 2][i & 3] = std::clamp(int(varyings[i] + 0.5f), 0, 255);
+        static const int zero[4] = {0, 0, 0, 0};
+
+        u8 color_reg = GX_TEVPREV;
+        u8 alpha_reg = GX_TEVPREV;
+        for (int i = 0; i < state.num_stages; i++)
+        {
+            const TevStage &stage = state.stages[i];
+
+            int tex[4] = {255, 255, 255, 255};
+            if (stage.texmap < GX_MAX_TEXMAP && stage.texcoord < state.num_texgens && state.texture_loaded[stage.texmap])
+                sample_stage(stage, varyings, tex);
+
+            const int *stage_ras = zero;
+            if (stage.channel == GX_COLOR0 || stage.channel == GX_ALPHA0 || stage.channel == GX_COLOR0A0)
+                stage_ras = ras[0];
+            else if (stage.channel == GX_COLOR1 || stage.channel == GX_ALPHA1 || stage.channel == GX_COLOR1A1)
+                stage_ras = ras[1];
+
+            int result[4];
+            for (int c = 0; c < 3; c++)
+            {
+                int konst = konst_color(stage.kcolor_sel, c);
+                int in[4];
+                for (int j = 0; j < 4; j++)
+                    in[j] = color_input(stage.color_in[j], c, regs, tex, stage_ras, konst);
+                result[c] = tev_combine(in[0], in[1], in[2], in[3], stage.color_op, stage.color_bias, stage.color_scale, stage.color_clamp);
+            }
+            int konst = konst_alpha(stage.kalpha_sel);
+            int in[4];
+            for (int j = 0; j < 4; j++)
+                in[j] = alpha_input(stage.alpha_in[j], regs, tex, stage_ras, konst);
+            result[3] = tev_combine(in[0], in[1], in[2], in[3], stage.alpha_op, stage.alpha_bias, stage.alpha_scale, stage.alpha_clamp);
+
+            color_reg = stage.color_reg & 3;
+            alpha_reg = stage.alpha_reg & 3;
+            for (int c = 0; c < 3; c++)
+                regs[color_reg].c[c] = result[c];
+            regs[alpha_reg].c[3] = result[3];
+        }
+
+        for (int c = 0; c < 3; c++)
+            out[c] = std::clamp(regs[color_reg].c[c], 0, 255);
+        out[3] = std::clamp(regs[alpha_reg].c[3], 0, 255);
+    }
+
+    static bool compare(u8 func, float a, float b)
+    {
+        switch (func)
+        {
+        case GX_NEVER:
+            return false;
+        case GX_LESS:
+            return a < b;
+        case GX_EQUAL:
+            return a == b;
+        case GX_LEQUAL:
+            return a <= b;
+        case GX_GREATER:
+            return a > b;
+        case GX_NEQUAL:
+            return a != b;
+        case GX_GEQUAL:
+            return a >= b;
+        default:
+            return true;
+        }
+    }
+
+    static bool alpha_test(int alpha)
+    {
+        bool first = compare(state.alpha_comp[0], alpha, state.alpha_ref[0]);
+        bool second = compare(state.alpha_comp[1], alpha, state.alpha_ref[1]);
+        switch (state.alpha_op)
+        {
+        case GX_AOP_OR:
+            return first || second;
+        case GX_AOP_XOR:
+            return first != second;
+        case GX_AOP_XNOR:
+            return first == second;
+        default:
+            return first && second;
+        }
+    }
+
+    static int blend_factor(u8 factor, bool source, int component, const int *src, const u8 *dst)
+    {
+        switch (factor)
+        {
+        case GX_BL_ZERO:
+            return 0;
+        case GX_BL_ONE:
+            return 255;
+        case GX_BL_SRCCLR: // Destination colour when used as the source factor
+            return source ? dst[component] : src[component];
+        case GX_BL_INVSRCCLR:
+            return 255 - (source ? dst[component] : src[component]);
+        case GX_BL_SRCALPHA:
+            return src[3];
+        case GX_BL_INVSRCALPHA:
+            return 255 - src[3];
+        case GX_BL_DSTALPHA:
+            return dst[3];
+        default:
+            return 255 - dst[3];
+        }
+    }
+
+    static int logic_op(u8 op, int src, int dst)
+    {
+        switch (op)
+        {
+        case GX_LO_CLEAR:
+            return 0;
+        case GX_LO_AND:
+            return src & dst;
+        case GX_LO_REVAND:
+            return src & ~dst;
+        case GX_LO_INVAND:
+            return ~src & dst;
+        case GX_LO_NOOP:
+            return dst;
+        case GX_LO_XOR:
+            return src ^ dst;
+        case GX_LO_OR:
+            return src | dst;
+        case GX_LO_NOR:
+            return ~(src | dst);
+        case GX_LO_EQUIV:
+            return ~(src ^ dst);
+        case GX_LO_INV:
+            return ~dst;
+        case GX_LO_REVOR:
+            return src | ~dst;
+        case GX_LO_INVCOPY:
+            return ~src;
+        case GX_LO_INVOR:
+            return ~src | dst;
+        case GX_LO_NAND:
+            return ~(src & dst);
+        case GX_LO_SET:
+            return 0xFF;
+        default:
+            return src;
+        }
+    }
+
+    static void write_pixel(u8 *dst, const int *src)
+    {
+        int out[4];
+        for (int c = 0; c < 4; c++)
+        {
+            switch (state.blend_type)
+            {
+            case GX_BM_BLEND:
+            {
+                int sf = blend_factor(state.blend_src, true, c, src, dst);
+                int df = blend_factor(state.blend_dst, false, c, src, dst);
+                out[c] = std::min(255, (src[c] * sf + dst[c] * df) / 255);
+                break;
+            }
+            case GX_BM_SUBTRACT:
+                out[c] = std::max(0, dst[c] - src[c]);
+                break;
+            case GX_BM_LOGIC:
+                out[c] = logic_op(state.blend_logic, src[c], dst[c]) & 0xFF;
+                break;
+            default:
+                out[c] = src[c];
+                break;
+            }
+        }
+        if (state.color_update)
+        {
+            dst[0] = out[0];
+            dst[1] = out[1];
+            dst[2] = out[2];
+        }
+        if (state.alpha_update)
+            dst[3] = out[3];
+    }
+
+    static void rasterize(const ScreenVertex &a, const ScreenVertex &b, const ScreenVertex &c, int varying_count)
+    {
+        float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+        if (area == 0.0f)
+            return;
+        const ScreenVertex *v[3] = {&a, &b, &c};
+        if (area < 0)
+        {
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        int min_x = std::max({int(std::floor(std::min({a.x, b.x, c.x}))), state.scissor[0], 0});
+        int max_x = std::min({int(std::ceil(std::max({a.x, b.x, c.x}))), state.scissor[0] + state.scissor[2], EFB_WIDTH});
+        int min_y = std::max({int(std::floor(std::min({a.y, b.y, c.y}))), state.scissor[1], 0});
+        int max_y = std::min({int(std::ceil(std::max({a.y, b.y, c.y}))), state.scissor[1] + state.scissor[3], EFB_HEIGHT});
+
+        // Top-left fill rule, so that pixels on shared edges are only drawn once
+        bool top_left[3];
+        for (int i = 0; i < 3; i++)
+        {
+            const ScreenVertex &from = *v[(i + 1) % 3];
+            const ScreenVertex &to = *v[(i + 2) % 3];
+            float dy = to.y - from.y;
+            top_left[i] = dy < 0 || (dy == 0 && to.x > from.x);
+        }
+
+        float inv_area = 1.0f / area;
+        for (int y = min_y; y < max_y; y++)
+        {
+            float py = y + 0.5f;
+            for (int x = min_x; x < max_x; x++)
+            {
+                float px = x + 0.5f;
+                float weights[3];
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; i++)
+                {
+                    const ScreenVertex &from = *v[(i + 1) % 3];
+                    const ScreenVertex &to = *v[(i + 2) % 3];
+                    weights[i] = (to.x - from.x) * (py - from.y) - (to.y - from.y) * (px - from.x);
+                    inside = weights[i] > 0 || (weights[i] == 0 && top_left[i]);
+                }
+                if (!inside)
+                    continue;
+                for (float &weight : weights)
+                    weight *= inv_area;
+
+                int index = y * EFB_WIDTH + x;
+                float z = weights[0] * v[0]->z + weights[1] * v[1]->z + weights[2] * v[2]->z;
+                if (state.z_enable && !compare(state.z_func, z, efb_depth[index]))
+                    continue;
+
+                float inv_w = weights[0] * v[0]->inv_w + weights[1] * v[1]->inv_w + weights[2] * v[2]->inv_w;
+                float varyings[MAX_VARYINGS];
+                for (int i = 0; i < varying_count; i++)
+                    varyings[i] = (weights[0] * v[0]->varyings[i] + weights[1] * v[1]->varyings[i] + weights[2] * v[2]->varyings[i]) / inv_w;
+
+                int color[4];
+                run_tev(varyings, color);
+                if (!alpha_test(color[3]))
+                    continue;
+                write_pixel(&efb_color[index * 4], color);
+                if (state.z_enable && state.z_update)
+                    efb_depth[index] = z;
+                raster_stats.pixels++;
+            }
+        }
+    }
+
+    // Distance of a vertex to one of the clip planes, positive on the visible side.
+    // The visible depth of GX clip space is -w to 0.
+    static float plane_distance(const float *pos, int plane)
+    {
+        switch (plane)
+        {
+        case 0:
+            return pos[3] + pos[0];
+        case 1:
+            return pos[3] - pos[0];
+        case 2:
+            return pos[3] + pos[1];
+        case 3:
+            return pos[3] - pos[1];
+        case 4:
+            return pos[3] + pos[2];
+        default:
+            return -pos[2];
+        }
+    }
+
+    static void draw_triangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c)
+    {
+        raster_stats.triangles++;
+        int varying_count = 8 + state.num_texgens * 2;
+
+        // Clip against every plane so that the rasteriser only sees finite screen coordinates
+        ClipVertex buffers[2][9];
+        ClipVertex *polygon = buffers[0];
+        ClipVertex *clipped = buffers[1];
+        polygon[0] = a;
+        polygon[1] = b;
+        polygon[2] = c;
+        int count = 3;
+        for (int plane = 0; plane < 6 && count >= 3; plane++)
+        {
+            int clipped_count = 0;
+            for (int i = 0; i < count; i++)
+            {
+                const ClipVertex &from = polygon[i];
+                const ClipVertex &to = polygon[(i + 1) % count];
+                float from_distance = plane_distance(from.pos, plane);
+                float to_distance = plane_distance(to.pos, plane);
+                if (from_distance >= 0)
+                    clipped[clipped_count++] = from;
+                if ((from_distance >= 0) != (to_distance >= 0))
+                {
+                    float t = from_distance / (from_distance - to_distance);
+                    ClipVertex &vertex = clipped[clipped_count++];
+                    for (int j = 0; j < 4; j++)
+                        vertex.pos[j] = from.pos[j] + (to.pos[j] - from.pos[j]) * t;
+                    for (int j = 0; j < varying_count; j++)
+                        vertex.varyings[j] = from.varyings[j] + (to.varyings[j] - from.varyings[j]) * t;
+                }
+            }
+            std::swap(polygon, clipped);
+            count = clipped_count;
+        }
+        if (count < 3)
+        {
+            raster_stats.culled++;
+            return;
+        }
+
+        ScreenVertex screen[9];
+        for (int i = 0; i < count; i++)
+        {
+            const float *pos = polygon[i].pos;
+            float w = std::max(pos[3], 1e-6f);
+            ScreenVertex &vertex = screen[i];
+            vertex.inv_w = 1.0f / w;
+            vertex.x = state.viewport[0] + (pos[0] * vertex.inv_w + 1.0f) * 0.5f * state.viewport[2];
+            vertex.y = state.viewport[1] + (1.0f - pos[1] * vertex.inv_w) * 0.5f * state.viewport[3];
+            vertex.z = state.viewport[4] + (pos[2] * vertex.inv_w + 1.0f) * (state.viewport[5] - state.viewport[4]);
+            for (int j = 0; j < varying_count; j++)
+                vertex.varyings[j] = polygon[i].varyings[j] * vertex.inv_w;
+        }
+
+        // Clockwise triangles face the viewer. The screen y grows downwards, so they have a positive area.
+        float area = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const ScreenVertex &from = screen[i];
+            const ScreenVertex &to = screen[(i + 1) % count];
+            area += from.x * to.y - to.x * from.y;
+        }
+        bool front = area > 0;
+        if (area == 0 || state.cull == GX_CULL_ALL || (state.cull == GX_CULL_FRONT && front) || (state.cull == GX_CULL_BACK && !front))
+        {
+            raster_stats.culled++;
+            return;
+        }
+
+        for (int i = 1; i + 1 < count; i++)
+            rasterize(screen[0], screen[i], screen[i + 1], varying_count);
+    }
+
+    static void draw_primitive(u8 primitive, u8 vtxfmt, const u8 *data, u16 count)
+    {
+        static std::vector<ClipVertex> vertices;
+        vertices.resize(count);
+        for (u16 i = 0; i < count; i++)
+            data = decode_vertex(vtxfmt, data, vertices[i]);
+
+        switch (primitive)
+        {
+        case GX_QUADS:
+            for (int i = 0; i + 3 < count; i += 4)
+            {
+                draw_triangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+                draw_triangle(vertices[i], vertices[i + 2], vertices[i + 3]);
+            }
+            break;
+        case GX_TRIANGLES:
+            for (int i = 0; i + 2 < count; i += 3)
+                draw_triangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+            break;
+        case GX_TRIANGLESTRIP:
+            for (int i = 2; i < count; i++)
+            {
+                // Every other triangle of a strip is flipped to keep the winding
+                if (i & 1)
+                    draw_triangle(vertices[i - 1], vertices[i - 2], vertices[i]);
+                else
+                    draw_triangle(vertices[i - 2], vertices[i - 1], vertices[i]);
+            }
+            break;
+        case GX_TRIANGLEFAN:
+            for (int i = 2; i < count; i++)
+                draw_triangle(vertices[0], vertices[i - 1], vertices[i]);
+            break;
+        default:
+        {
+            static bool warned = false;
+            warn_once(warned, "gx_soft: primitive 0x%02x is not drawn\n", primitive);
+            break;
+        }
+        }
+    }
+
+    // Draws the primitives of a display list. Lists hold primitives and GX_NOP padding.
+    static void run_list(const u8 *data, u32 length)
+    {
+        u32 offset = 0;
+        while (offset < length)
+        {
+            u8 command = data[offset];
+            if (command == GX_NOP)
+            {
+                offset++;
+                continue;
+            }
+            if (!(command & 0x80) || offset + 3 > length)
+            {
+                static bool warned = false;
+                warn_once(warned, "gx_soft: unsupported display list command 0x%02x, the rest of the list is skipped\n", command);
+                return;
+            }
+
+            u16 count;
+            std::memcpy(&count, &data[offset + 1], 2);
+            offset += 3;
+            u8 vtxfmt = command & 7;
+            u32 size = vertex_size(vtxfmt);
+            if (u64(count) * size > length - offset)
+            {
+                static bool warned = false;
+                warn_once(warned, "gx_soft: primitive with %u vertices runs past the end of the list\n", count);
+                return;
+            }
+            draw_primitive(command & 0xF8, vtxfmt, data + offset, count);
+            offset += count * size;
+        }
+    }
+
+    static void flush_pending()
+    {
+        if (pending.empty())
+            return;
+        run_list(pending.data(), pending.size());
+        pending.clear();
+    }
+
+    static void clear_efb()
+    {
+        for (int i = 0; i < EFB_WIDTH * EFB_HEIGHT; i++)
+            std::memcpy(&efb_color[i * 4], &state.clear_color, 4);
+        std::fill(efb_depth.begin(), efb_depth.end(), state.clear_z);
+    }
+} // namespace gx_soft
+
+using namespace gx_soft;
+
+static WGPipe pipe_writer;
+WGPipe *const wgPipe = &pipe_writer;
+
+GXFifoObj *GX_Init(void *base, u32 size)
+{
+    static GXFifoObj fifo;
+    state = State();
+    for (Mtx &mtx : state.pos_mtx)
+        guMtxIdentity(mtx);
+    for (Mtx &mtx : state.tex_mtx)
+        guMtxIdentity(mtx);
+    guMtx44Identity(state.proj);
+    for (int i = 0; i < GX_MAX_TEVSTAGE; i++)
+        GX_SetTevOp(i, i ? GX_PASSCLR : GX_REPLACE);
+    pending.clear();
+    clear_efb();
+    return &fifo;
+}
+
+void GX_SetViewport(f32 xOrig, f32 yOrig, f32 wd, f32 ht, f32 nearZ, f32 farZ)
+{
+    flush_pending();
+    const float viewport[6] = {xOrig, yOrig, wd, ht, nearZ, farZ};
+    std::memcpy(state.viewport, viewport, sizeof(viewport));
+}
+
+void GX_SetScissor(u32 xOrigin, u32 yOrigin, u32 wd, u32 ht)
+{
+    flush_pending();
+    state.scissor[0] = xOrigin;
+    state.scissor[1] = yOrigin;
+    state.scissor[2] = wd;
+    state.scissor[3] = ht;
+}
+
+f32 GX_GetYScaleFactor(u16 efbHeight, u16 xfbHeight)
+{
+    return f32(xfbHeight) / f32(efbHeight);
+}
+
+u32 GX_SetDispCopyYScale(f32 yscale)
+{
+    return u32(state.copy_src[3] * yscale + 0.5f);
+}
+
+void GX_SetDispCopySrc(u16 left, u16 top, u16 wd, u16 ht)
+{
+    state.copy_src[0] = left;
+    state.copy_src[1] = top;
+    state.copy_src[2] = std::min<u16>(wd, EFB_WIDTH - left);
+    state.copy_src[3] = std::min<u16>(ht, EFB_HEIGHT - top);
+}
+
+void GX_SetDispCopyDst(u16, u16) {}
+void GX_SetCopyFilter(u8, u8[12][2], u8, u8[7]) {}
+void GX_SetFieldMode(u8, u8) {}
+void GX_SetDispCopyGamma(u8) {}
+void GX_SetPixelFmt(u8, u8) {}
+
+void GX_SetCopyClear(GXColor color, u32 zvalue)
+{
+    state.clear_color = color;
+    state.clear_z = float(zvalue & GX_MAX_Z24) / float(GX_MAX_Z24);
+}
+
+// The frame is kept for gx_soft::get_frame instead of being written to the external framebuffer
+void GX_CopyDisp(void *, u8 clear)
+{
+    flush_pending();
+    frame_width = state.copy_src[2];
+    frame_height = state.copy_src[3];
+    frame.resize(frame_width * frame_height * 4);
+    for (u32 y = 0; y < frame_height; y++)
+        std::memcpy(&frame[y * frame_width * 4], &efb_color[((state.copy_src[1] + y) * EFB_WIDTH + state.copy_src[0]) * 4], frame_width * 4);
+    if (clear)
+        clear_efb();
+}
+
+void GX_SetColorUpdate(u8 enable)
+{
+    flush_pending();
+    state.color_update = enable;
+}
+
+void GX_SetAlphaUpdate(u8 enable)
+{
+    flush_pending();
+    state.alpha_update = enable;
+}
+
+void GX_SetZMode(u8 enable, u8 func, u8 update_enable)
+{
+    flush_pending();
+    state.z_enable = enable;
+    state.z_func = func;
+    state.z_update = update_enable;
+}
+
+void GX_SetZCompLoc(u8) {}
+
+void GX_SetCullMode(u8 mode)
+{
+    flush_pending();
+    state.cull = mode;
+}
+
+void GX_SetLineWidth(u8, u8) {}
+void GX_SetDither(u8) {}
+
+void GX_Flush()
+{
+    flush_pending();
+}
+
+void GX_DrawDone()
+{
+    flush_pending();
+}
+
+void GX_InvalidateTexAll() {}
+void GX_InvVtxCache() {}
+
+void GX_ClearVtxDesc()
+{
+    flush_pending();
+    std::memset(state.vtx_desc, 0, sizeof(state.vtx_desc));
+}
+
+void GX_SetVtxDesc(u8 attr, u8 type)
+{
+    flush_pending();
+    if (attr < GX_VA_MAXATTR)
+        state.vtx_desc[attr] = type;
+}
+
+void GX_SetVtxAttrFmt(u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize, u32 frac)
+{
+    flush_pending();
+    if (vtxfmt >= GX_MAXVTXFMT || vtxattr >= GX_VA_MAXATTR)
+        return;
+    AttrFormat &format = state.formats[vtxfmt][vtxattr];
+    format.count = comptype;
+    format.type = compsize;
+    format.frac = frac;
+}
+
+void GX_SetVtxAttrFmtv(u8 vtxfmt, const GXVtxAttrFmt *attr_list)
+{
+    for (; attr_list->vtxattr != GX_VA_NULL; attr_list++)
+        GX_SetVtxAttrFmt(vtxfmt, attr_list->vtxattr, attr_list->comptype, attr_list->compsize, attr_list->frac);
+}
+
+void GX_SetArray(u32 attr, void *ptr, u8 stride)
+{
+    flush_pending();
+    if (attr >= GX_VA_MAXATTR)
+        return;
+    state.arrays[attr].data = static_cast<const u8 *>(ptr);
+    state.arrays[attr].stride = stride;
+}
+
+void GX_LoadPosMtxImm(const Mtx mt, u32 pnidx)
+{
+    flush_pending();
+    guMtxCopy(mt, state.pos_mtx[(pnidx / 3) % 10]);
+}
+
+void GX_LoadNrmMtxImm(const Mtx, u32) {}
+
+void GX_LoadTexMtxImm(const Mtx mt, u32 texidx, u8)
+{
+    flush_pending();
+    if (texidx >= GX_TEXMTX0 && texidx < GX_IDENTITY)
+        guMtxCopy(mt, state.tex_mtx[(texidx - GX_TEXMTX0) / 3]);
+}
+
+void GX_SetCurrentMtx(u32 mtx)
+{
+    flush_pending();
+    state.current_mtx = mtx;
+}
+
+void GX_LoadProjectionMtx(const Mtx44 mt, u8)
+{
+    flush_pending();
+    guMtx44Copy(mt, state.proj);
+}
+
+void GX_SetNumChans(u8) {}
+
+void GX_SetChanCtrl(s32 channel, u8, u8, u8 matsrc, u8, u8, u8)
+{
+    flush_pending();
+    if (channel == GX_COLOR0 || channel == GX_ALPHA0 || channel == GX_COLOR0A0)
+        state.chan_matsrc[0] = matsrc;
+    else if (channel == GX_COLOR1 || channel == GX_ALPHA1 || channel == GX_COLOR1A1)
+        state.chan_matsrc[1] = matsrc;
+}
+
+void GX_SetChanMatColor(s32 channel, GXColor color)
+{
+    flush_pending();
+    if (channel == GX_COLOR0 || channel == GX_ALPHA0 || channel == GX_COLOR0A0)
+        state.chan_mat[0] = color;
+    else if (channel == GX_COLOR1 || channel == GX_ALPHA1 || channel == GX_COLOR1A1)
+        state.chan_mat[1] = color;
+}
+
+void GX_SetChanAmbColor(s32, GXColor) {}
+
+void GX_SetNumTexGens(u32 nr)
+{
+    flush_pending();
+    state.num_texgens = std::min<u32>(nr, GX_MAXCOORD);
+}
+
+void GX_SetTexCoordGen(u16 texcoord, u32 tgen_typ, u32 tgen_src, u32 mtxsrc)
+{
+    flush_pending();
+    if (texcoord >= GX_MAXCOORD)
+        return;
+    state.texgens[texcoord] = {tgen_typ, tgen_src, mtxsrc};
+}
+
+void GX_SetNumTevStages(u8 num)
+{
+    flush_pending();
+    state.num_stages = std::clamp<u8>(num, 1, GX_MAX_TEVSTAGE);
+}
+
+void GX_SetTevOrder(u8 tevstage, u8 texcoord, u32 texmap, u8 color)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    stage.texcoord = texcoord;
+    stage.texmap = texmap;
+    stage.channel = color;
+}
+
+// Same inputs as libogc, where the later stages take the previous stage instead of the rasterised colour
+void GX_SetTevOp(u8 tevstage, u8 mode)
+{
+    u8 color = tevstage ? GX_CC_CPREV : GX_CC_RASC;
+    u8 alpha = tevstage ? GX_CA_APREV : GX_CA_RASA;
+    switch (mode)
+    {
+    case GX_MODULATE:
+        GX_SetTevColorIn(tevstage, GX_CC_ZERO, GX_CC_TEXC, color, GX_CC_ZERO);
+        GX_SetTevAlphaIn(tevstage, GX_CA_ZERO, GX_CA_TEXA, alpha, GX_CA_ZERO);
+        break;
+    case GX_DECAL:
+        GX_SetTevColorIn(tevstage, color, GX_CC_TEXC, GX_CC_TEXA, GX_CC_ZERO);
+        GX_SetTevAlphaIn(tevstage, GX_CA_ZERO, GX_CA_ZERO, GX_CA_ZERO, alpha);
+        break;
+    case GX_BLEND:
+        GX_SetTevColorIn(tevstage, color, GX_CC_ONE, GX_CC_TEXC, GX_CC_ZERO);
+        GX_SetTevAlphaIn(tevstage, GX_CA_ZERO, GX_CA_TEXA, alpha, GX_CA_ZERO);
+        break;
+    case GX_REPLACE:
+        GX_SetTevColorIn(tevstage, GX_CC_ZERO, GX_CC_ZERO, GX_CC_ZERO, GX_CC_TEXC);
+        GX_SetTevAlphaIn(tevstage, GX_CA_ZERO, GX_CA_ZERO, GX_CA_ZERO, GX_CA_TEXA);
+        break;
+    default:
+        GX_SetTevColorIn(tevstage, GX_CC_ZERO, GX_CC_ZERO, GX_CC_ZERO, color);
+        GX_SetTevAlphaIn(tevstage, GX_CA_ZERO, GX_CA_ZERO, GX_CA_ZERO, alpha);
+        break;
+    }
+    GX_SetTevColorOp(tevstage, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+    GX_SetTevAlphaOp(tevstage, GX_TEV_ADD, GX_TB_ZERO, GX_CS_SCALE_1, GX_TRUE, GX_TEVPREV);
+}
+
+void GX_SetTevColorIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    const u8 inputs[4] = {a, b, c, d};
+    std::memcpy(stage.color_in, inputs, 4);
+}
+
+void GX_SetTevAlphaIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    const u8 inputs[4] = {a, b, c, d};
+    std::memcpy(stage.alpha_in, inputs, 4);
+}
+
+void GX_SetTevColorOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    stage.color_op = tevop;
+    stage.color_bias = tevbias;
+    stage.color_scale = tevscale;
+    stage.color_clamp = clamp;
+    stage.color_reg = tevregid;
+}
+
+void GX_SetTevAlphaOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    stage.alpha_op = tevop;
+    stage.alpha_bias = tevbias;
+    stage.alpha_scale = tevscale;
+    stage.alpha_clamp = clamp;
+    stage.alpha_reg = tevregid;
+}
+
+void GX_SetTevColor(u8 tev_regid, GXColor color)
+{
+    flush_pending();
+    TevColor &reg = state.tev_regs[tev_regid & 3];
+    reg.c[0] = color.r;
+    reg.c[1] = color.g;
+    reg.c[2] = color.b;
+    reg.c[3] = color.a;
+}
+
+void GX_SetTevKColor(u8 sel, GXColor col)
+{
+    flush_pending();
+    state.kcolors[sel & 3] = col;
+}
+
+void GX_SetTevKColorSel(u8 tevstage, u8 sel)
+{
+    flush_pending();
+    state.stages[tevstage % GX_MAX_TEVSTAGE].kcolor_sel = sel;
+}
+
+void GX_SetTevKAlphaSel(u8 tevstage, u8 sel)
+{
+    flush_pending();
+    state.stages[tevstage % GX_MAX_TEVSTAGE].kalpha_sel = sel;
+}
+
+void GX_SetNumIndStages(u8 nstages)
+{
+    flush_pending();
+    state.num_ind_stages = std::min<u8>(nstages, GX_MAX_INDTEXSTAGE);
+}
+
+void GX_SetIndTexOrder(u8 indtexstage, u8 texcoord, u8 texmap)
+{
+    flush_pending();
+    IndStage &stage = state.ind_stages[indtexstage % GX_MAX_INDTEXSTAGE];
+    stage.texcoord = texcoord;
+    stage.texmap = texmap;
+}
+
+void GX_SetIndTexCoordScale(u8 indtexid, u8 scale_s, u8 scale_t)
+{
+    flush_pending();
+    IndStage &stage = state.ind_stages[indtexid % GX_MAX_INDTEXSTAGE];
+    stage.scale_s = scale_s;
+    stage.scale_t = scale_t;
+}
+
+void GX_SetIndTexMatrix(u8 indtexmtx, f32 offset_mtx[2][3], s8 scale_exp)
+{
+    flush_pending();
+    if (indtexmtx < GX_ITM_0 || indtexmtx > GX_ITM_2)
+        return;
+    float scale = std::ldexp(1.0f, scale_exp);
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 3; j++)
+            state.ind_mtx[indtexmtx - GX_ITM_0][i][j] = offset_mtx[i][j] * scale;
+}
+
+// Add to previous and the LOD of the unmodified coordinate are not emulated
+void GX_SetTevIndirect(u8 tevstage, u8 indtexid, u8 format, u8 bias, u8 mtxid, u8 wrap_s, u8 wrap_t, u8, u8, u8)
+{
+    flush_pending();
+    TevStage &stage = state.stages[tevstage % GX_MAX_TEVSTAGE];
+    stage.ind_stage = indtexid;
+    stage.ind_format = format;
+    stage.ind_bias = bias;
+    stage.ind_mtx = mtxid;
+    stage.ind_wrap_s = wrap_s;
+    stage.ind_wrap_t = wrap_t;
+}
+
+// Same setup as libogc
+void GX_SetTevIndTile(u8 tevstage, u8 indtexid, u16 tilesize_x, u16 tilesize_y, u16 tilespacing_x, u16 tilespacing_y, u8 indtexfmt, u8 indtexmtx, u8 bias_sel, u8 alpha_sel)
+{
+    auto wrap_mode = [](u16 size) -> u8
+    {
+        switch (size)
+        {
+        case 16:
+            return GX_ITW_16;
+        case 32:
+            return GX_ITW_32;
+        case 64:
+            return GX_ITW_64;
+        case 128:
+            return GX_ITW_128;
+        case 256:
+            return GX_ITW_256;
+        default:
+            return GX_ITW_OFF;
+        }
+    };
+    f32 offset_mtx[2][3] = {{tilespacing_x / 1024.0f, 0, 0}, {0, tilespacing_y / 1024.0f, 0}};
+    GX_SetIndTexMatrix(indtexmtx, offset_mtx, 10);
+    GX_SetTevIndirect(tevstage, indtexid, indtexfmt, bias_sel, indtexmtx, wrap_mode(tilesize_x), wrap_mode(tilesize_y), GX_FALSE, GX_FALSE, alpha_sel);
+}
+
+void GX_SetTevDirect(u8 tevstage)
+{
+    GX_SetTevIndirect(tevstage, GX_INDTEXSTAGE0, GX_ITF_8, GX_ITB_NONE, GX_ITM_OFF, GX_ITW_OFF, GX_ITW_OFF, GX_FALSE, GX_FALSE, GX_ITBA_OFF);
+}
+
+void GX_SetAlphaCompare(u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1)
+{
+    flush_pending();
+    state.alpha_comp[0] = comp0;
+    state.alpha_ref[0] = ref0;
+    state.alpha_op = aop;
+    state.alpha_comp[1] = comp1;
+    state.alpha_ref[1] = ref1;
+}
+
+void GX_SetBlendMode(u8 type, u8 src_fact, u8 dst_fact, u8 op)
+{
+    flush_pending();
+    state.blend_type = type;
+    state.blend_src = src_fact;
+    state.blend_dst = dst_fact;
+    state.blend_logic = op;
+}
+
+void GX_SetFog(u8, f32, f32, f32, f32, GXColor) {}
+void GX_InitFogAdjTable(GXFogAdjTbl *, u16, const f32[4][4]) {}
+void GX_SetFogRangeAdj(u8, u16, GXFogAdjTbl *) {}
+
+void GX_InitTexObj(GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap)
+{
+    *obj = GXTexObj();
+    obj->data = img_ptr;
+    obj->width = wd;
+    obj->height = ht;
+    obj->format = fmt;
+    obj->wrap_s = wrap_s;
+    obj->wrap_t = wrap_t;
+    obj->mipmap = mipmap;
+}
+
+void GX_InitTexObjFilterMode(GXTexObj *obj, u8 minfilt, u8 magfilt)
+{
+    obj->min_filter = minfilt;
+    obj->mag_filter = magfilt;
+}
+
+void GX_InitTexObjLOD(GXTexObj *obj, u8 minfilt, u8 magfilt, f32, f32, f32, u8, u8, u8)
+{
+    GX_InitTexObjFilterMode(obj, minfilt, magfilt);
+}
+
+void GX_InitTexObjWrapMode(GXTexObj *obj, u8 wrap_s, u8 wrap_t)
+{
+    obj->wrap_s = wrap_s;
+    obj->wrap_t = wrap_t;
+}
+
+void GX_InitTexObjUserData(GXTexObj *obj, void *userdata)
+{
+    obj->user_data = userdata;
+}
+
+void *GX_GetTexObjUserData(GXTexObj *obj)
+{
+    return obj->user_data;
+}
+
+void *GX_GetTexObjData(GXTexObj *obj)
+{
+    return const_cast<void *>(obj->data);
+}
+
+u16 GX_GetTexObjWidth(GXTexObj *obj)
+{
+    return obj->width;
+}
+
+u16 GX_GetTexObjHeight(GXTexObj *obj)
+{
+    return obj->height;
+}
+
+u8 GX_GetTexObjFmt(GXTexObj *obj)
+{
+    return obj->format;
+}
+
+u32 GX_GetTexBufferSize(u16 wd, u16 ht, u32 fmt, u8, u8)
+{
+    // Every tile is 32 bytes, except RGBA8 which splits its 4x4 tiles into two
+    switch (fmt)
+    {
+    case GX_TF_RGBA8:
+        return ((wd + 3) >> 2) * ((ht + 3) >> 2) * 64;
+    case GX_TF_RGB565:
+    case GX_TF_RGB5A3:
+    case GX_TF_IA8:
+        return ((wd + 3) >> 2) * ((ht + 3) >> 2) * 32;
+    case GX_TF_I8:
+    case GX_TF_IA4:
+        return ((wd + 7) >> 3) * ((ht + 3) >> 2) * 32;
+    default:
+        return ((wd + 7) >> 3) * ((ht + 7) >> 3) * 32;
+    }
+}
+
+void GX_LoadTexObj(GXTexObj *obj, u8 mapid)
+{
+    flush_pending();
+    if (mapid >= GX_MAX_TEXMAP)
+        return;
+    state.textures[mapid] = *obj;
+    state.texture_loaded[mapid] = true;
+}
+
+void GX_Begin(u8 primitive, u8 vtxfmt, u16 vtxcnt)
+{
+    flush_pending();
+    u8 command = primitive | (vtxfmt & 7);
+    pipe_write(&command, 1);
+    pipe_write(&vtxcnt, 2);
+}
+
+void GX_End()
+{
+    flush_pending();
+}
+
+void GX_CallDispList(const void *list, u32 nbytes)
+{
+    flush_pending();
+    run_list(static_cast<const u8 *>(list), nbytes);
+}
+
+void GX_BeginDispList(void *list, u32 size)
+{
+    flush_pending();
+    record_buffer = static_cast<u8 *>(list);
+    record_capacity = size;
+    record_size = 0;
+    record_overflow = false;
+}
+
+u32 GX_EndDispList()
+{
+    // Pad to 32 bytes like the hardware FIFO, a list that did not fit is empty
+    while (!record_overflow && (record_size & 31))
+    {
+        u8 nop = GX_NOP;
+        pipe_write(&nop, 1);
+    }
+    u32 size = record_overflow ? 0 : record_size;
+    record_buffer = nullptr;
+    record_capacity = 0;
+    return size;
+}
@@ -0,0 +1,43 @@
+#ifndef GX_SOFT_HPP
+#define GX_SOFT_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Software implementation of the subset of GX that gertex and the game use, so
+ * that display lists can be drawn on a host without Wii hardware.
+ *
+ * Emulated: vertex descriptors and formats (direct and indexed), position and
+ * texture matrices, perspective and orthographic projection with clipping,
+ * culling, the TEV stages with indirect texture offsets and wrapping,
+ * textures in the GX tile formats with nearest sampling and wrapping, alpha
+ * compare, depth test and blending.
+ *
+ * Not emulated: fog, hardware lighting, mipmaps and filtering, lines and
+ * points, and display list commands other than primitives and GX_NOP. Only
+ * primitives are recorded by GX_BeginDispList, state changes made while
+ * recording apply at once. The embedded framebuffer is always RGBA8 with a
+ * float depth buffer.
+ */
+namespace gx_soft
+{
+    struct RasterStats
+    {
+        uint32_t triangles = 0; // Triangles sent to the rasteriser
+        uint32_t culled = 0;    // Triangles culled or clipped away entirely
+        uint32_t pixels = 0;    // Pixels that passed every test and were written
+    };
+
+    // Returns the counts since the last call to reset_raster_stats.
+    const RasterStats &get_raster_stats();
+    void reset_raster_stats();
+
+    // Returns the RGBA8 pixels of the last frame copied by GX_CopyDisp, top row first.
+    const uint8_t *get_frame(uint32_t &width, uint32_t &height);
+
+    // Writes the last copied frame to a PNG file. Returns false if it could not be written.
+    bool save_png(const std::string &filename);
+} // namespace gx_soft
+
+#endif
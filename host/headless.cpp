@@ -0,0 +1,110 @@
+#include "headless.hpp"
+
+#include <registry/block_list.hpp>
+#include <registry/items.hpp>
+#include <registry/tile_entities.hpp>
+#include <registry/textures.hpp>
+#include <render/render_chunks.hpp>
+#include <world/chunk.hpp>
+#include <world/chunkprovider.hpp>
+#include <world/world.hpp>
+
+namespace headless
+{
+    void register_game()
+    {
+        static bool registered = false;
+        if (registered)
+            return;
+        registry::register_blocks();
+        registry::register_items();
+        registry::register_tile_entities();
+
+        // Greedy meshing needs the tile size of the terrain atlas, which the textures would set
+        terrain_tile_size = 16;
+        registered = true;
+    }
+
+    World *create_world(int64_t seed)
+    {
+        World *world = new World();
+        world->light_engine.stop();
+        world->seed = seed;
+        world->chunk_provider = new ChunkProviderOverworld(world);
+        return world;
+    }
+
+    Chunk *add_chunk(World &world, int32_t x, int32_t z)
+    {
+        Chunk *chunk = world.get_chunk(x, z);
+        if (chunk)
+            return chunk;
+        chunk = new Chunk(x, z, &world);
+        chunk->state = ChunkState::done;
+        world.chunks.push_back(chunk);
+        world.chunk_cache.insert_or_assign(uint32_pair(x, z), chunk);
+        return chunk;
+    }
+
+    void generate_chunks(World &world, int radius)
+    {
+        // Same steps as the chunk manager takes for a new chunk
+        for (int32_t x = -radius; x <= radius; x++)
+        {
+            for (int32_t z = -radius; z <= radius; z++)
+            {
+                if (world.get_chunk(x, z))
+                    continue;
+                Chunk *chunk = new Chunk(x, z, &world);
+                world.chunk_provider->provide_chunk(chunk);
+                world.chunks.push_back(chunk);
+                world.chunk_cache.insert_or_assign(uint32_pair(x, z), chunk);
+                world.chunk_provider->populate_chunk(chunk);
+            }
+        }
+    }
+
+    void light_chunk(Chunk &chunk)
+    {
+        chunk.light_up();
+        chunk.world->light_engine.flush();
+    }
+
+    void light_world(World &world)
+    {
+        for (Chunk *chunk : world.chunks)
+            if (!chunk->lit_state)
+                light_chunk(*chunk);
+    }
+
+    void mesh_section(Chunk &chunk, int index)
+    {
+        Section &section = chunk.sections[index];
+        chunk.refresh_section_block_visibility(index);
+        section.mesh_slabs = SECTION_ALL_SLABS;
+        section.dirty_slabs = 0;
+        ChunkRenderer::render_section(section, false, section.solid);
+        ChunkRenderer::render_section(section, true, section.transparent);
+        section.mesh_slabs = 0;
+        section.refresh();
+    }
+
+    void mesh_chunk(Chunk &chunk)
+    {
+        for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+            mesh_section(chunk, i);
+    }
+
+    void destroy_world(World *world)
+    {
+        for (Chunk *chunk : world->chunks)
+        {
+            for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+                chunk->sections[i].clear();
+            delete chunk;
+        }
+        world->chunks.clear();
+        world->chunk_cache.clear();
+        delete world;
+    }
+} // namespace headless
@@ -0,0 +1,44 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <cstdint>
+
+class World;
+class Chunk;
+
+// Builds worlds for the host tools without the chunk manager, the light engine
+// thread or the mesh workers, so every step runs on the calling thread.
+namespace headless
+{
+    // Registers the blocks, items and tile entities. The textures and input devices need the console.
+    void register_game();
+
+    // Creates a world with the light engine stopped, see light_chunk.
+    World *create_world(int64_t seed);
+
+    // Adds an empty chunk of air to the world, or returns the chunk already there.
+    Chunk *add_chunk(World &world, int32_t x, int32_t z);
+
+    // Generates the chunks within the radius around the origin like the chunk manager,
+    // with the overworld generator and its features.
+    void generate_chunks(World &world, int radius);
+
+    // Lights up the chunk and processes every light update that it posts.
+    void light_chunk(Chunk &chunk);
+
+    // Lights up every chunk of the world that is not lit yet.
+    void light_world(World &world);
+
+    // Meshes both passes of a section of the chunk like a section update does. The chunks
+    // around it must be loaded. The new buffers are swapped in, so the section can be drawn.
+    void mesh_section(Chunk &chunk, int index);
+
+    // Meshes both passes of the sections of the chunk like the section updates do. The chunks
+    // around it must be loaded. The new buffers are swapped in, so the sections can be drawn.
+    void mesh_chunk(Chunk &chunk);
+
+    // Frees the meshes and chunks of the world and deletes it.
+    void destroy_world(World *world);
+} // namespace headless
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef ASNDLIB_H
+#define ASNDLIB_H
+
+#include <gctypes.h>
+
+// The host has no sound device. Every voice is in use, so sounds are never played.
+
+#define SND_OK 0
+#define SND_INVALID -1
+#define SND_UNUSED 0
+#define SND_WORKING 1
+#define SND_WAITING 2
+
+#define VOICE_MONO_8BIT 0
+#define VOICE_MONO_16BIT 1
+#define VOICE_STEREO_8BIT 2
+#define VOICE_STEREO_16BIT 3
+
+typedef void (*ASNDVoiceCallback)(s32 voice);
+
+inline void ASND_Init() {}
+inline void ASND_End() {}
+inline void ASND_Pause(s32) {}
+inline s32 ASND_GetFirstUnusedVoice() { return SND_INVALID; }
+inline s32 ASND_SetVoice(s32, s32, s32, s32, void *, s32, s32, s32, ASNDVoiceCallback) { return SND_INVALID; }
+inline s32 ASND_PauseVoice(s32, s32) { return SND_INVALID; }
+inline s32 ASND_StatusVoice(s32) { return SND_UNUSED; }
+inline s32 ASND_ChangeVolumeVoice(s32, s32, s32) { return SND_INVALID; }
+
+#endif
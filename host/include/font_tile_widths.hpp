@@ -0,0 +1,17 @@
+#ifndef FONT_TILE_WIDTHS_HPP
+#define FONT_TILE_WIDTHS_HPP
+
+#include <cstdint>
+
+// The console build measures the glyphs of textures/font.png. The host does not draw text,
+// so every glyph gets the full width.
+static const uint8_t font_tile_widths[256] = {
+#define FONT_TILE_WIDTHS_ROW 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8
+    FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW,
+    FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW,
+    FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW,
+    FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW, FONT_TILE_WIDTHS_ROW,
+#undef FONT_TILE_WIDTHS_ROW
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef GCCORE_H
+#define GCCORE_H
+
+#include <gctypes.h>
+#include <ogc/cache.h>
+#include <ogc/gu.h>
+#include <ogc/gx.h>
+#include <ogc/conf.h>
+#include <ogc/lwp.h>
+#include <ogc/mutex.h>
+#include <ogc/cond.h>
+#include <ogc/system.h>
+#include <ogc/video.h>
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef LIGHT_NETHER_H
+#define LIGHT_NETHER_H
+
+// The console build generates this from textures/light_nether.png, the host defines it in system.cpp
+const extern unsigned char light_nether_rgba[];
+
+#endif
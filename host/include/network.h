@@ -0,0 +1,41 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+// Host stand-in for the libogc network library on top of BSD sockets
+
+#include <gctypes.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+inline s32 net_init() { return 0; }
+inline void net_deinit() {}
+
+inline s32 if_config(char *local_ip, char *netmask, char *gateway, bool, int)
+{
+    std::strcpy(local_ip, "127.0.0.1");
+    std::strcpy(netmask, "255.0.0.0");
+    std::strcpy(gateway, "127.0.0.1");
+    return 0;
+}
+
+inline s32 net_socket(u32 domain, u32 type, u32 protocol) { return socket(domain, type, protocol); }
+inline s32 net_ioctl(s32 s, u32 cmd, void *argp) { return ioctl(s, cmd, argp); }
+inline hostent *net_gethostbyname(const char *addrString) { return gethostbyname(addrString); }
+inline s32 net_connect(s32 s, sockaddr *addr, socklen_t addrlen) { return connect(s, addr, addrlen) < 0 ? -errno : 0; }
+inline s32 net_write(s32 s, const void *data, s32 size) { return write(s, data, size) < 0 ? -errno : size; }
+inline s32 net_read(s32 s, void *mem, s32 len)
+{
+    ssize_t received = read(s, mem, len);
+    return received < 0 ? -errno : s32(received);
+}
+inline s32 net_close(s32 s) { return close(s); }
+inline s32 net_select(s32 maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset, timeval *timeout) { return select(maxfdp1, readset, writeset, exceptset, timeout); }
+
+#endif
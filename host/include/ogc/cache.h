@@ -0,0 +1,10 @@
+#ifndef OGC_CACHE_H
+#define OGC_CACHE_H
+
+// The software GX reads main memory directly, so there is nothing to flush
+
+inline void DCFlushRange(void *, unsigned int) {}
+inline void DCStoreRange(void *, unsigned int) {}
+inline void DCInvalidateRange(void *, unsigned int) {}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef OGC_COND_H
+#define OGC_COND_H
+
+#include <gctypes.h>
+#include <ogc/mutex.h>
+
+// Condition variables are handles to std::condition_variable_any objects held by the host shim
+typedef u32 cond_t;
+
+#define LWP_COND_NULL 0xffffffff
+
+s32 LWP_CondInit(cond_t *cond);
+s32 LWP_CondDestroy(cond_t cond);
+s32 LWP_CondWait(cond_t cond, mutex_t mutex);
+s32 LWP_CondSignal(cond_t cond);
+s32 LWP_CondBroadcast(cond_t cond);
+
+#endif
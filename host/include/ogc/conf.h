@@ -0,0 +1,10 @@
+#ifndef OGC_CONF_H
+#define OGC_CONF_H
+
+#define CONF_ASPECT_4_3 0
+#define CONF_ASPECT_16_9 1
+
+// The host always renders 4:3
+inline int CONF_GetAspectRatio() { return CONF_ASPECT_4_3; }
+
+#endif
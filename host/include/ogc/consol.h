@@ -0,0 +1,6 @@
+#ifndef OGC_CONSOL_H
+#define OGC_CONSOL_H
+
+// Nothing from this header is used on the host
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef OGC_GU_H
+#define OGC_GU_H
+
+// Host stand-in for the libogc matrix library. Only the functions used by the
+// game are provided, with the same conventions: 3x4 row-major matrices that
+// transform column vectors and projections that map the visible depth to [-1, 0].
+
+#include <gctypes.h>
+
+#define M_DTOR (3.14159265358979323846 / 180.0)
+
+// Defined by the math.h of newlib but not by glibc
+#ifndef M_TWOPI
+#define M_TWOPI (3.14159265358979323846 * 2.0)
+#endif
+#ifndef M_SQRT3
+#define M_SQRT3 1.73205080756887719000
+#endif
+#define DegToRad(a) ((a) * 0.01745329252f)
+#define RadToDeg(a) ((a) * 57.29577951f)
+
+typedef float Mtx[3][4];
+typedef float (*MtxP)[4];
+typedef float Mtx44[4][4];
+typedef float (*Mtx44P)[4];
+
+typedef struct _vecf
+{
+    f32 x, y, z;
+} guVector;
+
+void guMtxIdentity(Mtx mt);
+void guMtxCopy(const Mtx src, Mtx dst);
+void guMtxConcat(const Mtx a, const Mtx b, Mtx ab);
+void guMtxScale(Mtx mt, f32 xs, f32 ys, f32 zs);
+void guMtxScaleApply(const Mtx src, Mtx dst, f32 xs, f32 ys, f32 zs);
+void guMtxTrans(Mtx mt, f32 xt, f32 yt, f32 zt);
+void guMtxTransApply(const Mtx src, Mtx dst, f32 xt, f32 yt, f32 zt);
+void guMtxApplyScale(const Mtx src, Mtx dst, f32 xs, f32 ys, f32 zs);
+void guMtxApplyTrans(const Mtx src, Mtx dst, f32 xt, f32 yt, f32 zt);
+void guMtxRotRad(Mtx mt, const char axis, f32 rad);
+void guMtxRotAxisRad(Mtx mt, guVector *axis, f32 rad);
+u32 guMtxInverse(const Mtx src, Mtx inv);
+void guVecMultiply(const Mtx mt, const guVector *src, guVector *dst);
+void guVecMultiplySR(const Mtx mt, const guVector *src, guVector *dst);
+void guVecNormalize(guVector *v);
+void guVecCross(const guVector *a, const guVector *b, guVector *axb);
+f32 guVecDotProduct(const guVector *a, const guVector *b);
+void guLookAt(Mtx mt, const guVector *camPos, const guVector *camUp, const guVector *target);
+
+void guMtx44Identity(Mtx44 mt);
+void guMtx44Copy(const Mtx44 src, Mtx44 dst);
+void guPerspective(Mtx44 mt, f32 fovy, f32 aspect, f32 n, f32 f);
+void guOrtho(Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f);
+void guFrustum(Mtx44 mt, f32 t, f32 b, f32 l, f32 r, f32 n, f32 f);
+
+#define guMtxRotDeg(mt, axis, deg) guMtxRotRad(mt, axis, DegToRad(deg))
+#define guMtxRotAxisDeg(mt, axis, deg) guMtxRotAxisRad(mt, axis, DegToRad(deg))
+
+#endif
@@ -0,0 +1,695 @@
+#ifndef OGC_GX_H
+#define OGC_GX_H
+
+// Host stand-in for the libogc GX API. The constants have the libogc values so
+// that display lists built on the host look like the ones built on the Wii,
+// except that their multi-byte values are in host byte order. The functions
+// drive the software rasteriser in gx_soft.cpp. See gx_soft.hpp for what is
+// and is not emulated.
+
+#include <gctypes.h>
+#include <ogc/gu.h>
+
+#define GX_FALSE 0
+#define GX_TRUE 1
+#define GX_DISABLE 0
+#define GX_ENABLE 1
+
+#define GX_NOP 0x00
+
+#define GX_POINTS 0xB8
+#define GX_LINES 0xA8
+#define GX_LINESTRIP 0xB0
+#define GX_TRIANGLES 0x90
+#define GX_TRIANGLESTRIP 0x98
+#define GX_TRIANGLEFAN 0xA0
+#define GX_QUADS 0x80
+
+#define GX_VTXFMT0 0
+#define GX_VTXFMT1 1
+#define GX_VTXFMT2 2
+#define GX_VTXFMT3 3
+#define GX_VTXFMT4 4
+#define GX_VTXFMT5 5
+#define GX_VTXFMT6 6
+#define GX_VTXFMT7 7
+#define GX_MAXVTXFMT 8
+
+#define GX_VA_PTNMTXIDX 0
+#define GX_VA_TEX0MTXIDX 1
+#define GX_VA_TEX1MTXIDX 2
+#define GX_VA_TEX2MTXIDX 3
+#define GX_VA_TEX3MTXIDX 4
+#define GX_VA_TEX4MTXIDX 5
+#define GX_VA_TEX5MTXIDX 6
+#define GX_VA_TEX6MTXIDX 7
+#define GX_VA_TEX7MTXIDX 8
+#define GX_VA_POS 9
+#define GX_VA_NRM 10
+#define GX_VA_CLR0 11
+#define GX_VA_CLR1 12
+#define GX_VA_TEX0 13
+#define GX_VA_TEX1 14
+#define GX_VA_TEX2 15
+#define GX_VA_TEX3 16
+#define GX_VA_TEX4 17
+#define GX_VA_TEX5 18
+#define GX_VA_TEX6 19
+#define GX_VA_TEX7 20
+#define GX_POSMTXARRAY 21
+#define GX_NRMMTXARRAY 22
+#define GX_TEXMTXARRAY 23
+#define GX_LIGHTARRAY 24
+#define GX_VA_NBT 25
+#define GX_VA_MAXATTR 26
+#define GX_VA_NULL 0xff
+
+#define GX_MAX_VTXDESC_LISTSIZE (GX_VA_MAXATTR + 1)
+#define GX_MAX_VTXATTRFMT_LISTSIZE (GX_VA_MAXATTR + 1)
+
+#define GX_NONE 0
+#define GX_DIRECT 1
+#define GX_INDEX8 2
+#define GX_INDEX16 3
+
+#define GX_U8 0
+#define GX_S8 1
+#define GX_U16 2
+#define GX_S16 3
+#define GX_F32 4
+
+#define GX_RGB565 0
+#define GX_RGB8 1
+#define GX_RGBX8 2
+#define GX_RGBA4 3
+#define GX_RGBA6 4
+#define GX_RGBA8 5
+
+#define GX_POS_XY 0
+#define GX_POS_XYZ 1
+#define GX_NRM_XYZ 0
+#define GX_NRM_NBT 1
+#define GX_NRM_NBT3 2
+#define GX_CLR_RGB 0
+#define GX_CLR_RGBA 1
+#define GX_TEX_S 0
+#define GX_TEX_ST 1
+
+#define GX_PNMTX0 0
+#define GX_PNMTX1 3
+#define GX_PNMTX2 6
+#define GX_PERSPECTIVE 0
+#define GX_ORTHOGRAPHIC 1
+
+#define GX_MTX3x4 0
+#define GX_MTX2x4 1
+#define GX_TEXMTX0 30
+#define GX_TEXMTX1 33
+#define GX_TEXMTX2 36
+#define GX_TEXMTX3 39
+#define GX_TEXMTX4 42
+#define GX_TEXMTX5 45
+#define GX_TEXMTX6 48
+#define GX_TEXMTX7 51
+#define GX_TEXMTX8 54
+#define GX_TEXMTX9 57
+#define GX_IDENTITY 60
+
+#define GX_TG_MTX3x4 0
+#define GX_TG_MTX2x4 1
+#define GX_TG_POS 0
+#define GX_TG_NRM 1
+#define GX_TG_BINRM 2
+#define GX_TG_TANGENT 3
+#define GX_TG_TEX0 4
+#define GX_TG_TEX1 5
+#define GX_TG_TEX2 6
+#define GX_TG_TEX3 7
+#define GX_TG_TEX4 8
+#define GX_TG_TEX5 9
+#define GX_TG_TEX6 10
+#define GX_TG_TEX7 11
+
+#define GX_TEXCOORD0 0
+#define GX_TEXCOORD1 1
+#define GX_TEXCOORD2 2
+#define GX_TEXCOORD3 3
+#define GX_TEXCOORD4 4
+#define GX_TEXCOORD5 5
+#define GX_TEXCOORD6 6
+#define GX_TEXCOORD7 7
+#define GX_MAXCOORD 8
+#define GX_TEXCOORDNULL 0xff
+
+#define GX_TEXMAP0 0
+#define GX_TEXMAP1 1
+#define GX_TEXMAP2 2
+#define GX_TEXMAP3 3
+#define GX_TEXMAP4 4
+#define GX_TEXMAP5 5
+#define GX_TEXMAP6 6
+#define GX_TEXMAP7 7
+#define GX_MAX_TEXMAP 8
+#define GX_TEXMAP_NULL 0xff
+#define GX_TEXMAP_DISABLE 0x100
+
+#define GX_COLOR0 0
+#define GX_COLOR1 1
+#define GX_ALPHA0 2
+#define GX_ALPHA1 3
+#define GX_COLOR0A0 4
+#define GX_COLOR1A1 5
+#define GX_COLORZERO 6
+#define GX_ALPHA_BUMP 7
+#define GX_ALPHA_BUMPN 8
+#define GX_COLORNULL 0xff
+
+#define GX_SRC_REG 0
+#define GX_SRC_VTX 1
+
+#define GX_TEVSTAGE0 0
+#define GX_TEVSTAGE1 1
+#define GX_TEVSTAGE2 2
+#define GX_TEVSTAGE3 3
+#define GX_TEVSTAGE4 4
+#define GX_TEVSTAGE5 5
+#define GX_TEVSTAGE6 6
+#define GX_TEVSTAGE7 7
+#define GX_TEVSTAGE8 8
+#define GX_TEVSTAGE9 9
+#define GX_TEVSTAGE10 10
+#define GX_TEVSTAGE11 11
+#define GX_TEVSTAGE12 12
+#define GX_TEVSTAGE13 13
+#define GX_TEVSTAGE14 14
+#define GX_TEVSTAGE15 15
+#define GX_MAX_TEVSTAGE 16
+
+#define GX_INDTEXSTAGE0 0
+#define GX_INDTEXSTAGE1 1
+#define GX_INDTEXSTAGE2 2
+#define GX_INDTEXSTAGE3 3
+#define GX_MAX_INDTEXSTAGE 4
+
+#define GX_ITS_1 0x00
+#define GX_ITS_2 0x01
+#define GX_ITS_4 0x02
+#define GX_ITS_8 0x03
+#define GX_ITS_16 0x04
+#define GX_ITS_32 0x05
+#define GX_ITS_64 0x06
+#define GX_ITS_128 0x07
+#define GX_ITS_256 0x08
+
+#define GX_ITF_8 0
+#define GX_ITF_5 1
+#define GX_ITF_4 2
+#define GX_ITF_3 3
+
+#define GX_ITB_NONE 0
+#define GX_ITB_S 1
+#define GX_ITB_T 2
+#define GX_ITB_ST 3
+#define GX_ITB_U 4
+#define GX_ITB_SU 5
+#define GX_ITB_TU 6
+#define GX_ITB_STU 7
+
+#define GX_ITBA_OFF 0
+#define GX_ITBA_S 1
+#define GX_ITBA_T 2
+#define GX_ITBA_U 3
+
+#define GX_ITM_OFF 0
+#define GX_ITM_0 1
+#define GX_ITM_1 2
+#define GX_ITM_2 3
+
+#define GX_ITW_OFF 0
+#define GX_ITW_256 1
+#define GX_ITW_128 2
+#define GX_ITW_64 3
+#define GX_ITW_32 4
+#define GX_ITW_16 5
+#define GX_ITW_0 6
+
+#define GX_MODULATE 0
+#define GX_DECAL 1
+#define GX_BLEND 2
+#define GX_REPLACE 3
+#define GX_PASSCLR 4
+
+#define GX_CC_CPREV 0
+#define GX_CC_APREV 1
+#define GX_CC_C0 2
+#define GX_CC_A0 3
+#define GX_CC_C1 4
+#define GX_CC_A1 5
+#define GX_CC_C2 6
+#define GX_CC_A2 7
+#define GX_CC_TEXC 8
+#define GX_CC_TEXA 9
+#define GX_CC_RASC 10
+#define GX_CC_RASA 11
+#define GX_CC_ONE 12
+#define GX_CC_HALF 13
+#define GX_CC_KONST 14
+#define GX_CC_ZERO 15
+
+#define GX_CA_APREV 0
+#define GX_CA_A0 1
+#define GX_CA_A1 2
+#define GX_CA_A2 3
+#define GX_CA_TEXA 4
+#define GX_CA_RASA 5
+#define GX_CA_KONST 6
+#define GX_CA_ZERO 7
+
+#define GX_TEV_ADD 0
+#define GX_TEV_SUB 1
+
+#define GX_TB_ZERO 0
+#define GX_TB_ADDHALF 1
+#define GX_TB_SUBHALF 2
+
+#define GX_CS_SCALE_1 0
+#define GX_CS_SCALE_2 1
+#define GX_CS_SCALE_4 2
+#define GX_CS_DIVIDE_2 3
+
+#define GX_TEVPREV 0
+#define GX_TEVREG0 1
+#define GX_TEVREG1 2
+#define GX_TEVREG2 3
+
+#define GX_KCOLOR0 0
+#define GX_KCOLOR1 1
+#define GX_KCOLOR2 2
+#define GX_KCOLOR3 3
+
+#define GX_TEV_KCSEL_1 0x00
+#define GX_TEV_KCSEL_7_8 0x01
+#define GX_TEV_KCSEL_3_4 0x02
+#define GX_TEV_KCSEL_5_8 0x03
+#define GX_TEV_KCSEL_1_2 0x04
+#define GX_TEV_KCSEL_3_8 0x05
+#define GX_TEV_KCSEL_1_4 0x06
+#define GX_TEV_KCSEL_1_8 0x07
+#define GX_TEV_KCSEL_K0 0x0C
+#define GX_TEV_KCSEL_K1 0x0D
+#define GX_TEV_KCSEL_K2 0x0E
+#define GX_TEV_KCSEL_K3 0x0F
+#define GX_TEV_KCSEL_K0_R 0x10
+#define GX_TEV_KCSEL_K0_G 0x14
+#define GX_TEV_KCSEL_K0_B 0x18
+#define GX_TEV_KCSEL_K0_A 0x1C
+
+#define GX_TEV_KASEL_1 0x00
+#define GX_TEV_KASEL_7_8 0x01
+#define GX_TEV_KASEL_3_4 0x02
+#define GX_TEV_KASEL_5_8 0x03
+#define GX_TEV_KASEL_1_2 0x04
+#define GX_TEV_KASEL_3_8 0x05
+#define GX_TEV_KASEL_1_4 0x06
+#define GX_TEV_KASEL_1_8 0x07
+#define GX_TEV_KASEL_K0_R 0x10
+#define GX_TEV_KASEL_K0_G 0x14
+#define GX_TEV_KASEL_K0_B 0x18
+#define GX_TEV_KASEL_K0_A 0x1C
+
+#define GX_NEVER 0
+#define GX_LESS 1
+#define GX_EQUAL 2
+#define GX_LEQUAL 3
+#define GX_GREATER 4
+#define GX_NEQUAL 5
+#define GX_GEQUAL 6
+#define GX_ALWAYS 7
+
+#define GX_AOP_AND 0
+#define GX_AOP_OR 1
+#define GX_AOP_XOR 2
+#define GX_AOP_XNOR 3
+
+#define GX_CULL_NONE 0
+#define GX_CULL_FRONT 1
+#define GX_CULL_BACK 2
+#define GX_CULL_ALL 3
+
+#define GX_BM_NONE 0
+#define GX_BM_BLEND 1
+#define GX_BM_LOGIC 2
+#define GX_BM_SUBTRACT 3
+
+#define GX_BL_ZERO 0
+#define GX_BL_ONE 1
+#define GX_BL_SRCCLR 2
+#define GX_BL_INVSRCCLR 3
+#define GX_BL_SRCALPHA 4
+#define GX_BL_INVSRCALPHA 5
+#define GX_BL_DSTALPHA 6
+#define GX_BL_INVDSTALPHA 7
+#define GX_BL_DSTCLR GX_BL_SRCCLR
+#define GX_BL_INVDSTCLR GX_BL_INVSRCCLR
+
+#define GX_LO_CLEAR 0
+#define GX_LO_AND 1
+#define GX_LO_REVAND 2
+#define GX_LO_COPY 3
+#define GX_LO_INVAND 4
+#define GX_LO_NOOP 5
+#define GX_LO_XOR 6
+#define GX_LO_OR 7
+#define GX_LO_NOR 8
+#define GX_LO_EQUIV 9
+#define GX_LO_INV 10
+#define GX_LO_REVOR 11
+#define GX_LO_INVCOPY 12
+#define GX_LO_INVOR 13
+#define GX_LO_NAND 14
+#define GX_LO_SET 15
+
+#define GX_FOG_NONE 0
+#define GX_FOG_LIN 2
+#define GX_FOG_EXP 4
+#define GX_FOG_EXP2 5
+#define GX_FOG_REVEXP 6
+#define GX_FOG_REVEXP2 7
+
+#define GX_TF_I4 0x0
+#define GX_TF_I8 0x1
+#define GX_TF_IA4 0x2
+#define GX_TF_IA8 0x3
+#define GX_TF_RGB565 0x4
+#define GX_TF_RGB5A3 0x5
+#define GX_TF_RGBA8 0x6
+
+#define GX_CLAMP 0
+#define GX_REPEAT 1
+#define GX_MIRROR 2
+
+#define GX_NEAR 0
+#define GX_LINEAR 1
+#define GX_NEAR_MIP_NEAR 2
+#define GX_LIN_MIP_NEAR 3
+#define GX_NEAR_MIP_LIN 4
+#define GX_LIN_MIP_LIN 5
+
+#define GX_ANISO_1 0
+#define GX_ANISO_2 1
+#define GX_ANISO_4 2
+
+#define GX_PF_RGB8_Z24 0
+#define GX_PF_RGBA6_Z24 1
+#define GX_PF_RGB565_Z16 2
+#define GX_ZC_LINEAR 0
+
+#define GX_GM_1_0 0
+#define GX_MAX_Z24 0x00ffffff
+
+typedef struct _gx_color
+{
+    u8 r, g, b, a;
+} GXColor;
+
+typedef struct _vtxattrfmt
+{
+    u32 vtxattr;
+    u32 comptype;
+    u32 compsize;
+    u32 frac;
+} GXVtxAttrFmt;
+
+typedef struct _vtxdesc
+{
+    u8 attr;
+    u8 type;
+} GXVtxDesc;
+
+// Unlike the hardware object, this is read directly by the rasteriser
+typedef struct _gx_texobj
+{
+    const void *data;
+    u16 width;
+    u16 height;
+    u8 format;
+    u8 wrap_s;
+    u8 wrap_t;
+    u8 mipmap;
+    u8 min_filter;
+    u8 mag_filter;
+    void *user_data;
+} GXTexObj;
+
+typedef struct _gx_fogadjtbl
+{
+    u16 r[10];
+} GXFogAdjTbl;
+
+typedef struct _gx_rmodeobj
+{
+    u32 viTVMode;
+    u16 fbWidth;
+    u16 efbHeight;
+    u16 xfbHeight;
+    u16 viXOrigin;
+    u16 viYOrigin;
+    u16 viWidth;
+    u16 viHeight;
+    u32 xfbMode;
+    u8 field_rendering;
+    u8 aa;
+    u8 sample_pattern[12][2];
+    u8 vfilter[7];
+} GXRModeObj;
+
+typedef struct _gx_fifoobj
+{
+    u8 pad[128];
+} GXFifoObj;
+
+// Immediate mode writes go through wgPipe like on the hardware. On the host
+// every member is a writer that appends the value to the pending primitive.
+namespace gx_soft
+{
+    void pipe_write(const void *data, u32 size);
+
+    template <typename T>
+    struct PipeWriter
+    {
+        PipeWriter &operator=(T value)
+        {
+            pipe_write(&value, sizeof(T));
+            return *this;
+        }
+    };
+} // namespace gx_soft
+
+union WGPipe
+{
+    gx_soft::PipeWriter<u8> U8;
+    gx_soft::PipeWriter<s8> S8;
+    gx_soft::PipeWriter<u16> U16;
+    gx_soft::PipeWriter<s16> S16;
+    gx_soft::PipeWriter<u32> U32;
+    gx_soft::PipeWriter<s32> S32;
+    gx_soft::PipeWriter<f32> F32;
+};
+
+extern WGPipe *const wgPipe;
+
+GXFifoObj *GX_Init(void *base, u32 size);
+void GX_SetViewport(f32 xOrig, f32 yOrig, f32 wd, f32 ht, f32 nearZ, f32 farZ);
+void GX_SetScissor(u32 xOrigin, u32 yOrigin, u32 wd, u32 ht);
+f32 GX_GetYScaleFactor(u16 efbHeight, u16 xfbHeight);
+u32 GX_SetDispCopyYScale(f32 yscale);
+void GX_SetDispCopySrc(u16 left, u16 top, u16 wd, u16 ht);
+void GX_SetDispCopyDst(u16 wd, u16 ht);
+void GX_SetCopyFilter(u8 aa, u8 sample_pattern[12][2], u8 vf, u8 vfilter[7]);
+void GX_SetFieldMode(u8 field_mode, u8 half_aspect_ratio);
+void GX_SetDispCopyGamma(u8 gamma);
+void GX_SetPixelFmt(u8 pix_fmt, u8 z_fmt);
+void GX_SetCopyClear(GXColor color, u32 zvalue);
+void GX_CopyDisp(void *dest, u8 clear);
+void GX_SetColorUpdate(u8 enable);
+void GX_SetAlphaUpdate(u8 enable);
+void GX_SetZMode(u8 enable, u8 func, u8 update_enable);
+void GX_SetZCompLoc(u8 before_tex);
+void GX_SetCullMode(u8 mode);
+void GX_SetLineWidth(u8 width, u8 fmt);
+void GX_SetDither(u8 dither);
+void GX_Flush();
+void GX_DrawDone();
+void GX_InvalidateTexAll();
+void GX_InvVtxCache();
+
+void GX_ClearVtxDesc();
+void GX_SetVtxDesc(u8 attr, u8 type);
+void GX_SetVtxAttrFmt(u8 vtxfmt, u32 vtxattr, u32 comptype, u32 compsize, u32 frac);
+void GX_SetVtxAttrFmtv(u8 vtxfmt, const GXVtxAttrFmt *attr_list);
+void GX_SetArray(u32 attr, void *ptr, u8 stride);
+void GX_LoadPosMtxImm(const Mtx mt, u32 pnidx);
+void GX_LoadNrmMtxImm(const Mtx mt, u32 pnidx);
+void GX_LoadTexMtxImm(const Mtx mt, u32 texidx, u8 type);
+void GX_SetCurrentMtx(u32 mtx);
+void GX_LoadProjectionMtx(const Mtx44 mt, u8 type);
+
+void GX_SetNumChans(u8 num);
+void GX_SetChanCtrl(s32 channel, u8 enable, u8 ambsrc, u8 matsrc, u8 litmask, u8 diff_fn, u8 attn_fn);
+void GX_SetChanMatColor(s32 channel, GXColor color);
+void GX_SetChanAmbColor(s32 channel, GXColor color);
+void GX_SetNumTexGens(u32 nr);
+void GX_SetTexCoordGen(u16 texcoord, u32 tgen_typ, u32 tgen_src, u32 mtxsrc);
+void GX_SetNumTevStages(u8 num);
+void GX_SetTevOrder(u8 tevstage, u8 texcoord, u32 texmap, u8 color);
+void GX_SetTevOp(u8 tevstage, u8 mode);
+void GX_SetTevColorIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void GX_SetTevAlphaIn(u8 tevstage, u8 a, u8 b, u8 c, u8 d);
+void GX_SetTevColorOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid);
+void GX_SetTevAlphaOp(u8 tevstage, u8 tevop, u8 tevbias, u8 tevscale, u8 clamp, u8 tevregid);
+void GX_SetTevColor(u8 tev_regid, GXColor color);
+void GX_SetTevKColor(u8 sel, GXColor col);
+void GX_SetTevKColorSel(u8 tevstage, u8 sel);
+void GX_SetTevKAlphaSel(u8 tevstage, u8 sel);
+void GX_SetNumIndStages(u8 nstages);
+void GX_SetIndTexOrder(u8 indtexstage, u8 texcoord, u8 texmap);
+void GX_SetIndTexCoordScale(u8 indtexid, u8 scale_s, u8 scale_t);
+void GX_SetIndTexMatrix(u8 indtexmtx, f32 offset_mtx[2][3], s8 scale_exp);
+void GX_SetTevIndirect(u8 tevstage, u8 indtexid, u8 format, u8 bias, u8 mtxid, u8 wrap_s, u8 wrap_t, u8 addprev, u8 utclod, u8 a);
+void GX_SetTevIndTile(u8 tevstage, u8 indtexid, u16 tilesize_x, u16 tilesize_y, u16 tilespacing_x, u16 tilespacing_y, u8 indtexfmt, u8 indtexmtx, u8 bias_sel, u8 alpha_sel);
+void GX_SetTevDirect(u8 tevstage);
+void GX_SetAlphaCompare(u8 comp0, u8 ref0, u8 aop, u8 comp1, u8 ref1);
+void GX_SetBlendMode(u8 type, u8 src_fact, u8 dst_fact, u8 op);
+void GX_SetFog(u8 type, f32 startz, f32 endz, f32 nearz, f32 farz, GXColor col);
+void GX_InitFogAdjTable(GXFogAdjTbl *table, u16 width, const f32 projmtx[4][4]);
+void GX_SetFogRangeAdj(u8 enable, u16 center, GXFogAdjTbl *table);
+
+void GX_InitTexObj(GXTexObj *obj, void *img_ptr, u16 wd, u16 ht, u8 fmt, u8 wrap_s, u8 wrap_t, u8 mipmap);
+void GX_InitTexObjFilterMode(GXTexObj *obj, u8 minfilt, u8 magfilt);
+void GX_InitTexObjLOD(GXTexObj *obj, u8 minfilt, u8 magfilt, f32 minlod, f32 maxlod, f32 lodbias, u8 biasclamp, u8 edgelod, u8 maxaniso);
+void GX_InitTexObjWrapMode(GXTexObj *obj, u8 wrap_s, u8 wrap_t);
+void GX_InitTexObjUserData(GXTexObj *obj, void *userdata);
+void *GX_GetTexObjUserData(GXTexObj *obj);
+void *GX_GetTexObjData(GXTexObj *obj);
+u16 GX_GetTexObjWidth(GXTexObj *obj);
+u16 GX_GetTexObjHeight(GXTexObj *obj);
+u8 GX_GetTexObjFmt(GXTexObj *obj);
+u32 GX_GetTexBufferSize(u16 wd, u16 ht, u32 fmt, u8 mipmap, u8 maxlod);
+void GX_LoadTexObj(GXTexObj *obj, u8 mapid);
+
+void GX_Begin(u8 primitve, u8 vtxfmt, u16 vtxcnt);
+void GX_End();
+void GX_CallDispList(const void *list, u32 nbytes);
+void GX_BeginDispList(void *list, u32 size);
+u32 GX_EndDispList();
+
+inline void GX_Position3f32(f32 x, f32 y, f32 z)
+{
+    wgPipe->F32 = x;
+    wgPipe->F32 = y;
+    wgPipe->F32 = z;
+}
+
+inline void GX_Position3s16(s16 x, s16 y, s16 z)
+{
+    wgPipe->S16 = x;
+    wgPipe->S16 = y;
+    wgPipe->S16 = z;
+}
+
+inline void GX_Position3u16(u16 x, u16 y, u16 z)
+{
+    wgPipe->U16 = x;
+    wgPipe->U16 = y;
+    wgPipe->U16 = z;
+}
+
+inline void GX_Position3s8(s8 x, s8 y, s8 z)
+{
+    wgPipe->S8 = x;
+    wgPipe->S8 = y;
+    wgPipe->S8 = z;
+}
+
+inline void GX_Position2f32(f32 x, f32 y)
+{
+    wgPipe->F32 = x;
+    wgPipe->F32 = y;
+}
+
+inline void GX_Position2s16(s16 x, s16 y)
+{
+    wgPipe->S16 = x;
+    wgPipe->S16 = y;
+}
+
+inline void GX_Position1x8(u8 index)
+{
+    wgPipe->U8 = index;
+}
+
+inline void GX_Position1x16(u16 index)
+{
+    wgPipe->U16 = index;
+}
+
+inline void GX_Color4u8(u8 r, u8 g, u8 b, u8 a)
+{
+    wgPipe->U8 = r;
+    wgPipe->U8 = g;
+    wgPipe->U8 = b;
+    wgPipe->U8 = a;
+}
+
+inline void GX_Color3u8(u8 r, u8 g, u8 b)
+{
+    wgPipe->U8 = r;
+    wgPipe->U8 = g;
+    wgPipe->U8 = b;
+}
+
+inline void GX_Color1u32(u32 color)
+{
+    wgPipe->U32 = color;
+}
+
+inline void GX_Color1x8(u8 index)
+{
+    wgPipe->U8 = index;
+}
+
+inline void GX_Color1x16(u16 index)
+{
+    wgPipe->U16 = index;
+}
+
+inline void GX_TexCoord2f32(f32 s, f32 t)
+{
+    wgPipe->F32 = s;
+    wgPipe->F32 = t;
+}
+
+inline void GX_TexCoord2u16(u16 s, u16 t)
+{
+    wgPipe->U16 = s;
+    wgPipe->U16 = t;
+}
+
+inline void GX_TexCoord2s16(s16 s, s16 t)
+{
+    wgPipe->S16 = s;
+    wgPipe->S16 = t;
+}
+
+inline void GX_TexCoord2u8(u8 s, u8 t)
+{
+    wgPipe->U8 = s;
+    wgPipe->U8 = t;
+}
+
+inline void GX_Normal1x8(u8 index)
+{
+    wgPipe->U8 = index;
+}
+
+#endif
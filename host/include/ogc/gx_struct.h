@@ -0,0 +1,6 @@
+#ifndef OGC_GX_STRUCT_H
+#define OGC_GX_STRUCT_H
+
+#include <ogc/gx.h>
+
+#endif
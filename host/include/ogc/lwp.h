@@ -0,0 +1,14 @@
+#ifndef OGC_LWP_H
+#define OGC_LWP_H
+
+#include <gctypes.h>
+
+// Threads are handles to std::thread objects held by the host shim. The priority is ignored.
+typedef u32 lwp_t;
+
+#define LWP_THREAD_NULL 0xffffffff
+
+s32 LWP_CreateThread(lwp_t *thread, void *(*entry)(void *), void *arg, void *stack, u32 stack_size, u8 priority);
+s32 LWP_JoinThread(lwp_t thread, void **value);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef OGC_LWP_WATCHDOG_H
+#define OGC_LWP_WATCHDOG_H
+
+#include <gctypes.h>
+#include <chrono>
+
+// Ticks are nanoseconds of the host's steady clock
+
+inline u64 gettime()
+{
+    return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline void settime(u64) {}
+
+inline u64 diff_ticks(u64 start, u64 end) { return end - start; }
+inline u64 ticks_to_nanosecs(u64 ticks) { return ticks; }
+inline u64 ticks_to_microsecs(u64 ticks) { return ticks / 1000; }
+inline u64 ticks_to_millisecs(u64 ticks) { return ticks / 1000000; }
+inline u64 ticks_to_secs(u64 ticks) { return ticks / 1000000000; }
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef OGC_SYSTEM_H
+#define OGC_SYSTEM_H
+
+#include <ogc/lwp_watchdog.h>
+
+inline u64 SYS_Time() { return gettime(); }
+
+// Host pointers are used as they are
+#define MEM_PHYSICAL_TO_K0(x) ((void *)(x))
+#define MEM_PHYSICAL_TO_K1(x) ((void *)(x))
+
+#endif
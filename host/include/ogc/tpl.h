@@ -0,0 +1,6 @@
+#ifndef OGC_TPL_H
+#define OGC_TPL_H
+
+// Nothing from this header is used on the host
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef OGC_VIDEO_H
+#define OGC_VIDEO_H
+
+// Nothing from this header is used on the host
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef OGCSYS_H
+#define OGCSYS_H
+
+#include <gccore.h>
+
+#endif
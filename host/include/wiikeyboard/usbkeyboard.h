@@ -0,0 +1,6 @@
+#ifndef WIIKEYBOARD_USBKEYBOARD_H
+#define WIIKEYBOARD_USBKEYBOARD_H
+
+// Nothing from this header is used on the host
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef WIIUSE_WPAD_H
+#define WIIUSE_WPAD_H
+
+// Nothing from this header is used on the host
+
+#endif
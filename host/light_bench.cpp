@@ -0,0 +1,228 @@
+// Runs the light engine on the calling thread over a few typical scenes and checks
+// the result against a brute-force solver that relaxes every block until nothing changes.
+//
+// Usage: light_bench
+// Exits with 1 if the engine leaves any block with a different light than the solver.
+
+#include "headless.hpp"
+
+#include <block/block_base.hpp>
+#include <block/block_id.hpp>
+#include <ported/Random.hpp>
+#include <registry/block_list.hpp>
+#include <world/chunk.hpp>
+#include <world/world.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// The scenes cover the chunks within this radius around the origin
+constexpr int SCENE_RADIUS = 2;
+constexpr int SCENE_BLOCKS = (SCENE_RADIUS * 2 + 1) * 16;
+constexpr int SCENE_MIN = -SCENE_RADIUS * 16;
+constexpr int SCENE_MAX = SCENE_MIN + SCENE_BLOCKS - 1;
+
+static BlockState *block_at(World &world, int x, int y, int z)
+{
+    return world.get_block_at(Vec3i(x, y, z));
+}
+
+static void fill(World &world, int x0, int y0, int z0, int x1, int y1, int z1, BlockID id)
+{
+    for (int y = y0; y <= y1; y++)
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++)
+                if (BlockState *block = block_at(world, x, y, z))
+                    block->blockid = id;
+}
+
+static World *create_scene()
+{
+    World *world = headless::create_world(0);
+    for (int x = -SCENE_RADIUS; x <= SCENE_RADIUS; x++)
+        for (int z = -SCENE_RADIUS; z <= SCENE_RADIUS; z++)
+            headless::add_chunk(*world, x, z);
+    return world;
+}
+
+// Flat ground under open sky
+static void build_plains(World &world)
+{
+    fill(world, SCENE_MIN, 0, SCENE_MIN, SCENE_MAX, 59, SCENE_MAX, BlockID::stone);
+    fill(world, SCENE_MIN, 60, SCENE_MIN, SCENE_MAX, 62, SCENE_MAX, BlockID::dirt);
+    fill(world, SCENE_MIN, 63, SCENE_MIN, SCENE_MAX, 63, SCENE_MAX, BlockID::grass);
+}
+
+// Plains under roofs of stone and leaves, lit from the sides
+static void build_overhangs(World &world)
+{
+    build_plains(world);
+    for (int z = SCENE_MIN; z < SCENE_MAX; z += 20)
+        for (int x = SCENE_MIN; x < SCENE_MAX; x += 20)
+        {
+            fill(world, x, 70, z, x + 13, 71, z + 13, BlockID::stone);
+            fill(world, x + 4, 66, z + 4, x + 9, 66, z + 9, BlockID::leaves);
+        }
+}
+
+// A closed hall in solid stone with a torch every few blocks
+static void build_torch_grid(World &world)
+{
+    fill(world, SCENE_MIN, 0, SCENE_MIN, SCENE_MAX, 100, SCENE_MAX, BlockID::stone);
+    fill(world, SCENE_MIN + 1, 20, SCENE_MIN + 1, SCENE_MAX - 1, 30, SCENE_MAX - 1, BlockID::air);
+    for (int z = SCENE_MIN + 3; z < SCENE_MAX; z += 6)
+        for (int x = SCENE_MIN + 3; x < SCENE_MAX; x += 6)
+            block_at(world, x, 20, z)->blockid = BlockID::torch;
+}
+
+// Winding tunnels in solid stone, a few of them with a shaft to the surface and some torches
+static void build_caves(World &world)
+{
+    fill(world, SCENE_MIN, 0, SCENE_MIN, SCENE_MAX, 90, SCENE_MAX, BlockID::stone);
+    javaport::Random rng(12345);
+    for (int tunnel = 0; tunnel < 24; tunnel++)
+    {
+        int x = SCENE_MIN + rng.nextInt(SCENE_BLOCKS);
+        int y = 20 + rng.nextInt(50);
+        int z = SCENE_MIN + rng.nextInt(SCENE_BLOCKS);
+        for (int step = 0; step < 120; step++)
+        {
+            fill(world, x - 1, y - 1, z - 1, x + 1, y + 1, z + 1, BlockID::air);
+            if (step % 40 == 20)
+                block_at(world, x, std::max(y - 1, 0), z)->blockid = BlockID::torch;
+            x = std::clamp(x + rng.nextInt(3) - 1, SCENE_MIN + 1, SCENE_MAX - 1);
+            y = std::clamp(y + rng.nextInt(3) - 1, 2, 88);
+            z = std::clamp(z + rng.nextInt(3) - 1, SCENE_MIN + 1, SCENE_MAX - 1);
+        }
+        if (tunnel % 4 == 0)
+            fill(world, x, y, z, x + 1, 90, z + 1, BlockID::air);
+    }
+}
+
+// Light of every block in the scene as the reference solver finds it
+struct ReferenceLight
+{
+    std::vector<uint8_t> light;
+    int sweeps = 0;
+    double ms = 0;
+};
+
+static int scene_index(int x, int y, int z)
+{
+    return ((y * SCENE_BLOCKS) + (z - SCENE_MIN)) * SCENE_BLOCKS + (x - SCENE_MIN);
+}
+
+// Starts from the light sources alone and applies the light rule to every block until
+// a sweep changes nothing. Blocks outside the scene are treated as not loaded.
+static ReferenceLight solve_reference(World &world)
+{
+    auto start = std::chrono::steady_clock::now();
+    const int count = SCENE_BLOCKS * SCENE_BLOCKS * WORLD_HEIGHT;
+    std::vector<uint8_t> ids(count);
+    std::vector<uint8_t> sky_source(count);
+    for (int y = 0; y < WORLD_HEIGHT; y++)
+        for (int z = SCENE_MIN; z <= SCENE_MAX; z++)
+            for (int x = SCENE_MIN; x <= SCENE_MAX; x++)
+            {
+                int index = scene_index(x, y, z);
+                Chunk *chunk = world.get_chunk_from_pos(Vec3i(x, 0, z));
+                ids[index] = block_at(world, x, y, z)->id;
+                sky_source[index] = y >= chunk->height_map[(z & 15) << 4 | (x & 15)];
+            }
+
+    ReferenceLight result;
+    result.light.assign(count, 0);
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        result.sweeps++;
+        for (int y = 0; y < WORLD_HEIGHT; y++)
+            for (int z = SCENE_MIN; z <= SCENE_MAX; z++)
+                for (int x = SCENE_MIN; x <= SCENE_MAX; x++)
+                {
+                    int index = scene_index(x, y, z);
+                    BlockBase *block = block_list[ids[index]];
+                    int sky = sky_source[index] ? 15 : 0;
+                    int torch = block->light_luminance();
+                    if (!ids[index] || !block->is_opaque() || block->light_opacity() < 15)
+                    {
+                        int opacity = std::max<int>(block->light_opacity(), 1);
+                        const int neighbors[6][3] = {{x - 1, y, z}, {x + 1, y, z}, {x, y - 1, z}, {x, y + 1, z}, {x, y, z - 1}, {x, y, z + 1}};
+                        for (const int *n : neighbors)
+                        {
+                            if (n[0] < SCENE_MIN || n[0] > SCENE_MAX || n[1] < 0 || n[1] > MAX_WORLD_Y || n[2] < SCENE_MIN || n[2] > SCENE_MAX)
+                                continue;
+                            uint8_t neighbor = result.light[scene_index(n[0], n[1], n[2])];
+                            sky = std::max(sky, (neighbor >> 4) - opacity);
+                            torch = std::max(torch, (neighbor & 15) - opacity);
+                        }
+                    }
+                    uint8_t light = uint8_t(sky << 4 | torch);
+                    if (light != result.light[index])
+                    {
+                        result.light[index] = light;
+                        changed = true;
+                    }
+                }
+    }
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Lights the scene with the engine and returns the number of blocks that differ from the reference.
+static uint32_t run_scene(const char *name, World *world)
+{
+    auto start = std::chrono::steady_clock::now();
+    headless::light_world(*world);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const LightStats &stats = world->light_engine.stats();
+
+    ReferenceLight reference = solve_reference(*world);
+    uint32_t mismatches = 0;
+    for (int y = 0; y < WORLD_HEIGHT; y++)
+        for (int z = SCENE_MIN; z <= SCENE_MAX; z++)
+            for (int x = SCENE_MIN; x <= SCENE_MAX; x++)
+                mismatches += block_at(*world, x, y, z)->light != reference.light[scene_index(x, y, z)];
+
+    std::printf("%-10s %6u updates in %8.1f ms (%6.1f us each), %9llu nodes visited (%5llu per update), peak queue %5u\n", name, stats.updates, ms,
+                stats.updates ? double(stats.total_us) / stats.updates : 0.0, (unsigned long long)stats.total_visited,
+                (unsigned long long)(stats.updates ? stats.total_visited / stats.updates : 0), stats.max_peak_queue);
+    std::printf("%-10s reference took %d sweeps in %.1f ms, %u of %d blocks differ\n", "", reference.sweeps, reference.ms, mismatches, SCENE_BLOCKS * SCENE_BLOCKS * WORLD_HEIGHT);
+    headless::destroy_world(world);
+    return mismatches;
+}
+
+int main()
+{
+    headless::register_game();
+
+    struct Scene
+    {
+        const char *name;
+        void (*build)(World &world);
+    };
+    const Scene scenes[] = {
+        {"plains", build_plains},
+        {"overhangs", build_overhangs},
+        {"torches", build_torch_grid},
+        {"caves", build_caves},
+    };
+
+    uint32_t mismatches = 0;
+    for (const Scene &scene : scenes)
+    {
+        World *world = create_scene();
+        scene.build(*world);
+        mismatches += run_scene(scene.name, world);
+    }
+
+    // Terrain from the world generator, with its caves, lakes and trees
+    World *world = headless::create_world(1);
+    headless::generate_chunks(*world, SCENE_RADIUS);
+    mismatches += run_scene("generated", world);
+
+    return mismatches ? 1 : 0;
+}
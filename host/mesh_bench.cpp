@@ -0,0 +1,131 @@
+// Times the section mesher on the calling thread, the way the chunk manager
+// thread meshes sections when there are no mesh workers, and counts the
+// vertices of generated terrain with and without merging faces.
+//
+// Usage: mesh_bench [iterations]
+
+#include "headless.hpp"
+
+#include <render/render_chunks.hpp>
+#include <world/chunk.hpp>
+#include <world/world.hpp>
+#include <block/block_id.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Section of the center chunk that the scenes are built in
+constexpr int SCENE_SECTION = 4;
+
+// Builds a world of 3x3 empty chunks with a section of stone in the middle. The
+// checkered section leaves every other block out, which exposes every face.
+static World *build_scene(bool checkered)
+{
+    World *world = headless::create_world(0);
+    for (int x = -1; x <= 1; x++)
+        for (int z = -1; z <= 1; z++)
+            headless::add_chunk(*world, x, z);
+    for (int y = 0; y < 16; y++)
+        for (int z = 0; z < 16; z++)
+            for (int x = 0; x < 16; x++)
+                if (!checkered || ((x + y + z) & 1))
+                    world->get_block_at(Vec3i(x, SCENE_SECTION * 16 + y, z))->blockid = BlockID::stone;
+    world->get_chunk(0, 0)->refresh_section_block_visibility(SCENE_SECTION);
+    return world;
+}
+
+static void bench_section(World &world, const char *name, int iterations)
+{
+    Section &section = world.get_chunk(0, 0)->sections[SCENE_SECTION];
+    for (bool smooth : {false, true})
+    {
+        for (bool greedy : {false, true})
+        {
+            world.smooth_lighting = smooth;
+            world.greedy_meshing = greedy;
+            ChunkRenderer::MeshStats &stats = ChunkRenderer::get_mesh_stats(smooth);
+            uint32_t vertices = 0, saved_vertices = 0;
+            double best = 1e9, total = 0;
+            for (int i = 0; i < iterations; i++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                section.mesh_slabs = SECTION_ALL_SLABS;
+                ChunkRenderer::render_section(section, false, section.solid);
+                vertices = stats.last_vertices;
+                saved_vertices = stats.last_saved_vertices;
+                ChunkRenderer::render_section(section, true, section.transparent);
+                double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                best = std::min(best, elapsed);
+                total += elapsed;
+
+                // Swap in the new buffers and free the previous ones, like a frame would
+                section.refresh();
+                vbo_frame_done();
+            }
+            std::printf("%-16s %-6s %-8s %8.1f us best, %8.1f us average, %6u vertices, %6u saved\n", name, smooth ? "smooth" : "flat", greedy ? "greedy" : "faces",
+                        best, total / iterations, vertices, saved_vertices);
+        }
+    }
+}
+
+// Meshes generated terrain with and without merging faces and reports the vertices per section
+// from the mesh statistics, counting only sections that have any vertices.
+static void report_terrain(int radius)
+{
+    World *world = headless::create_world(1);
+    headless::generate_chunks(*world, radius + 1);
+    headless::light_world(*world);
+    for (bool smooth : {false, true})
+    {
+        for (bool greedy : {false, true})
+        {
+            world->smooth_lighting = smooth;
+            world->greedy_meshing = greedy;
+            ChunkRenderer::MeshStats &stats = ChunkRenderer::get_mesh_stats(smooth);
+            uint64_t vertices = 0, saved_vertices = 0;
+            uint32_t sections = 0;
+            for (Chunk *chunk : world->chunks)
+            {
+                if (std::abs(chunk->x) > radius || std::abs(chunk->z) > radius)
+                    continue;
+                for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+                {
+                    Section &section = chunk->sections[i];
+                    chunk->refresh_section_block_visibility(i);
+                    section.mesh_slabs = SECTION_ALL_SLABS;
+                    ChunkRenderer::render_section(section, false, section.solid);
+                    uint32_t section_vertices = stats.last_vertices;
+                    saved_vertices += stats.last_saved_vertices;
+                    ChunkRenderer::render_section(section, true, section.transparent);
+                    section_vertices += stats.last_vertices;
+                    saved_vertices += stats.last_saved_vertices;
+                    section.refresh();
+                    vbo_frame_done();
+                    vertices += section_vertices;
+                    sections += section_vertices != 0;
+                }
+            }
+            std::printf("terrain          %-6s %-8s %6u sections, %6llu vertices per section, %6llu saved per section\n", smooth ? "smooth" : "flat", greedy ? "greedy" : "faces",
+                        sections, (unsigned long long)(sections ? vertices / sections : 0), (unsigned long long)(sections ? saved_vertices / sections : 0));
+        }
+    }
+    headless::destroy_world(world);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    headless::register_game();
+
+    for (bool checkered : {false, true})
+    {
+        World *world = build_scene(checkered);
+        bench_section(*world, checkered ? "checkered 16^3" : "solid 16^3", iterations);
+        headless::destroy_world(world);
+    }
+    report_terrain(2);
+    vbo_frame_done();
+    return 0;
+}
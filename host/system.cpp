@@ -0,0 +1,143 @@
+// Host stand-ins for the libogc threads, mutexes and condition variables, the
+// on-screen debug log and the console libraries the game links against.
+
+#include <ogc/cond.h>
+#include <ogc/lwp.h>
+#include <ogc/mutex.h>
+#include <auxio/oggplayer.h>
+#include <util/debuglog.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Handles index fixed tables, so that a handle can be used while another thread creates one
+constexpr u32 MAX_HANDLES = 4096;
+
+static std::unique_ptr<std::recursive_mutex> mutexes[MAX_HANDLES];
+static std::atomic<u32> mutex_count{0};
+
+static std::unique_ptr<std::condition_variable_any> conds[MAX_HANDLES];
+static std::atomic<u32> cond_count{0};
+
+static std::unique_ptr<std::thread> threads[MAX_HANDLES];
+static std::atomic<u32> thread_count{0};
+
+s32 LWP_MutexInit(mutex_t *mutex, bool)
+{
+    u32 handle = mutex_count++;
+    if (handle >= MAX_HANDLES)
+        return -1;
+    mutexes[handle] = std::make_unique<std::recursive_mutex>();
+    *mutex = handle;
+    return 0;
+}
+
+s32 LWP_MutexDestroy(mutex_t mutex)
+{
+    if (mutex < MAX_HANDLES)
+        mutexes[mutex].reset();
+    return 0;
+}
+
+s32 LWP_MutexLock(mutex_t mutex)
+{
+    mutexes[mutex]->lock();
+    return 0;
+}
+
+s32 LWP_MutexTryLock(mutex_t mutex)
+{
+    return mutexes[mutex]->try_lock() ? 0 : 1;
+}
+
+s32 LWP_MutexUnlock(mutex_t mutex)
+{
+    mutexes[mutex]->unlock();
+    return 0;
+}
+
+s32 LWP_CondInit(cond_t *cond)
+{
+    u32 handle = cond_count++;
+    if (handle >= MAX_HANDLES)
+        return -1;
+    conds[handle] = std::make_unique<std::condition_variable_any>();
+    *cond = handle;
+    return 0;
+}
+
+s32 LWP_CondDestroy(cond_t cond)
+{
+    if (cond < MAX_HANDLES)
+        conds[cond].reset();
+    return 0;
+}
+
+s32 LWP_CondWait(cond_t cond, mutex_t mutex)
+{
+    conds[cond]->wait(*mutexes[mutex]);
+    return 0;
+}
+
+s32 LWP_CondSignal(cond_t cond)
+{
+    conds[cond]->notify_one();
+    return 0;
+}
+
+s32 LWP_CondBroadcast(cond_t cond)
+{
+    conds[cond]->notify_all();
+    return 0;
+}
+
+s32 LWP_CreateThread(lwp_t *thread, void *(*entry)(void *), void *arg, void *, u32, u8)
+{
+    u32 handle = thread_count++;
+    if (handle >= MAX_HANDLES)
+        return -1;
+    threads[handle] = std::make_unique<std::thread>(entry, arg);
+    *thread = handle;
+    return 0;
+}
+
+s32 LWP_JoinThread(lwp_t thread, void **value)
+{
+    if (thread >= MAX_HANDLES || !threads[thread])
+        return -1;
+    threads[thread]->join();
+    threads[thread].reset();
+    if (value)
+        *value = nullptr;
+    return 0;
+}
+
+// The host has no sound device, so music never starts
+int PlayOggFile(const char *, int, int)
+{
+    return -1;
+}
+
+int StatusOgg()
+{
+    return OGG_STATUS_EOF;
+}
+
+// The console build generates this from textures/light_nether.png. The host never enters the nether.
+extern const unsigned char light_nether_rgba[1024] = {0};
+
+namespace debug
+{
+    void print(const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        std::vfprintf(stderr, fmt, args);
+        va_end(args);
+    }
+} // namespace debug
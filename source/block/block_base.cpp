@@ -6,7 +6,7 @@
 #include <world/world.hpp>
 #include <stdexcept>
 
-uint8_t BlockBase::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockBase::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     return face_texture_index(face, world->get_meta_at(pos));
 }
@@ -132,7 +132,7 @@ BlockBase &BlockBase::tool(item::ToolType tool, item::ToolTier tier)
     return *this;
 }
 
-bool BlockBase::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockBase::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     BlockBase *b = block_at(world, pos + block_face[face]);
     AABB bbox = b->aabb();
@@ -156,7 +156,7 @@ uint8_t BlockBase::face_texture_index(uint8_t face, uint8_t meta)
     return data.texture_index;
 }
 
-void BlockBase::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockBase::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
     AABB bbox = aabb();
     bbox.translate(Vec3f(pos.x, pos.y, pos.z));
@@ -330,9 +330,14 @@ bool BlockBase::colored()
     return false;
 }
 
-int BlockBase::render(gertex::DisplayList<gertex::Vertex16> *list, BlockState *state, const Vec3i &pos)
+int BlockBase::render(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *state, const Vec3i &pos)
 {
-    return data.render_func(list, state, pos);
+    return data.render_func(list, snapshot, state, pos);
+}
+
+BlockRenderFunc BlockBase::render_func()
+{
+    return data.render_func;
 }
 
 bool BlockBase::can_stay(World *world, const Vec3i &pos)
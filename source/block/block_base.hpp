@@ -14,10 +14,12 @@
 #include "block_id.hpp"
 
 class World;
+class BlockAccess;
 class EntityPlayer;
 class EntityPhysical;
 class BlockState;
-using BlockRenderFunc = std::function<int(gertex::DisplayList<gertex::Vertex16> *list, BlockState *, const Vec3i &)>;
+struct SectionSnapshot;
+using BlockRenderFunc = int (*)(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *, BlockState *, const Vec3i &);
 
 class BlockBase
 {
@@ -57,10 +59,10 @@ public:
     // Misc state/world related
     virtual uint8_t face_texture_index(uint8_t face, uint8_t meta);
     virtual bool raycastable(uint8_t meta, bool include_fluids);
-    virtual uint8_t texture_index(World *world, const Vec3i &pos, uint8_t face);
+    virtual uint8_t texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face);
     virtual bool can_place(World *world, const Vec3i &pos);
-    virtual bool should_render_side(World *world, const Vec3i &pos, uint8_t face);
-    virtual void get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list);
+    virtual bool should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face);
+    virtual void get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list);
     virtual void get_raycasting_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list);
     virtual void apply_entity_velocity(EntityPhysical *entity, const Vec3i &pos);
     virtual float strength(EntityPlayer *player);
@@ -103,7 +105,8 @@ public:
 
     virtual bool colored();
 
-    int render(gertex::DisplayList<gertex::Vertex16> *list, BlockState *state, const Vec3i &pos);
+    int render(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *state, const Vec3i &pos);
+    BlockRenderFunc render_func();
 
 protected:
     struct Data
@@ -372,8 +372,13 @@ public:
     {
         struct
         {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
             uint8_t sky_light : 4;
             uint8_t block_light : 4;
+#else
+            uint8_t block_light : 4;
+            uint8_t sky_light : 4;
+#endif
         };
 
         uint8_t light;
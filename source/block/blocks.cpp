@@ -45,7 +45,7 @@ uint32_t get_default_texture_index(BlockID blockid)
     return block_texture_index >= 0 ? (block_texture_index & 0xFF) : block_list[uint8_t(blockid)]->face_texture_index(0, 0);
 }
 
-uint32_t get_texture_index(World *world, const Vec3i &pos, uint8_t face, BlockState *block)
+uint32_t get_texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face, BlockState *block)
 {
     if (block_texture_index >= 0)
         return (block_texture_index & 0xFF);
@@ -506,6 +506,69 @@ uint8_t get_fluid_visual_level(World *world, Vec3i pos, BlockID block_id)
     return FLOAT_TO_FLUIDMETA(get_fluid_height(world, pos, block_id));
 }
 
+int get_capped_fluid_level_at(World *world, Vec3i pos, BlockID src_id)
+{
+    BlockState *block = world->get_block_at(pos);
+    if (block && is_same_fluid(block->blockid, src_id))
+    {
+        if (block->meta >= 8)
+            return 0;
+        return block->meta & 0xF;
+    }
+    return -1;
+}
+
+Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos)
+{
+    uint8_t fluid_level = get_capped_fluid_level_at(world, pos, block->blockid);
+    if ((fluid_level & 7) == 0)
+        return Vec3f(0.0, -1.0, 0.0);
+
+    // Used to check block types around the fluid
+    BlockState *neighbors[6];
+    world->get_neighbors(pos, neighbors);
+
+    Vec3f direction = Vec3f(0.0, 0.0, 0.0);
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (i == FACE_NY || i == FACE_PY)
+            continue;
+        if (neighbors[i])
+        {
+            int fl = get_capped_fluid_level_at(world, pos + face_offsets[i], neighbors[i]->blockid);
+            if (fl >= 0)
+            {
+                direction = direction + Vec3f(face_offsets[i].x, 0, face_offsets[i].z) * (fl - fluid_level);
+            }
+            else if (fl < 0 && pos.y > 0 && !is_solid(neighbors[i]->blockid))
+            {
+                fl = get_capped_fluid_level_at(world, pos + face_offsets[i] + Vec3i(0, -1, 0), world->get_block_id_at(pos + face_offsets[i] + Vec3i(0, -1, 0)));
+                if (fl >= 0)
+                {
+                    direction = direction + Vec3f(face_offsets[i].x, 0, face_offsets[i].z) * (fl - fluid_level + 8);
+                }
+            }
+        }
+    }
+
+    if (block->meta >= 8)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (i == FACE_NY || i == FACE_PY)
+                continue;
+            BlockState *above = pos.y < MAX_WORLD_Y ? world->get_block_at(pos + face_offsets[i] + Vec3i(0, 1, 0)) : nullptr;
+            if (neighbors[i] && ((neighbors[i]->visibility_flags & (1 << (i ^ 1))) || (above && (above->visibility_flags & (1 << (i ^ 1))))))
+            {
+                direction.y -= 6.0;
+                break;
+            }
+        }
+    }
+    return direction.fast_normalize();
+}
+
 item::ItemStack default_drop(const BlockState &old_block)
 {
     return item::ItemStack(old_block.id, 1, old_block.meta);
@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <math/vec3i.hpp>
+#include <math/vec3f.hpp>
 
 #include <block/block_properties.hpp>
 #include <block/block_id.hpp>
@@ -13,6 +14,7 @@
 #define FLOAT_TO_FLUIDMETA(A) (int(roundf((A) * 8)))
 class BlockState;
 class Chunk;
+class BlockAccess;
 extern bool render_fast_leaves;
 
 int8_t get_block_opacity(BlockID blockid);
@@ -22,7 +24,7 @@ uint8_t get_block_luminance(BlockID block_id);
 void override_texture_index(int32_t texture_index);
 uint32_t get_default_texture_index(BlockID blockid);
 uint32_t get_face_texture_index(BlockState *block, int face);
-uint32_t get_texture_index(World *world, const Vec3i &pos, uint8_t face, BlockState *block);
+uint32_t get_texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face, BlockState *block);
 
 void schedule_update(World *world, const Vec3i &pos, BlockState &block);
 bool is_solid(BlockID block_id);
@@ -42,6 +44,8 @@ bool can_any_fluid_replace(BlockID id);
 bool can_fluid_replace(BlockID fluid, BlockID id);
 float get_percent_air(int fluid_level);
 float get_fluid_height(World *world, Vec3i pos, BlockID block_type);
+int get_capped_fluid_level_at(World *world, Vec3i pos, BlockID src_id);
+Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos);
 
 Sound get_step_sound(BlockID block_id);
 Sound get_mine_sound(BlockID block_id);
@@ -5,7 +5,7 @@ BlockBookshelf::BlockBookshelf(uint16_t id, uint8_t texture_index) : BlockBase(i
     data.sound_type = BlockSoundType::wood;
 }
 
-uint8_t BlockBookshelf::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockBookshelf::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     return face == +BlockFace::NY || face == +BlockFace::PY ? 4 : 35;
 }
@@ -24,7 +24,7 @@ bool BlockButton::can_place(World *world, const Vec3i &pos)
             block_at(world, {pos.x, pos.y, pos.z + 1})->is_opaque());
 }
 
-void BlockButton::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockButton::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
 
     uint8_t meta = world->get_meta_at(pos);
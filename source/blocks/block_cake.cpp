@@ -33,7 +33,7 @@ bool BlockCake::is_opaque()
     return false;
 }
 
-void BlockCake::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockCake::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
     uint8_t meta = world->get_meta_at(pos);
     AABB bbox = data.aabb;
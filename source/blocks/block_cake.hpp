@@ -9,7 +9,7 @@ public:
 
     virtual uint8_t face_texture_index(uint8_t face, uint8_t meta) override;
     virtual bool is_opaque() override;
-    virtual void get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list);
+    virtual void get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list);
     virtual bool on_use(EntityPhysical *entity, const Vec3i &pos);
     virtual void on_click(EntityPhysical *entity, const Vec3i &pos);
     virtual bool can_stay(World *world, const Vec3i &pos) override;
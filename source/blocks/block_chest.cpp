@@ -14,7 +14,7 @@ BlockChest::BlockChest(uint16_t id) : BlockContainer(id, Materials::WOOD)
     data.render_type = BlockRenderType::full_special;
 }
 
-uint8_t BlockChest::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockChest::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     // Bottom and top faces are always the same
     if (face == +BlockFace::NY || face == +BlockFace::PY)
@@ -77,7 +77,7 @@ uint8_t BlockChest::texture_index(World *world, const Vec3i &pos, uint8_t face)
     return 26;
 }
 
-bool BlockChest::has_neighbor_chest(World *world, const Vec3i &pos)
+bool BlockChest::has_neighbor_chest(BlockAccess *world, const Vec3i &pos)
 {
     return (world->get_block_id_at({pos.x - 1, pos.y, pos.z}) == data.block_id ||
             world->get_block_id_at({pos.x + 1, pos.y, pos.z}) == data.block_id ||
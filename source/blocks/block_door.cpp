@@ -33,7 +33,7 @@ uint8_t BlockDoor::face_texture_index(uint8_t face, uint8_t meta)
     return data.material == Materials::IRON ? 97 : 98;
 }
 
-void BlockDoor::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockDoor::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
     AABB aabb;
     aabb.min = Vec3f(pos.x, pos.y, pos.z);
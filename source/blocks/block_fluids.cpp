@@ -17,14 +17,14 @@ bool BlockFluids::is_opaque()
     return false;
 }
 
-uint8_t BlockFluids::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockFluids::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     if (face == +BlockFace::NY || face == +BlockFace::PY)
         return data.texture_index;
     return data.texture_index + 1;
 }
 
-bool BlockFluids::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockFluids::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     Materials material = block_at(world, pos)->material_type();
     if (material == data.material || material == Materials::ICE)
@@ -80,7 +80,7 @@ void BlockFurnace::set_default_direction(World *world, const Vec3i &pos)
     world->set_meta_at(pos, dir);
 }
 
-uint8_t BlockFurnace::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockFurnace::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     uint8_t meta = world->get_meta_at(pos);
     return face_texture_index(face, meta);
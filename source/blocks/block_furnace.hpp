@@ -7,7 +7,7 @@ class BlockFurnace : public BlockContainer
 public:
     BlockFurnace(uint16_t id, Materials material);
 
-    virtual uint8_t texture_index(World *world, const Vec3i &pos, uint8_t face) override;
+    virtual uint8_t texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face) override;
     virtual uint8_t face_texture_index(uint8_t face, uint8_t meta);
     virtual void on_added(World *world, const Vec3i &pos) override;
     virtual void on_destroyed(World *world, const Vec3i &pos) override;
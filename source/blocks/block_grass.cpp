@@ -7,7 +7,7 @@ BlockGrass::BlockGrass(uint16_t id, uint8_t texture_index, Materials material) :
 {
 }
 
-uint8_t BlockGrass::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockGrass::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     // Check top
     if (face == +BlockFace::NY)
@@ -9,7 +9,7 @@ BlockIce::BlockIce(uint16_t id, uint8_t texture_index, Materials material) : Blo
     data.tick_on_load = true;
 }
 
-bool BlockIce::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockIce::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     return BlockShatterable::should_render_side(world, pos, face);
 }
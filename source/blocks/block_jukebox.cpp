@@ -9,7 +9,7 @@ BlockJukebox::BlockJukebox(uint16_t id, uint8_t texture_index) : BlockBase(id, t
 {
 }
 
-uint8_t BlockJukebox::texture_index(World *world, const Vec3i &pos, uint8_t face)
+uint8_t BlockJukebox::texture_index(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     if (face == +BlockFace::PY)
         return data.texture_index + 1;
@@ -7,7 +7,7 @@ BlockLadder::BlockLadder(uint16_t id, uint8_t texture_index) : BlockBase(id, tex
 {
 }
 
-void BlockLadder::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockLadder::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
     uint8_t meta = world->get_meta_at(pos);
 
@@ -14,7 +14,7 @@ bool BlockLeaves::is_opaque()
     return false;
 }
 
-bool BlockLeaves::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockLeaves::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     return render_fast_leaves ? BlockBase::should_render_side(world, pos, face) : (world->get_block_id_at(pos) == data.block_id);
 }
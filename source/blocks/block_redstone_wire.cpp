@@ -345,7 +345,7 @@ int BlockRedstoneWire::max_current_strength(World *world, const Vec3i &pos, int
     return meta > other ? meta : other;
 }
 
-bool BlockRedstoneWire::is_source_or_wire(World *world, const Vec3i &pos)
+bool BlockRedstoneWire::is_source_or_wire(BlockAccess *world, const Vec3i &pos)
 {
     BlockBase *block = block_at(world, pos);
     return (block->block_id() == BlockID::redstone_wire || block->is_power_source());
@@ -37,5 +37,5 @@ public:
     void notify_wire_neighbors(World *world, const Vec3i &pos);
     int max_current_strength(World *world, const Vec3i &pos, int other);
 
-    static bool is_source_or_wire(World *world, const Vec3i &pos);
+    static bool is_source_or_wire(BlockAccess *world, const Vec3i &pos);
 };
\ No newline at end of file
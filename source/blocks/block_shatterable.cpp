@@ -12,7 +12,7 @@ bool BlockShatterable::is_opaque()
     return false;
 }
 
-bool BlockShatterable::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockShatterable::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     BlockID block_id = world->get_block_id_at(pos + block_face[face]);
     if (block_id == data.id)
@@ -8,5 +8,5 @@ public:
     BlockShatterable(uint16_t id, uint8_t texture_index, Materials material);
 
     virtual bool is_opaque() override;
-    virtual bool should_render_side(World *world, const Vec3i &pos, uint8_t face) override;
+    virtual bool should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face) override;
 };
\ No newline at end of file
@@ -14,7 +14,7 @@ bool BlockSlab::is_opaque()
     return is_double_slab;
 }
 
-bool BlockSlab::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockSlab::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     BlockBase *b = block_at(world, pos + block_face[face]);
     std::vector<AABB> aabbs;
@@ -73,7 +73,7 @@ uint16_t BlockSlab::drop_count(javaport::Random &random)
     return is_double_slab ? 2 : 1;
 }
 
-void BlockSlab::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockSlab::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
     BlockState *block = world->get_block_at(pos);
     AABB aabb;
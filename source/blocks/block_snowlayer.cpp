@@ -19,7 +19,7 @@ bool BlockSnowLayer::is_opaque()
     return false;
 }
 
-bool BlockSnowLayer::should_render_side(World *world, const Vec3i &pos, uint8_t face)
+bool BlockSnowLayer::should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face)
 {
     if (face == +BlockFace::PY)
         return true;
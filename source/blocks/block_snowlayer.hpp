@@ -8,7 +8,7 @@ class BlockSnowLayer : public BlockBase
 public:
     BlockSnowLayer(uint16_t id, uint8_t texture_index, Materials material);
     virtual bool is_opaque() override;
-    virtual bool should_render_side(World *world, const Vec3i &pos, uint8_t face) override;
+    virtual bool should_render_side(BlockAccess *world, const Vec3i &pos, uint8_t face) override;
     virtual bool can_place(World *world, const Vec3i &pos) override;
     virtual bool can_stay(World *world, const Vec3i &pos) override;
     virtual void on_neighbor_changed(World *world, const Vec3i &pos, uint8_t neighbor_face) override;
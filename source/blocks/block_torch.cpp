@@ -15,7 +15,7 @@ bool BlockTorch::is_opaque()
     return false;
 }
 
-void BlockTorch::get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
+void BlockTorch::get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list)
 {
 }
 
@@ -7,7 +7,7 @@ class BlockTorch : public BlockBase
 public:
     BlockTorch(uint16_t id, uint8_t texture_index);
     virtual bool is_opaque() override;
-    virtual void get_colliding_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list) override;
+    virtual void get_colliding_aabb(BlockAccess *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list) override;
     virtual void get_raycasting_aabb(World *world, const Vec3i &pos, const AABB &other, std::vector<AABB> &aabb_list) override;
     
     virtual bool can_stay(World *world, const Vec3i &pos) override;
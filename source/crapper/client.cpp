@@ -106,7 +106,7 @@ namespace Crapper
         size_t offset = 0;
         while (offset < buffer.size())
         {
-            size_t length = std::min(buffer.size() - offset, 512U);
+            size_t length = std::min(buffer.size() - offset, size_t(512));
 
             int sent = net_write(sockfd, &buffer.ptr()[offset], length);
             if (sent < 0)
@@ -1441,7 +1441,7 @@ namespace Crapper
                     // Update the VBOs of the neighboring chunks
                     for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
                     {
-                        neighbor->sections[i].dirty = true;
+                        neighbor->sections[i].mark_dirty();
                     }
                 }
             }
@@ -1451,6 +1451,7 @@ namespace Crapper
         if (!chunk_exists)
         {
             remote_world->chunks.push_back(chunk);
+            remote_world->visibility_generation++;
             uint64_t key = uint32_pair(chunk->x, chunk->z);
             remote_world->chunk_cache.insert_or_assign(key, chunk);
         }
@@ -7,6 +7,7 @@
 #include <new>
 #include <ogc/gx.h>
 #include <util/unaligned.hpp>
+#include <gertex/gertex.hpp>
 
 namespace gertex
 {
@@ -130,6 +131,7 @@ namespace gertex
 
         virtual void begin(uint8_t primitive) override
         {
+            count_primitive(this->max_vertices);
             GX_Begin(primitive, GX_VTXFMT0, this->max_vertices);
         }
         virtual void put(const T &t) override = 0;
@@ -162,6 +164,7 @@ namespace gertex
             if (!vertices)
                 return;
             // Write begin command
+            count_primitive(vertices);
             GX_Begin(*this->buffer, GX_VTXFMT0, vertices);
             T t;
             while (this->read_ptr < this->ptr)
@@ -174,6 +177,48 @@ namespace gertex
         }
     };
 
+    // Writes the texture coordinates of Vertex16 as unsigned 16-bit fixed point
+    // instead of floats. The list is tagged with the given vertex format, which
+    // must load TEX0 as GX_U16 with the same number of fractional bits.
+    struct DisplayListCompact16 : public DisplayList<Vertex16>
+    {
+        uint8_t vertex_format;
+        float uv_scale;
+
+        DisplayListCompact16(uint16_t max_vertices, uint32_t attrib_size, uint8_t vertex_format, uint8_t uv_frac_bits) : DisplayList<Vertex16>(max_vertices, attrib_size)
+        {
+            this->start_copy_len = attrib_size - 5;
+            this->vertex_format = vertex_format;
+            this->uv_scale = float(1 << uv_frac_bits);
+        }
+
+        virtual void begin(uint8_t primitive) override
+        {
+            DisplayList<Vertex16>::begin(primitive | vertex_format);
+        }
+
+        virtual void put(const Vertex16 &t) override
+        {
+            if (size() + attrib_size > capacity())
+                throw std::overflow_error("DisplayList overflow");
+            std::memcpy(ptr, &t, start_copy_len);
+            ptr[start_copy_len] = t.nrm;
+            uint16_t uv[2] = {quantize(t.u), quantize(t.v)};
+            std::memcpy(&ptr[start_copy_len + 1], uv, 4);
+            ptr += attrib_size;
+        }
+
+        uint16_t quantize(float value)
+        {
+            float scaled = value * uv_scale + 0.5f;
+            if (scaled <= 0.0f)
+                return 0;
+            if (scaled >= 65535.0f)
+                return 65535;
+            return uint16_t(scaled);
+        }
+    };
+
     struct DisplayListPassF : public DisplayListPass<Vertex>
     {
         DisplayListPassF(uint16_t max_vertices, uint32_t attrib_size) : DisplayListPass<Vertex>(max_vertices, attrib_size) {}
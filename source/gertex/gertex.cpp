@@ -5,6 +5,9 @@
 namespace gertex
 {
     GXState state;
+    GXStats current_stats;
+    GXStats frame_stats;
+    bool recording = false;
 
     void set_state(const GXState &new_state)
     {
@@ -387,6 +390,65 @@ namespace gertex
         GX_SetLineWidth(16, GX_VTXFMT0);
     }
 
+    void call_display_list(void *buffer, uint32_t length, uint32_t vertex_size)
+    {
+        current_stats.draw_calls++;
+        current_stats.display_list_bytes += length;
+
+        // Walk the primitive headers: the command with the vertex format, then the vertex count.
+        // Padding can appear between primitives, not just at the end of the list.
+        const uint8_t *data = static_cast<const uint8_t *>(buffer);
+        uint32_t offset = 0;
+        while (offset < length)
+        {
+            if (data[offset] == GX_NOP)
+            {
+                offset++;
+                continue;
+            }
+            if (!(data[offset] & 0x80) || offset + 3 > length)
+                break;
+
+            // The count is written by the CPU that built the list, so it is in its byte order
+            uint16_t vertices;
+            std::memcpy(&vertices, &data[offset + 1], 2);
+            current_stats.primitives++;
+            current_stats.vertices += vertices;
+            offset += 3 + vertices * vertex_size;
+        }
+
+        GX_CallDispList(buffer, length);
+    }
+
+    void count_primitive(uint16_t vertices)
+    {
+        if (recording)
+            return;
+        current_stats.primitives++;
+        current_stats.vertices += vertices;
+    }
+
+    void begin_recording()
+    {
+        recording = true;
+    }
+
+    void end_recording()
+    {
+        recording = false;
+    }
+
+    void end_frame()
+    {
+        frame_stats = current_stats;
+        current_stats = GXStats();
+    }
+
+    const GXStats &get_frame_stats()
+    {
+        return frame_stats;
+    }
+
     void init(GXRModeObj *rmode, float fov, float near, float far, bool apply_defaults)
     {
         gx_init(rmode);
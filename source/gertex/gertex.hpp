@@ -141,6 +141,15 @@ namespace gertex
         GXVtxAttrFmt desc[GX_MAX_VTXATTRFMT_LISTSIZE] = {};
     };
 
+    // Geometry submitted during a frame
+    struct GXStats
+    {
+        uint32_t draw_calls = 0;         // Display lists called
+        uint32_t display_list_bytes = 0; // Bytes of the called display lists
+        uint32_t primitives = 0;         // Primitive groups, one for each GX_Begin
+        uint32_t vertices = 0;
+    };
+
     class GXState
     {
     public:
@@ -191,6 +200,22 @@ namespace gertex
     GXColor get_color_mul();
     void set_alpha_cutoff(uint8_t cutoff);
     uint8_t get_alpha_cutoff();
+
+    // Calls the display list and counts the primitives in it. The list must only hold
+    // primitives of vertex_size bytes per vertex and GX_NOP padding between or after them.
+    void call_display_list(void *buffer, uint32_t length, uint32_t vertex_size);
+
+    // Counts a primitive that is sent directly instead of through a display list.
+    void count_primitive(uint16_t vertices);
+
+    // Primitives sent between these calls are recorded into a display list instead of
+    // being drawn, so they are not counted. The list counts them when it is called.
+    void begin_recording();
+    void end_recording();
+
+    // Starts counting a new frame. The counts of the finished frame are kept for get_frame_stats.
+    void end_frame();
+    const GXStats &get_frame_stats();
 } // namespace gertex
 
 inline bool operator==(const GXColor &lhs, const GXColor &rhs)
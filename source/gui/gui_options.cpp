@@ -33,6 +33,7 @@ GuiOptions::GuiOptions()
     add_toggle_button("smooth_lighting", "Smooth lighting");
     add_toggle_button("fast_leaves", "Fast leaves");
     add_toggle_button("sync_chunk_updates", "Sync chunk updates");
+    add_toggle_button("greedy_meshing", "Greedy meshing");
 
     buttons.push_back(new GuiButton((view.width - 400) / 2, view.height * view.aspect_correction - 48, 400, 40, "Done", std::bind(&GuiOptions::quit_to_title, this)));
 }
@@ -11,6 +11,7 @@
 #include <util/config.hpp>
 #include <util/timers.hpp>
 #include <render/render_gui.hpp>
+#include <render/render_chunks.hpp>
 #include <gui/gui_survival.hpp>
 #include <gui/gui_dirtscreen.hpp>
 #include <gui/gui_titlescreen.hpp>
@@ -152,6 +153,11 @@ void MainGameLoop()
     render_fast_leaves = fast_leaves;
     current_world->sync_section_updates = ((int)config.get("sync_chunk_updates", 0) != 0);
     current_world->smooth_lighting = smooth_lighting;
+    current_world->greedy_meshing = ((int)config.get("greedy_meshing", 0) != 0);
+    current_world->mesh_workers = (int)config.get("mesh_workers", 1);
+    current_world->far_terrain = ((int)config.get("far_terrain", 0) != 0);
+    current_world->set_particle_capacity((int)config.get("particle_capacity", PARTICLE_DEFAULT_CAPACITY));
+    vbo_configure(uint32_t((int)config.get("vbo_arena_mb", VBO_ARENA_SIZE >> 20)) << 20, ((int)config.get("vbo_heap_fallback", 0) != 0));
 
     // Generate a "unique" username based on the device ID
     uint32_t dev_id = 0;
@@ -181,23 +187,36 @@ void MainGameLoop()
             current_world->create();
         }
     }
-    Lock lock(render_mutex);
-    lock.unlock();
-
     bool in_game = true;
 
+    // Sky factor the light map was last blended for, -1 if it needs blending
+    int light_map_blended = -1;
+
     // Begin the main loop
     while (!isExiting && in_game && HWButton == -1)
     {
         uint64_t frame_start = time_get();
 
-        // Update the light map
+        // Swap in the sections that finished meshing since the last frame
+        current_world->swap_section_buffers();
+
+        // Update the light map when the sky brightness changes. The nether light map is set by the world.
         if (!current_world->hell)
         {
-            LightMapBlend(mono_lighting ? light_day_mono_rgba : light_day_rgba, mono_lighting ? light_night_mono_rgba : light_night_rgba, light_map, 255 - uint8_t(get_sky_multiplier() * 255));
+            int light_map_factor = 255 - uint8_t(get_sky_multiplier() * 255);
+            if (light_map_factor != light_map_blended)
+            {
+                LightMapBlend(mono_lighting ? light_day_mono_rgba : light_day_rgba, mono_lighting ? light_night_mono_rgba : light_night_rgba, light_map, light_map_factor);
+                DCFlushRange(light_map, sizeof(light_map));
+                GX_SetArray(GX_VA_CLR0, light_map, 4 * sizeof(u8));
+                GX_InvVtxCache();
+                light_map_blended = light_map_factor;
+            }
+        }
+        else
+        {
+            light_map_blended = -1;
         }
-        GX_SetArray(GX_VA_CLR0, light_map, 4 * sizeof(u8));
-        GX_InvVtxCache();
 
         GetInput();
 
@@ -222,7 +241,6 @@ void MainGameLoop()
         state = gertex::get_state();
         gertex::perspective(state.view);
         // Draw the scene
-        lock.lock();
         if (current_world->loaded)
         {
             UpdateFog();
@@ -239,7 +257,10 @@ void MainGameLoop()
 
         HandleGUI(state.view);
         GX_DrawDone();
-        lock.unlock();
+        gertex::end_frame();
+
+        // The GPU is done with this frame, release the display lists retired during it
+        vbo_frame_done();
 
         GX_CopyDisp(frameBuffer[fb], GX_TRUE);
 #ifdef DEBUG
@@ -284,6 +305,10 @@ void MainGameLoop()
     delete current_world;
     current_world = nullptr;
 
+    // Nothing is being drawn anymore, so the display list arena can go back to the heap
+    vbo_frame_done();
+    vbo_release_arena();
+
     config.save();
 }
 
@@ -686,6 +711,65 @@ void DrawDebugInfo(gertex::GXView &viewport)
     std::string widescreen_str = viewport.widescreen ? " Widescreen" : "";
     Gui::draw_text_with_shadow(0, viewport.ystart + 32, resolution_str + widescreen_str);
 
+    // Average section meshing time with smooth lighting on and off
+    ChunkRenderer::MeshStats &smooth_stats = ChunkRenderer::get_mesh_stats(true);
+    ChunkRenderer::MeshStats &flat_stats = ChunkRenderer::get_mesh_stats(false);
+    ChunkRenderer::MeshStats &current_stats = ChunkRenderer::get_mesh_stats(current_world && current_world->smooth_lighting);
+    std::string mesh_str = "Mesh: " + std::to_string(smooth_stats.average_us) + " us smooth, " + std::to_string(flat_stats.average_us) + " us flat, " +
+                           std::to_string(current_stats.average_vertices) + " verts, " + std::to_string(current_stats.average_saved_vertices) + " merged";
+    Gui::draw_text_with_shadow(0, viewport.ystart + 48, mesh_str);
+
+    if (current_world)
+    {
+        // Light engine statistics of the most recent update
+        const LightStats &light_stats = current_world->light_engine.stats();
+        std::string light_str = "Light: " + std::to_string(light_stats.last_visited) + " nodes, " +
+                                std::to_string(light_stats.last_peak_queue) + " queue (max " + std::to_string(light_stats.max_peak_queue) + "), " +
+                                std::to_string(light_stats.last_us) + " us, " + std::to_string(light_stats.updates) + " updates, " +
+                                std::to_string(light_stats.total_visited) + " nodes in " + std::to_string(light_stats.total_us / 1000) + " ms";
+#ifdef LIGHT_ENGINE_VERIFY
+        light_str += ", " + std::to_string(light_stats.mismatches) + " unsettled";
+#endif
+        Gui::draw_text_with_shadow(0, viewport.ystart + 64, light_str);
+    }
+
+    // Memory held by section display lists and the mesher scratch buffers
+    VBOStats vbo_stats = get_vbo_stats();
+    std::string vbo_str = "VBO: " + std::to_string(vbo_stats.bytes >> 10) + " KB in " + std::to_string(vbo_stats.buffers) +
+                          " lists (peak " + std::to_string(vbo_stats.peak_bytes >> 10) + " KB), retired " +
+                          std::to_string(vbo_stats.retired_bytes >> 10) + " KB, scratch " +
+                          std::to_string(ChunkRenderer::get_scratch_size() >> 10) + " KB";
+    Gui::draw_text_with_shadow(0, viewport.ystart + 80, vbo_str);
+
+    // Use of the display list arena. A small largest block means the arena is fragmented.
+    std::string arena_str = "Arena: " + std::to_string(vbo_stats.arena_used >> 10) + "/" + std::to_string(vbo_stats.arena_size >> 10) + " KB, largest free " +
+                            std::to_string(vbo_stats.arena_largest_free >> 10) + " KB, heap " + std::to_string(vbo_stats.heap_bytes >> 10) + " KB";
+    if (vbo_stats.failed_allocs)
+        arena_str += ", " + std::to_string(vbo_stats.failed_allocs) + " dropped";
+    Gui::draw_text_with_shadow(0, viewport.ystart + 112, arena_str);
+
+    if (current_world)
+    {
+        // Cave culling search cost and how often the previous result was reused
+        const VisibilityStats &vis_stats = current_world->visibility_stats();
+        std::string vis_str = "Vis: " + std::to_string(vis_stats.average_us) + " us, " + std::to_string(vis_stats.last_visited) + " sections, " +
+                              std::to_string(vis_stats.searches) + " searches, " + std::to_string(vis_stats.skipped) + " skipped, cull " +
+                              std::to_string(vis_stats.cull_us) + " us, " + std::to_string(vis_stats.culled_columns) + "/" + std::to_string(vis_stats.partial_columns) + " columns out/partial";
+        Gui::draw_text_with_shadow(0, viewport.ystart + 96, vis_str);
+
+        // Time spent on particles during the last frame
+        const ParticleStats &particle_stats = current_world->particle_stats();
+        std::string particle_str = "Particles: " + std::to_string(particle_stats.visible) + ", " + std::to_string(particle_stats.dropped) + " dropped, update " +
+                                   std::to_string(particle_stats.update_us) + " us, render " + std::to_string(particle_stats.render_us) + " us";
+        Gui::draw_text_with_shadow(0, viewport.ystart + 128, particle_str);
+    }
+
+    // Geometry sent to the GPU during the last frame
+    const gertex::GXStats &gx_stats = gertex::get_frame_stats();
+    std::string gx_str = "GX: " + std::to_string(gx_stats.draw_calls) + " calls, " + std::to_string(gx_stats.primitives) + " prims, " +
+                         std::to_string(gx_stats.vertices) + " verts, " + std::to_string(gx_stats.display_list_bytes >> 10) + " KB";
+    Gui::draw_text_with_shadow(0, viewport.ystart + 144, gx_str);
+
     if (current_world && current_world->player.chunk)
     {
         BlockState *block = current_world->get_block_at(current_world->player.get_foot_blockpos());
@@ -773,7 +857,8 @@ void UpdateFog()
     fog.color = background;
 
     // Set fog near and far distances
-    fog.start = fog_multiplier * fog_depth_multiplier * FOG_DISTANCE * 0.5f;
+    float fog_distance = current_world->far_terrain ? FAR_FOG_DISTANCE : FOG_DISTANCE;
+    fog.start = fog_multiplier * fog_depth_multiplier * fog_distance * 0.5f;
     fog.end = fog.start * 2.0f;
 
     // Enable fog
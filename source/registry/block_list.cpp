@@ -38,6 +38,7 @@
 #include <blocks/block_note.hpp>
 #include <blocks/block_redstone_wire.hpp>
 
+#include <render/render_blocks.hpp>
 #include <world/world.hpp>
 #include <algorithm>
 
@@ -145,10 +146,12 @@ namespace registry
             if (!block_list[i])
                 block_list[i] = new BlockBase(i, 0, Materials::AIR);
         }
+
+        build_block_mesh_table();
     }
 }
 
-BlockBase *block_at(World *world, const Vec3i &pos)
+BlockBase *block_at(BlockAccess *world, const Vec3i &pos)
 {
     BlockBase *block = block_list[world->get_block_id_at(pos)];
 
@@ -8,5 +8,6 @@ namespace registry {
 }
 
 class World;
+class BlockAccess;
 extern BlockBase *block_list[256];
-BlockBase *block_at(World *world, const Vec3i &pos);
\ No newline at end of file
+BlockBase *block_at(BlockAccess *world, const Vec3i &pos);
\ No newline at end of file
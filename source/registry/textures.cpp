@@ -22,6 +22,9 @@ GXTexObj crafting_texture;
 GXTexObj furnace_texture;
 GXTexObj gui_texture;
 
+GXTexObj terrain_tile_map;
+uint16_t terrain_tile_size = 0;
+
 // Animated textures
 WaterTexAnim water_still_anim;
 LavaTexanim lava_still_anim;
@@ -37,7 +40,7 @@ namespace registry
         init_png_texture(sun_texture, "terrain/sun.png");
         init_png_texture(moon_texture, "terrain/moon.png");
         init_png_texture(particles_texture, "particles.png");
-        init_png_texture(terrain_texture, "terrain.png", 3);
+        init_terrain_texture(terrain_texture, "terrain.png", 3);
         init_png_texture(icons_texture, "gui/icons.png");
         init_png_texture(container_texture, "gui/container.png");
         init_png_texture(underwater_texture, "misc/water.png");
@@ -102,4 +105,44 @@ namespace registry
         }
     }
 
+    void init_terrain_texture(GXTexObj &texture, const std::string &filename, uint32_t mipmap_levels)
+    {
+        terrain_tile_size = 0;
+        try
+        {
+            pnguin::PNGFile png_file(RESOURCES_DIR "textures/" + filename);
+
+            // The tile map is looked up at most at 1/256 of the atlas coordinates, so tiles can
+            // only be repeated in a 256x256 atlas of 16x16 tiles
+            if (png_file.get_width() == 256 && png_file.get_height() == 256)
+                terrain_tile_size = 16;
+
+            png_file.to_tpl(texture, mipmap_levels);
+        }
+        catch (std::runtime_error &e)
+        {
+            printf("Failed to load %s: %s\n", filename.c_str(), e.what());
+            init_missing_texture(texture);
+        }
+
+        // 16x16 IA8 texture, stored in blocks of 4x4 texels. It does not depend on the atlas, so it is only built once.
+        static uint8_t *map_buf = nullptr;
+        if (!map_buf)
+        {
+            map_buf = new (std::align_val_t(32)) uint8_t[512];
+            for (int y = 0; y < 16; y++)
+            {
+                for (int x = 0; x < 16; x++)
+                {
+                    uint8_t *texel = map_buf + (((y >> 2) << 2) + (x >> 2)) * 32 + (((y & 3) << 2) + (x & 3)) * 2;
+                    texel[0] = x; // Alpha
+                    texel[1] = y; // Intensity
+                }
+            }
+            DCFlushRange(map_buf, 512);
+        }
+        GX_InitTexObj(&terrain_tile_map, map_buf, 16, 16, GX_TF_IA8, GX_CLAMP, GX_CLAMP, GX_FALSE);
+        GX_InitTexObjFilterMode(&terrain_tile_map, GX_NEAR, GX_NEAR);
+    }
+
 } // namespace registry
\ No newline at end of file
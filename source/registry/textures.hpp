@@ -11,6 +11,7 @@ namespace registry
     void register_textures();
     void init_missing_texture(GXTexObj &texture);
     void init_png_texture(GXTexObj &texture, const std::string &filename, uint32_t mipmap_levels = 0);
+    void init_terrain_texture(GXTexObj &texture, const std::string &filename, uint32_t mipmap_levels = 0);
 } // namespace registry
 
 extern GXTexObj white_texture;
@@ -32,6 +33,13 @@ extern GXTexObj crafting_texture;
 extern GXTexObj furnace_texture;
 extern GXTexObj gui_texture;
 
+// Indirect texture that maps the terrain atlas to its 16x16 tiles, with the
+// column of each tile in alpha and the row in intensity. See use_tiled_terrain.
+extern GXTexObj terrain_tile_map;
+
+// Size of a terrain tile in texels, or 0 if the atlas is not laid out so that its tiles can be repeated
+extern uint16_t terrain_tile_size;
+
 // Animated textures
 extern WaterTexAnim water_still_anim;
 extern LavaTexanim lava_still_anim;
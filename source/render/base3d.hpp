@@ -30,6 +30,22 @@ constexpr uint8_t BASE3D_COLOR_BYTES = 1;
 constexpr uint32_t VERTEX_ATTR_LENGTH = (3 * sizeof(int16_t) + 1 * sizeof(uint8_t) + 1 * sizeof(uint8_t) + 2 * sizeof(float));
 constexpr uint32_t VERTEX_ATTR_LENGTH_FLOATPOS = (3 * sizeof(float) + 1 * sizeof(uint8_t) + 1 * sizeof(uint8_t) + 2 * sizeof(float));
 constexpr uint32_t VERTEX_ATTR_LENGTH_DIRECTCOLOR = (3 * sizeof(int16_t) + 1 * sizeof(uint8_t) + 4 * sizeof(uint8_t) + 2 * sizeof(float));
+constexpr uint32_t VERTEX_ATTR_LENGTH_FLOATPOS_DIRECTCOLOR = (3 * sizeof(float) + 4 * sizeof(uint8_t) + 1 * sizeof(uint8_t) + 2 * sizeof(float));
+
+// Section meshes store their texture coordinates as 16-bit fixed point in a vertex format of their own.
+constexpr uint8_t BASE3D_TERRAIN_UV_FRAC_BITS = 15;
+constexpr uint8_t BASE3D_TERRAIN_VTXFMT = GX_VTXFMT1;
+constexpr uint32_t VERTEX_ATTR_LENGTH_TERRAIN = (3 * sizeof(int16_t) + 1 * sizeof(uint8_t) + 1 * sizeof(uint8_t) + 2 * sizeof(uint16_t));
+constexpr uint32_t VERTEX_ATTR_LENGTH_TERRAIN_DIRECTCOLOR = (3 * sizeof(int16_t) + 4 * sizeof(uint8_t) + 1 * sizeof(uint8_t) + 2 * sizeof(uint16_t));
+
+// Faces merged by greedy meshing repeat their tile, see use_tiled_terrain. Their texture coordinates
+// hold the column and row of the tile in whole texture sizes plus the position within the face, where
+// each block is a 16th of the texture. The larger range needs fewer fractional bits.
+constexpr uint8_t BASE3D_TILED_UV_FRAC_BITS = 11;
+constexpr uint8_t BASE3D_TILED_VTXFMT = GX_VTXFMT2;
+
+// Offset of the light index within a terrain vertex
+constexpr uint32_t VERTEX_ATTR_OFFSET_TERRAIN_LIGHT = 3 * sizeof(int16_t);
 
 class Vertex
 {
@@ -69,7 +85,10 @@ inline void GX_BeginGroup(uint8_t primitive, uint16_t vtxcount = 0)
     __group_vtxcount = 0;
     base3d_is_drawing = vtxcount;
     if (base3d_is_drawing)
+    {
+        gertex::count_primitive(vtxcount);
         GX_Begin(primitive, GX_VTXFMT0, vtxcount);
+    }
 }
 
 inline uint16_t GX_EndGroup()
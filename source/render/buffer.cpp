@@ -1,5 +1,12 @@
 #include "buffer.hpp"
 
+#include <new>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <util/lock.hpp>
+#include <util/debuglog.hpp>
+
 uint8_t *buffer = nullptr;
 uint32_t length = 0;
 
@@ -36,8 +43,319 @@ void VBO::clear()
 {
     if (this->buffer)
     {
-        delete[] this->buffer;
+        vbo_retire(this->buffer, this->length);
         this->buffer = nullptr;
     }
     this->length = 0;
 }
+
+struct RetiredVBO
+{
+    uint8_t *buffer;
+    uint32_t length;
+    uint32_t frame;
+};
+
+static VBOStats vbo_stats;
+static mutex_t vbo_mutex = LWP_MUTEX_NULL;
+
+// Buffers waiting for the frame they were retired in to finish, oldest first
+static std::vector<RetiredVBO> vbo_retired;
+static uint32_t vbo_frame = 0;
+
+// Buffers being freed by vbo_frame_done, kept to reuse its capacity
+static std::vector<RetiredVBO> vbo_done;
+
+// Free blocks keep their size and the offsets of their neighbours on the free
+// list in their first bytes, and their size again in the last 4 bytes
+struct FreeVBOBlock
+{
+    uint32_t size;
+    uint32_t prev;
+    uint32_t next;
+};
+
+#define VBO_NO_BLOCK 0xFFFFFFFF
+
+static uint8_t *vbo_arena = nullptr;
+static uint32_t vbo_arena_size = VBO_ARENA_SIZE;
+static bool vbo_heap_fallback = false;
+
+// One free list per size class, class n holds the blocks of 2^n up to 2^(n+1) - 1 units
+static uint32_t vbo_free_lists[VBO_CLASS_COUNT];
+static uint32_t vbo_free_classes = 0;
+
+// One bit per unit, set on the first and the last unit of every free block
+static uint32_t *vbo_free_edges = nullptr;
+
+static FreeVBOBlock *vbo_block(uint32_t offset)
+{
+    return (FreeVBOBlock *)(vbo_arena + offset);
+}
+
+static int vbo_size_class(uint32_t size)
+{
+    return 31 - __builtin_clz(size / VBO_MIN_BLOCK);
+}
+
+static bool vbo_is_edge(uint32_t offset)
+{
+    uint32_t unit = offset / VBO_MIN_BLOCK;
+    return vbo_free_edges[unit >> 5] & (1U << (unit & 31));
+}
+
+static void vbo_set_edges(uint32_t offset, uint32_t size, bool free)
+{
+    for (uint32_t unit : {offset / VBO_MIN_BLOCK, (offset + size) / VBO_MIN_BLOCK - 1})
+    {
+        if (free)
+            vbo_free_edges[unit >> 5] |= 1U << (unit & 31);
+        else
+            vbo_free_edges[unit >> 5] &= ~(1U << (unit & 31));
+    }
+}
+
+static void vbo_push_free(uint32_t offset, uint32_t size)
+{
+    int size_class = vbo_size_class(size);
+    FreeVBOBlock *block = vbo_block(offset);
+    block->size = size;
+    block->prev = VBO_NO_BLOCK;
+    block->next = vbo_free_lists[size_class];
+    if (block->next != VBO_NO_BLOCK)
+        vbo_block(block->next)->prev = offset;
+    vbo_free_lists[size_class] = offset;
+    vbo_free_classes |= 1U << size_class;
+    std::memcpy(vbo_arena + offset + size - 4, &size, 4);
+    vbo_set_edges(offset, size, true);
+}
+
+static void vbo_remove_free(uint32_t offset)
+{
+    FreeVBOBlock *block = vbo_block(offset);
+    int size_class = vbo_size_class(block->size);
+    if (block->prev != VBO_NO_BLOCK)
+        vbo_block(block->prev)->next = block->next;
+    else
+        vbo_free_lists[size_class] = block->next;
+    if (block->next != VBO_NO_BLOCK)
+        vbo_block(block->next)->prev = block->prev;
+    if (vbo_free_lists[size_class] == VBO_NO_BLOCK)
+        vbo_free_classes &= ~(1U << size_class);
+    vbo_set_edges(offset, block->size, false);
+}
+
+// Creates the arena with the configured size. Expects vbo_mutex to be held.
+static void vbo_create_arena()
+{
+    uint32_t units = vbo_arena_size / VBO_MIN_BLOCK;
+    vbo_arena = new (std::align_val_t(32)) uint8_t[vbo_arena_size];
+    vbo_free_edges = new uint32_t[(units + 31) / 32]();
+    for (uint32_t &list : vbo_free_lists)
+        list = VBO_NO_BLOCK;
+    vbo_free_classes = 0;
+    vbo_push_free(0, vbo_arena_size);
+    vbo_stats.arena_size = vbo_arena_size;
+}
+
+// Returns a block from the arena or nullptr if there is none large enough. Expects vbo_mutex to be held.
+static uint8_t *vbo_arena_alloc(uint32_t length)
+{
+    if (!vbo_arena)
+        vbo_create_arena();
+
+    // The first block of the same class that fits, as the lists of a section are often
+    // rebuilt at a similar size, or else any block of a larger class
+    uint32_t size = (length + VBO_MIN_BLOCK - 1) & ~uint32_t(VBO_MIN_BLOCK - 1);
+    int size_class = vbo_size_class(size);
+    uint32_t offset = vbo_free_lists[size_class];
+    while (offset != VBO_NO_BLOCK && vbo_block(offset)->size < size)
+        offset = vbo_block(offset)->next;
+    if (offset == VBO_NO_BLOCK)
+    {
+        uint32_t larger = size_class + 1 < VBO_CLASS_COUNT ? vbo_free_classes & ~((2U << size_class) - 1) : 0;
+        if (!larger)
+            return nullptr;
+        offset = vbo_free_lists[__builtin_ctz(larger)];
+    }
+
+    // The list takes the start of the block and the rest stays free
+    uint32_t free_size = vbo_block(offset)->size;
+    vbo_remove_free(offset);
+    if (free_size > size)
+        vbo_push_free(offset + size, free_size - size);
+    vbo_stats.arena_used += size;
+    return vbo_arena + offset;
+}
+
+// Returns a list to the arena, merging it with the free blocks on either side. Expects vbo_mutex to be held.
+static void vbo_arena_free(uint8_t *buffer, uint32_t length)
+{
+    uint32_t size = (length + VBO_MIN_BLOCK - 1) & ~uint32_t(VBO_MIN_BLOCK - 1);
+    vbo_stats.arena_used -= size;
+
+    // A free unit right before the list can only be the last one of a free block, and
+    // a free unit right after it the first one, so the edges find both neighbours
+    uint32_t offset = buffer - vbo_arena;
+    if (offset && vbo_is_edge(offset - VBO_MIN_BLOCK))
+    {
+        uint32_t before;
+        std::memcpy(&before, vbo_arena + offset - 4, 4);
+        offset -= before;
+        size += before;
+        vbo_remove_free(offset);
+    }
+    if (offset + size < vbo_stats.arena_size && vbo_is_edge(offset + size))
+    {
+        uint32_t after = vbo_block(offset + size)->size;
+        vbo_remove_free(offset + size);
+        size += after;
+    }
+    vbo_push_free(offset, size);
+}
+
+static bool vbo_in_arena(uint8_t *buffer)
+{
+    return vbo_arena && buffer >= vbo_arena && buffer < vbo_arena + vbo_stats.arena_size;
+}
+
+void vbo_configure(uint32_t arena_size, bool heap_fallback)
+{
+    arena_size = std::clamp(arena_size, uint32_t(VBO_ARENA_MIN_SIZE), uint32_t(VBO_ARENA_MAX_SIZE));
+
+    Lock lock(vbo_mutex);
+    vbo_arena_size = arena_size & ~uint32_t(VBO_MIN_BLOCK - 1);
+    vbo_heap_fallback = heap_fallback;
+    if (!vbo_arena)
+        vbo_stats.arena_size = vbo_arena_size;
+}
+
+uint8_t *vbo_alloc(uint32_t length)
+{
+    uint8_t *result = nullptr;
+    {
+        Lock lock(vbo_mutex);
+        result = vbo_arena_alloc(length);
+        if (!result)
+        {
+            if (!vbo_heap_fallback)
+            {
+                vbo_stats.failed_allocs++;
+                return nullptr;
+            }
+
+            // Report when the arena first overflows rather than on every list
+            if (!vbo_stats.heap_buffers)
+                debug::print("Display list arena full (%u KB), using the heap\n", vbo_stats.arena_size >> 10);
+            vbo_stats.heap_buffers++;
+            vbo_stats.heap_bytes += length;
+        }
+        vbo_stats.buffers++;
+        vbo_stats.bytes += length;
+        if (vbo_stats.bytes > vbo_stats.peak_bytes)
+            vbo_stats.peak_bytes = vbo_stats.bytes;
+    }
+
+    // The arena is full, so the heap will have to do
+    if (!result)
+        result = new (std::align_val_t(32)) uint8_t[length];
+    return result;
+}
+
+void vbo_free(uint8_t *buffer, uint32_t length)
+{
+    if (!buffer)
+        return;
+
+    Lock lock(vbo_mutex);
+    if (vbo_in_arena(buffer))
+    {
+        vbo_arena_free(buffer, length);
+    }
+    else
+    {
+        ::operator delete[](buffer, std::align_val_t(32));
+        vbo_stats.heap_buffers--;
+        vbo_stats.heap_bytes -= length;
+    }
+    vbo_stats.buffers--;
+    vbo_stats.bytes -= length;
+}
+
+void vbo_retire(uint8_t *buffer, uint32_t length)
+{
+    if (!buffer)
+        return;
+    Lock lock(vbo_mutex);
+    vbo_retired.push_back(RetiredVBO{buffer, length, vbo_frame});
+    vbo_stats.retired_buffers++;
+    vbo_stats.retired_bytes += length;
+}
+
+void vbo_frame_done()
+{
+    {
+        Lock lock(vbo_mutex);
+        uint32_t frame = vbo_frame++;
+
+        // Anything retired during the finished frame or before it is no longer used by the GPU
+        size_t count = 0;
+        while (count < vbo_retired.size() && int32_t(frame - vbo_retired[count].frame) >= 0)
+            count++;
+        if (count == vbo_retired.size())
+        {
+            // Usually everything is done, so the lists can trade places without copying
+            vbo_done.swap(vbo_retired);
+        }
+        else
+        {
+            vbo_done.assign(vbo_retired.begin(), vbo_retired.begin() + count);
+            vbo_retired.erase(vbo_retired.begin(), vbo_retired.begin() + count);
+        }
+        for (RetiredVBO &retired : vbo_done)
+        {
+            vbo_stats.retired_buffers--;
+            vbo_stats.retired_bytes -= retired.length;
+        }
+    }
+
+    // Free outside the lock so meshing threads are not held up
+    for (RetiredVBO &retired : vbo_done)
+        vbo_free(retired.buffer, retired.length);
+    vbo_done.clear();
+}
+
+bool vbo_release_arena()
+{
+    Lock lock(vbo_mutex);
+    if (!vbo_arena)
+        return true;
+    if (vbo_stats.arena_used)
+    {
+        debug::print("Display list arena still holds %u KB, keeping it\n", vbo_stats.arena_used >> 10);
+        return false;
+    }
+    ::operator delete[](vbo_arena, std::align_val_t(32));
+    delete[] vbo_free_edges;
+    vbo_arena = nullptr;
+    vbo_free_edges = nullptr;
+
+    // A new arena takes the size configured since
+    vbo_stats.arena_size = vbo_arena_size;
+    return true;
+}
+
+VBOStats get_vbo_stats()
+{
+    Lock lock(vbo_mutex);
+    vbo_stats.arena_largest_free = 0;
+    if (vbo_free_classes)
+    {
+        // The largest block is somewhere on the list of the largest class
+        for (uint32_t offset = vbo_free_lists[31 - __builtin_clz(vbo_free_classes)]; offset != VBO_NO_BLOCK; offset = vbo_block(offset)->next)
+            vbo_stats.arena_largest_free = std::max(vbo_stats.arena_largest_free, vbo_block(offset)->size);
+    }
+    if (!vbo_arena)
+        vbo_stats.arena_largest_free = vbo_stats.arena_size;
+    return vbo_stats;
+}
@@ -21,6 +21,70 @@ public:
     // Detach the buffer from the object without freeing it
     void detach();
 
-    // Free the buffer and set the object to an empty state
+    // Retire the buffer and set the object to an empty state
     void clear();
-};
\ No newline at end of file
+};
+
+// Display lists are allocated from a dedicated arena so that section churn does
+// not fragment the heap shared with chunk data. Lists take the space they need
+// rounded up to VBO_MIN_BLOCK, from free lists sorted into power of two size
+// classes, and are merged with the free space around them when freed.
+#define VBO_ARENA_SIZE (8 << 20)
+#define VBO_ARENA_MIN_SIZE (1 << 20)
+#define VBO_ARENA_MAX_SIZE (32 << 20)
+#define VBO_MIN_BLOCK 32
+#define VBO_CLASS_COUNT 21
+
+struct VBOStats
+{
+    uint32_t buffers = 0;
+    uint32_t bytes = 0;
+    uint32_t peak_bytes = 0;
+
+    // Retired buffers that the GPU may still be reading, included in the totals above
+    uint32_t retired_buffers = 0;
+    uint32_t retired_bytes = 0;
+
+    // Size of the arena the next lists are allocated from
+    uint32_t arena_size = VBO_ARENA_SIZE;
+
+    // Arena memory in use, including the rounding up to VBO_MIN_BLOCK
+    uint32_t arena_used = 0;
+
+    // Largest block that can still be allocated from the arena
+    uint32_t arena_largest_free = 0;
+
+    // Lists that did not fit in the arena and came from the heap instead
+    uint32_t heap_buffers = 0;
+    uint32_t heap_bytes = 0;
+
+    // Lists that did not fit in the arena while the heap fallback was off
+    uint32_t failed_allocs = 0;
+};
+
+// Sets the size of the arena and whether lists that do not fit in it may come from the heap.
+// Without the fallback the arena caps display list memory. The size applies when the arena is next created.
+void vbo_configure(uint32_t arena_size, bool heap_fallback);
+
+// Allocates a 32-byte aligned display list buffer. The length must already be aligned, and
+// the caller writes all of it, including the padding after the list.
+// Falls back to the heap if the arena is full, or returns nullptr if the fallback is off.
+uint8_t *vbo_alloc(uint32_t length);
+
+// Frees a buffer returned by vbo_alloc. The length must match the allocated length.
+void vbo_free(uint8_t *buffer, uint32_t length);
+
+// Queues a buffer returned by vbo_alloc to be freed once the frame that is
+// currently being drawn has finished. Safe to call from any thread.
+void vbo_retire(uint8_t *buffer, uint32_t length);
+
+// Frees the buffers retired up to the current frame and starts a new one.
+// Must be called from the main thread after GX_DrawDone.
+void vbo_frame_done();
+
+// Gives the arena back to the heap if no list is allocated from it.
+// Returns false if lists are still held, as after a leak.
+bool vbo_release_arena();
+
+// Returns a copy of the memory held by display lists and the state of the arena.
+VBOStats get_vbo_stats();
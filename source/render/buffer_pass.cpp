@@ -1,5 +1,7 @@
 #include "buffer_pass.hpp"
 
+#include <cstring>
+
 void BufferPass::refresh()
 {
     if (cached != uncached)
@@ -16,7 +18,7 @@ bool BufferPass::is_same()
 
 size_t BufferPass::size()
 {
-    size_t base_size = sizeof(*this);
+    size_t base_size = sizeof(*this) + light_faces.capacity() * sizeof(uint16_t);
     if (uncached.buffer == cached.buffer)
     {
         return base_size + cached.length;
@@ -29,4 +31,7 @@ void BufferPass::clear()
     if (!is_same())
         uncached.clear();
     cached.clear();
+    std::vector<uint16_t>().swap(light_faces);
+    std::memset(light_face_counts, 0, sizeof(light_face_counts));
+    patchable_slabs = 0;
 }
@@ -2,6 +2,12 @@
 
 #include "buffer.hpp"
 #include <cstddef>
+#include <vector>
+
+// Section meshes are built from horizontal slabs that can be rebuilt separately
+#define SECTION_SLAB_HEIGHT 4
+#define SECTION_SLAB_COUNT (16 / SECTION_SLAB_HEIGHT)
+#define SECTION_ALL_SLABS ((1 << SECTION_SLAB_COUNT) - 1)
 
 class BufferPass
 {
@@ -9,6 +15,18 @@ public:
     VBO cached = VBO();
     VBO uncached = VBO();
 
+    // Size of each slab in the uncached buffer, in 32-byte blocks
+    uint16_t slab_sizes[SECTION_SLAB_COUNT] = {0};
+
+    // Faces whose light can be rewritten in place, stored slab by slab.
+    // Each entry is the section-local block position and face: x | z << 4 | y << 8 | face << 12
+    // The tiled pass follows each entry with the size of the face in blocks: (width - 1) | (height - 1) << 4
+    std::vector<uint16_t> light_faces;
+    uint16_t light_face_counts[SECTION_SLAB_COUNT] = {0};
+
+    // Slabs that contain nothing but recorded faces
+    uint8_t patchable_slabs = 0;
+
     void refresh();
     bool is_same();
     size_t size();
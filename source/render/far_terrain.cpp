@@ -0,0 +1,221 @@
+#include "far_terrain.hpp"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <render/render.hpp>
+#include <render/buffer.hpp>
+#include <render/camera.hpp>
+#include <util/timers.hpp>
+#include <util/constants.hpp>
+#include <world/chunk.hpp>
+#include <block/blocks.hpp>
+
+FarTerrain::~FarTerrain()
+{
+    clear();
+}
+
+void FarTerrain::record(Chunk *chunk)
+{
+    FarColumn &column = columns[uint32_pair(chunk->x, chunk->z)];
+    column.x = chunk->x;
+    column.z = chunk->z;
+    for (int cz = 0; cz < FAR_CELLS; cz++)
+    {
+        for (int cx = 0; cx < FAR_CELLS; cx++)
+        {
+            // Use the highest column of the cell so hills and trees stay visible
+            int x = cx * FAR_CELL_SIZE;
+            int z = cz * FAR_CELL_SIZE;
+            for (int i = 0; i < FAR_CELL_SIZE * FAR_CELL_SIZE; i++)
+            {
+                int sx = cx * FAR_CELL_SIZE + (i % FAR_CELL_SIZE);
+                int sz = cz * FAR_CELL_SIZE + (i / FAR_CELL_SIZE);
+                if (chunk->height_map[sx | (sz << 4)] > chunk->height_map[x | (z << 4)])
+                {
+                    x = sx;
+                    z = sz;
+                }
+            }
+
+            FarCell &cell = column.cells[cx + cz * FAR_CELLS];
+            int height = chunk->height_map[x | (z << 4)];
+            cell.height = height;
+            cell.top_texture = cell.side_texture = 0;
+            cell.light = 0xFF;
+            if (height <= 0)
+                continue;
+
+            BlockState *top = chunk->get_block(Vec3i(x, std::min(height - 1, MAX_WORLD_Y), z));
+            cell.top_texture = get_face_texture_index(top, FACE_PY);
+            cell.side_texture = get_face_texture_index(top, FACE_NX);
+            if (height <= MAX_WORLD_Y)
+                cell.light = chunk->get_block(Vec3i(x, height, z))->light;
+        }
+    }
+    dirty = true;
+}
+
+bool FarTerrain::contains(int32_t x, int32_t z)
+{
+    return columns.find(uint32_pair(x, z)) != columns.end();
+}
+
+void FarTerrain::clear()
+{
+    columns.clear();
+    if (buffer)
+        vbo_retire(buffer, length);
+    buffer = nullptr;
+    length = 0;
+    dirty = false;
+}
+
+size_t FarTerrain::size()
+{
+    return columns.size() * (sizeof(FarColumn) + sizeof(uint64_t)) + length;
+}
+
+FarColumn *FarTerrain::get_column(int32_t x, int32_t z)
+{
+    auto it = columns.find(uint32_pair(x, z));
+    return it == columns.end() ? nullptr : &it->second;
+}
+
+void FarTerrain::put_box_face(gertex::DisplayListCompact16 &list, uint8_t face, const FarCell &cell, int x0, int y0, int z0, int x1, int y1, int z1)
+{
+    // Positions are relative to the center chunk, which is drawn half a block off like the sections
+    int origin_x = mesh_center.x << 4;
+    int origin_z = mesh_center.y << 4;
+    uint32_t texture_index = face == FACE_PY ? cell.top_texture : cell.side_texture;
+    const float u[4] = {float(TEXTURE_NX(texture_index)), float(TEXTURE_NX(texture_index)), float(TEXTURE_PX(texture_index)), float(TEXTURE_PX(texture_index))};
+    const float v[4] = {float(TEXTURE_PY(texture_index)), float(TEXTURE_NY(texture_index)), float(TEXTURE_NY(texture_index)), float(TEXTURE_PY(texture_index))};
+    for (int i = 0; i < 4; i++)
+    {
+        const Vec3i &corner = cube_vertices[face][i];
+        int x = corner.x < 0 ? x0 : x1;
+        int y = corner.y < 0 ? y0 : y1;
+        int z = corner.z < 0 ? z0 : z1;
+        gertex::Vertex16 vertex{};
+        vertex.x = int16_t(((x - origin_x) << BASE3D_POS_FRAC_BITS) - BASE3D_POS_FRAC / 2);
+        vertex.y = int16_t((y << BASE3D_POS_FRAC_BITS) - BASE3D_POS_FRAC / 2);
+        vertex.z = int16_t(((z - origin_z) << BASE3D_POS_FRAC_BITS) - BASE3D_POS_FRAC / 2);
+        vertex.i = cell.light;
+        vertex.nrm = face;
+        vertex.u = u[i];
+        vertex.v = v[i];
+        list.put(vertex);
+    }
+}
+
+void FarTerrain::rebuild(const Vec2i &center)
+{
+    mesh_center = center;
+    mesh_time = time_get();
+    dirty = false;
+
+    // Forget the chunks that are well out of range to keep the memory use bounded
+    std::vector<FarColumn *> visible;
+    for (auto it = columns.begin(); it != columns.end();)
+    {
+        FarColumn &column = it->second;
+        int distance = std::abs(column.x - center.x) + std::abs(column.z - center.y);
+        if (distance > FAR_CHUNK_DISTANCE + 4)
+        {
+            it = columns.erase(it);
+            continue;
+        }
+        if (distance * 16 > RENDER_DISTANCE && distance <= FAR_CHUNK_DISTANCE)
+            visible.push_back(&column);
+        ++it;
+    }
+
+    // Nearest chunks first in case the list fills up
+    std::sort(visible.begin(), visible.end(), [&center](FarColumn *a, FarColumn *b)
+              { return std::abs(a->x - center.x) + std::abs(a->z - center.y) < std::abs(b->x - center.x) + std::abs(b->z - center.y); });
+
+    if (buffer)
+        vbo_retire(buffer, length);
+    buffer = nullptr;
+    length = 0;
+    if (visible.empty())
+        return;
+
+    // The scratch list only lives for the rebuild. Every cell needs room for a top and four sides.
+    uint32_t max_vertices = std::min<size_t>(visible.size() * FAR_CELLS * FAR_CELLS * 20, 64000U);
+    gertex::DisplayListCompact16 list(max_vertices, VERTEX_ATTR_LENGTH_TERRAIN, BASE3D_TERRAIN_VTXFMT, BASE3D_TERRAIN_UV_FRAC_BITS);
+    list.begin(GX_QUADS);
+
+    static const int side_faces[4] = {FACE_NX, FACE_PX, FACE_NZ, FACE_PZ};
+    uint32_t vertex_count = 0;
+    for (FarColumn *column : visible)
+    {
+        if (list.size() + 20 * FAR_CELLS * FAR_CELLS * list.attrib_size > list.capacity())
+            break;
+        for (int cz = 0; cz < FAR_CELLS; cz++)
+        {
+            for (int cx = 0; cx < FAR_CELLS; cx++)
+            {
+                const FarCell &cell = column->cells[cx + cz * FAR_CELLS];
+                if (!cell.height)
+                    continue;
+                int x0 = (column->x << 4) + cx * FAR_CELL_SIZE;
+                int z0 = (column->z << 4) + cz * FAR_CELL_SIZE;
+                int x1 = x0 + FAR_CELL_SIZE;
+                int z1 = z0 + FAR_CELL_SIZE;
+
+                put_box_face(list, FACE_PY, cell, x0, 0, z0, x1, cell.height, z1);
+                vertex_count += 4;
+
+                // Fill the steps down to lower neighbors that are known
+                for (int face : side_faces)
+                {
+                    int nx = x0 + face_offsets[face].x * FAR_CELL_SIZE;
+                    int nz = z0 + face_offsets[face].z * FAR_CELL_SIZE;
+                    FarColumn *neighbor = get_column(nx >> 4, nz >> 4);
+                    if (!neighbor)
+                        continue;
+                    int neighbor_height = neighbor->cells[((nx & 15) / FAR_CELL_SIZE) + ((nz & 15) / FAR_CELL_SIZE) * FAR_CELLS].height;
+                    if (neighbor_height >= cell.height)
+                        continue;
+                    put_box_face(list, face, cell, x0, neighbor_height, z0, x1, cell.height, z1);
+                    vertex_count += 4;
+                }
+            }
+        }
+    }
+
+    if (!vertex_count)
+        return;
+
+    uint16_t count = vertex_count;
+    std::memcpy(&list.buffer[1], &count, 2);
+    length = list.aligned_size();
+    buffer = vbo_alloc(length);
+    if (!buffer)
+    {
+        length = 0;
+        return;
+    }
+    std::memcpy(buffer, list.buffer, list.size());
+    std::memset(buffer + list.size(), 0, length - list.size());
+    DCFlushRange(buffer, length);
+}
+
+void FarTerrain::draw(Camera &camera)
+{
+    const guVector &position = camera.transform.get_position();
+    Vec2i center(int(std::floor(position.x)) >> 4, int(std::floor(position.z)) >> 4);
+
+    // New chunks are added at most once a second, moving to another chunk rebuilds right away
+    if (center != mesh_center || (dirty && time_diff_us(mesh_time, time_get()) > 1000000))
+        rebuild(center);
+    if (!buffer)
+        return;
+
+    Transform transform;
+    transform.set_position({float(mesh_center.x << 4) + 0.5f, 0.5f, float(mesh_center.y << 4) + 0.5f});
+    gertex::use_matrix(camera.apply_transform(transform));
+    gertex::call_display_list(buffer, length, VERTEX_ATTR_LENGTH_TERRAIN);
+}
@@ -0,0 +1,79 @@
+#ifndef FAR_TERRAIN_HPP
+#define FAR_TERRAIN_HPP
+
+#include <cstdint>
+#include <map>
+#include <math/vec2i.hpp>
+#include <render/base3d.hpp>
+#include <gertex/displaylist.hpp>
+
+class Chunk;
+class Camera;
+
+// Far terrain is drawn out to this many chunks past the loaded ones
+#define FAR_CHUNK_DISTANCE 16
+#define FAR_RENDER_DISTANCE (FAR_CHUNK_DISTANCE * 16)
+#define FAR_FOG_DISTANCE (FAR_RENDER_DISTANCE - 16)
+
+// Width of a far terrain cell in blocks
+#define FAR_CELL_SIZE 4
+#define FAR_CELLS (16 / FAR_CELL_SIZE)
+
+// The surface of a cell: the height of its highest column and the block on top of it
+struct FarCell
+{
+    uint8_t height;
+    uint8_t top_texture;
+    uint8_t side_texture;
+    uint8_t light;
+};
+
+// A downsampled copy of the surface of a chunk
+struct FarColumn
+{
+    int32_t x;
+    int32_t z;
+    FarCell cells[FAR_CELLS * FAR_CELLS];
+};
+
+/**
+ * Draws the chunks past RENDER_DISTANCE as a low detail heightmap.
+ * The surface of every chunk is recorded while it is loaded, so the
+ * far terrain covers the places the player has already seen.
+ * Must only be used from the main thread.
+ */
+class FarTerrain
+{
+public:
+    ~FarTerrain();
+
+    // Records the surface of the chunk, replacing any earlier record.
+    void record(Chunk *chunk);
+
+    // Returns true if the chunk at the chunk coordinates has been recorded.
+    bool contains(int32_t x, int32_t z);
+
+    // Forgets all recorded chunks and frees the mesh.
+    void clear();
+
+    // Draws the recorded chunks that are past RENDER_DISTANCE from the camera.
+    // Expects the terrain texture and vertex format to be in use.
+    void draw(Camera &camera);
+
+    // Returns the memory used by the records and the mesh.
+    size_t size();
+
+private:
+    std::map<uint64_t, FarColumn> columns;
+    uint8_t *buffer = nullptr;
+    uint32_t length = 0;
+    Vec2i mesh_center = Vec2i(0, 0);
+    uint64_t mesh_time = 0;
+    bool dirty = false;
+
+    FarColumn *get_column(int32_t x, int32_t z);
+    void put_box_face(gertex::DisplayListCompact16 &list, uint8_t face, const FarCell &cell, int x0, int y0, int z0, int x1, int y1, int z1);
+    void rebuild(const Vec2i &center);
+};
+
+#endif
@@ -106,7 +106,7 @@ void ModelBox::render()
         guMtxScaleApply(pos_mtx.mtx, pos_mtx.mtx, -1, -1, -1);
         gertex::use_matrix(pos_mtx.mtx, true);
 
-        GX_CallDispList(display_list, display_list_size);
+        gertex::call_display_list(display_list, display_list_size, VERTEX_ATTR_LENGTH_FLOATPOS);
         gertex::pop_matrix();
     }
 }
@@ -126,7 +126,8 @@ void Model::raw_render()
 {
     prepare();
 
-    gertex::GXState state = gertex::get_state();
+    // Only the vertex format changes here, the boxes restore the matrix themselves
+    gertex::GXVertexFormat format = gertex::get_vertex_format();
 
     // Use floats for vertex positions
     gertex::set_pos_precision(GX_F32, 0);
@@ -136,7 +137,7 @@ void Model::raw_render()
         box->render();
     }
 
-    gertex::set_state(state);
+    gertex::set_vertex_format(format);
 }
 
 void Model::render(float partialTicks, bool transparency)
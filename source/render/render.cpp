@@ -1,5 +1,6 @@
 #include "render.hpp"
 #include <render/render_blocks.hpp>
+#include <render/section_snapshot.hpp>
 #include <gertex/displaylist.hpp>
 #include <registry/block_list.hpp>
 
@@ -9,8 +10,10 @@
 #include <world/world.hpp>
 
 #include <new>
+#include <vector>
+#include <cstring>
+#include <util/timers.hpp>
 
-mutex_t render_mutex = LWP_MUTEX_NULL;
 
 const GXColor sky_color = {0x88, 0xBB, 0xFF, 0xFF};
 
@@ -48,13 +51,51 @@ void use_texture(GXTexObj &texture)
     GX_LoadTexObj(&texture, GX_TEXMAP0);
 }
 
-void smooth_light(const Vec3i &pos, uint8_t face_index, const Vec3i &vertex_off, BlockState *block, uint8_t &lighting, uint8_t &amb_occ)
+void use_terrain_vertex_format()
 {
-    if (pos.y < 0 || pos.y > 255)
+    GX_SetVtxAttrFmt(BASE3D_TERRAIN_VTXFMT, GX_VA_POS, GX_POS_XYZ, GX_S16, BASE3D_POS_FRAC_BITS);
+    GX_SetVtxAttrFmt(BASE3D_TERRAIN_VTXFMT, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
+    GX_SetVtxAttrFmt(BASE3D_TERRAIN_VTXFMT, GX_VA_CLR1, GX_CLR_RGBA, GX_RGBA8, 0);
+    GX_SetVtxAttrFmt(BASE3D_TERRAIN_VTXFMT, GX_VA_TEX0, GX_TEX_ST, GX_U16, BASE3D_TERRAIN_UV_FRAC_BITS);
+
+    GX_SetVtxAttrFmt(BASE3D_TILED_VTXFMT, GX_VA_POS, GX_POS_XYZ, GX_S16, BASE3D_POS_FRAC_BITS);
+    GX_SetVtxAttrFmt(BASE3D_TILED_VTXFMT, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
+    GX_SetVtxAttrFmt(BASE3D_TILED_VTXFMT, GX_VA_CLR1, GX_CLR_RGBA, GX_RGBA8, 0);
+    GX_SetVtxAttrFmt(BASE3D_TILED_VTXFMT, GX_VA_TEX0, GX_TEX_ST, GX_U16, BASE3D_TILED_UV_FRAC_BITS);
+}
+
+void use_tiled_terrain(bool enable)
+{
+    if (!enable)
+    {
+        GX_SetTevDirect(GX_TEVSTAGE0);
+        GX_SetNumIndStages(0);
+        return;
+    }
+
+    // The texture coordinate is wrapped to the size of a tile, then the indirect stage adds the
+    // position of the tile back from the tile map. The coordinate is in texels of the atlas, so
+    // the map is looked up at 1/256 of it to land on the tile column and row.
+    GX_LoadTexObj(&terrain_tile_map, GX_TEXMAP1);
+    GX_SetNumIndStages(1);
+    GX_SetIndTexOrder(GX_INDTEXSTAGE0, GX_TEXCOORD0, GX_TEXMAP1);
+    GX_SetIndTexCoordScale(GX_INDTEXSTAGE0, GX_ITS_256, GX_ITS_256);
+    GX_SetTevIndTile(GX_TEVSTAGE0, GX_INDTEXSTAGE0, terrain_tile_size, terrain_tile_size, terrain_tile_size, terrain_tile_size, GX_ITF_8, GX_ITM_0, GX_ITB_NONE, GX_ITBA_OFF);
+}
+
+// Looks up a block for meshing, nullptr if there is no snapshot or the position is outside it.
+inline BlockState *mesh_block_at(SectionSnapshot *snapshot, const Vec3i &pos)
+{
+    return snapshot ? snapshot->get_block_at(pos) : nullptr;
+}
+
+void smooth_light(SectionSnapshot *snapshot, const Vec3i &pos, uint8_t face_index, const Vec3i &vertex_off, BlockState *block, uint8_t &lighting, uint8_t &amb_occ)
+{
+    if (!snapshot || pos.y < 0 || pos.y > 255)
         return;
     Vec3i face = pos + face_offsets[face_index];
     uint8_t total = 1;
-    BlockState *face_block = render_world ? render_world->get_block_at(face) : nullptr;
+    BlockState *face_block = snapshot->get_block_at(face);
     if (!face_block)
         face_block = block;
     uint8_t block_light = face_block->block_light;
@@ -90,11 +131,12 @@ void smooth_light(const Vec3i &pos, uint8_t face_index, const Vec3i &vertex_off,
     default:
         break;
     }
-    BlockState *blockA = render_world ? render_world->get_block_at(face + vertex_offA) : nullptr;
-    BlockState *blockB = render_world ? render_world->get_block_at(face + vertex_offB) : nullptr;
+    bool opaqueA = false, opaqueB = false, opaqueC = false;
+    BlockState *blockA = snapshot->get_block_at(face + vertex_offA, opaqueA);
+    BlockState *blockB = snapshot->get_block_at(face + vertex_offB, opaqueB);
     if (blockA)
     {
-        if (properties(blockA->id).m_opacity == 15)
+        if (opaqueA)
         {
             amb_occ += 6;
         }
@@ -107,7 +149,7 @@ void smooth_light(const Vec3i &pos, uint8_t face_index, const Vec3i &vertex_off,
     }
     if (blockB)
     {
-        if (properties(blockB->id).m_opacity == 15)
+        if (opaqueB)
         {
             amb_occ += 6;
         }
@@ -118,10 +160,10 @@ void smooth_light(const Vec3i &pos, uint8_t face_index, const Vec3i &vertex_off,
             sky_light += blockB->sky_light;
         }
     }
-    BlockState *blockC = render_world ? render_world->get_block_at(face + vertex_off) : nullptr;
+    BlockState *blockC = snapshot->get_block_at(face + vertex_off, opaqueC);
     if (blockC)
     {
-        if (properties(blockC->id).m_opacity == 15)
+        if (opaqueC)
         {
             if (amb_occ < 12)
                 amb_occ += 6;
@@ -280,10 +322,10 @@ Vec3i vertical_add(const Vec3i &a, uint8_t b)
     return Vec3i(a.x * 16, a.y - 17 + b * 2, a.z * 16);
 }
 
-inline uint8_t get_face_light_index(Vec3i pos, uint8_t face, BlockState *default_block = nullptr)
+inline uint8_t get_face_light_index(SectionSnapshot *snapshot, Vec3i pos, uint8_t face, BlockState *default_block = nullptr)
 {
     Vec3i other = pos + face_offsets[face];
-    BlockState *other_block = render_world ? render_world->get_block_at(other) : nullptr;
+    BlockState *other_block = mesh_block_at(snapshot, other);
     if (!other_block)
     {
         if (default_block)
@@ -293,18 +335,18 @@ inline uint8_t get_face_light_index(Vec3i pos, uint8_t face, BlockState *default
     return other_block->light;
 }
 
-void get_face(Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y, gertex::Vertex16 *out_vertices, uint8_t *out_lighting, uint8_t *out_ao)
+void get_face(SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y, gertex::Vertex16 *out_vertices, uint8_t *out_lighting, uint8_t *out_ao)
 {
     Vec3i vertex_pos((pos.x & 0xF) << BASE3D_POS_FRAC_BITS, (pos.y & 0xF) << BASE3D_POS_FRAC_BITS, (pos.z & 0xF) << BASE3D_POS_FRAC_BITS);
-    uint8_t light_val = get_face_light_index(pos, face, block);
+    uint8_t light_val = get_face_light_index(snapshot, pos, face, block);
     uint8_t ao[4] = {0, 0, 0, 0};
     uint8_t ao_no_op[4] = {0, 0, 0, 0};
     uint8_t lighting[4] = {light_val, light_val, light_val, light_val};
     gertex::Vertex16 vertices[4];
     uint8_t index = 0;
-#define SMOOTH(ao_tgt)                                 \
-    if (render_world && render_world->smooth_lighting) \
-    smooth_light(pos, face, cube_vertex_offsets[face][index], block, lighting[index], ao_tgt[index])
+#define SMOOTH(ao_tgt)                           \
+    if (snapshot && snapshot->smooth_lighting) \
+    smooth_light(snapshot, pos, face, cube_vertex_offsets[face][index], block, lighting[index], ao_tgt[index])
     if ((face & ~1) != FACE_NY)
     {
         // Side faces
@@ -402,13 +444,17 @@ void get_face(Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block
     }
 }
 
-int render_face(gertex::DisplayList<gertex::Vertex16> *list, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y)
+int render_face(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y)
 {
     uint8_t ao[4] = {0, 0, 0, 0};
     uint8_t lighting[4] = {0, 0, 0, 0};
     gertex::Vertex16 vertices[4];
-    uint8_t index = 0;
-    get_face(pos, face, texture_index, block, min_y, max_y, vertices, lighting, ao);
+    get_face(snapshot, pos, face, texture_index, block, min_y, max_y, vertices, lighting, ao);
+    return put_face(list, face, texture_index, vertices, lighting, ao);
+}
+
+int put_face(gertex::DisplayList<gertex::Vertex16> *list, uint8_t face, uint32_t texture_index, gertex::Vertex16 *vertices, uint8_t *lighting, uint8_t *ao, bool back_face)
+{
     if (texture_index >= 240 && texture_index < 250)
     {
         // Force full brightness for breaking block override
@@ -418,53 +464,29 @@ int render_face(gertex::DisplayList<gertex::Vertex16> *list, Vec3i pos, uint8_t
         // Set the face to the top face
         face = FACE_PY;
     }
-    index = (ao[0] + ao[3] > ao[1] + ao[2]);
+    // Flip the quad diagonal towards the darker corners to avoid AO artifacts
+    uint8_t index = (ao[0] + ao[3] > ao[1] + ao[2]);
     for (int i = 0; i < 4; i++)
     {
         vertices[i].i = lighting[i];
         vertices[i].nrm = face + ao[i];
     }
-    list->put(vertices[index]);
-    index = (index + 1) & 3;
-    list->put(vertices[index]);
-    index = (index + 1) & 3;
-    list->put(vertices[index]);
-    index = (index + 1) & 3;
-    list->put(vertices[index]);
+    // Back faces put the vertices in reverse order (3 - index)
+    for (int i = 0; i < 4; i++)
+    {
+        list->put(vertices[back_face ? 3 - index : index]);
+        index = (index + 1) & 3;
+    }
     return 4;
 }
 
-int render_back_face(gertex::DisplayList<gertex::Vertex16> *list, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y)
+int render_back_face(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y)
 {
     uint8_t ao[4] = {0, 0, 0, 0};
     uint8_t lighting[4] = {0, 0, 0, 0};
     gertex::Vertex16 vertices[4];
-    uint8_t index = 0;
-    get_face(pos, face, texture_index, block, min_y, max_y, vertices, lighting, ao);
-    if (texture_index >= 240 && texture_index < 250)
-    {
-        // Force full brightness for breaking block override
-        lighting[0] = lighting[1] = lighting[2] = lighting[3] = 255;
-        // Reset ambient occlusion
-        ao[0] = ao[1] = ao[2] = ao[3] = 0;
-        // Set the face to the top face
-        face = FACE_PY;
-    }
-    // Reverse the order of vertices for back face rendering (3 - index)
-    index = (ao[0] + ao[3] > ao[1] + ao[2]);
-    for (int i = 0; i < 4; i++)
-    {
-        vertices[i].i = lighting[i];
-        vertices[i].nrm = face + ao[i];
-    }
-    list->put(vertices[3 - index]);
-    index = (index + 1) & 3;
-    list->put(vertices[3 - index]);
-    index = (index + 1) & 3;
-    list->put(vertices[3 - index]);
-    index = (index + 1) & 3;
-    list->put(vertices[3 - index]);
-    return 4;
+    get_face(snapshot, pos, face, texture_index, block, min_y, max_y, vertices, lighting, ao);
+    return put_face(list, face, texture_index, vertices, lighting, ao, true);
 }
 
 void render_single_block_at(BlockState &selected_block, const Vec3i &pos, uint8_t frac_bits)
@@ -475,7 +497,7 @@ void render_single_block_at(BlockState &selected_block, const Vec3i &pos, uint8_
 
     gertex::DisplayListBuffered16 list(128, VERTEX_ATTR_LENGTH);
     list.begin(GX_QUADS);
-    block_list[selected_block.id]->render(&list, &selected_block, pos);
+    block_list[selected_block.id]->render(&list, nullptr, &selected_block, pos);
     list.flush();
 
     gertex::set_state(state);
@@ -578,6 +600,30 @@ bool is_cube_visible(const Frustum &frustum, const Vec3f &center, float size)
     return true; // At least partially visible
 }
 
+void classify_boxes(const Frustum &frustum, const float *center_x, const float *center_y, const float *center_z, const Vec3f &half_extent, int count, uint8_t *out)
+{
+    for (int j = 0; j < count; j++)
+        out[j] = FRUSTUM_INSIDE;
+
+    // One plane at a time over all boxes keeps the inner loop free of branches
+    for (int i = 0; i < 6; i++)
+    {
+        float nx = frustum.normal_x[i];
+        float ny = frustum.normal_y[i];
+        float nz = frustum.normal_z[i];
+        float d = frustum.distance[i];
+
+        // Distance from the center to the corner of the box furthest along the plane normal
+        float r = std::abs(nx) * float(half_extent.x) + std::abs(ny) * float(half_extent.y) + std::abs(nz) * float(half_extent.z);
+        for (int j = 0; j < count; j++)
+        {
+            float dist = nx * center_x[j] + ny * center_y[j] + nz * center_z[j] + d;
+            uint8_t result = dist > r ? FRUSTUM_OUTSIDE : (dist > -r ? FRUSTUM_PARTIAL : FRUSTUM_INSIDE);
+            out[j] = std::min(out[j], result);
+        }
+    }
+}
+
 gertex::GXProjMatrix create_offset_perspective(const gertex::GXView &view, float x_pixel, float y_pixel)
 {
     gertex::GXProjMatrix projection;
@@ -607,107 +653,136 @@ gertex::GXProjMatrix create_offset_perspective(const gertex::GXView &view, float
     return projection;
 }
 
-void draw_particles(Camera &camera, Particle *particles, int count)
+// Particle types in the order they are drawn, grouped by texture
+static const uint8_t particle_draw_order[PTYPE_MAX] = {PTYPE_BLOCK_BREAK, PTYPE_GENERIC, PTYPE_TINY_SMOKE};
+
+void draw_particles(Camera &camera, ParticleSystem &system)
 {
-    gertex::GXState state = gertex::get_state();
+    uint64_t start_time = time_get();
+    size_t count = system.size();
 
-    // Use floats for vertex positions
-    gertex::set_pos_precision(GX_F32, 0);
+    // Sort the living particles by type in a single pass
+    static std::vector<uint16_t> visible[PTYPE_MAX];
+    for (int t = 0; t < PTYPE_MAX; t++)
+        visible[t].clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t type = system.types[i];
+        if (system.life_times[i] && type < PTYPE_MAX)
+            visible[type].push_back(i);
+    }
 
-    // Bake vertex properties
-    Mtx rot_mtx;
+    // The billboard corners only change when the camera turns
+    static guVector billboard_rotation = {0, 0, 0};
+    static Vec3f billboard[4];
+    static bool billboard_ready = false;
     guVector rot_vec = camera.transform.get_rotation();
-    Vertex vertices[4];
-    for (int i = 0; i < 4; i++)
+    if (!billboard_ready || rot_vec.x != billboard_rotation.x || rot_vec.y != billboard_rotation.y)
     {
-        int x = (i == 0 || i == 3);
-        int y = (i > 1);
-        guVector vertex{(x - 0.5f), (y - 0.5f), 0};
+        Mtx rot_mtx;
+        for (int i = 0; i < 4; i++)
+        {
+            int x = (i == 0 || i == 3);
+            int y = (i > 1);
+            guVector vertex{(x - 0.5f), (y - 0.5f), 0};
 
-        guMtxRotDeg(rot_mtx, 'x', rot_vec.x);
-        guVecMultiply(rot_mtx, &vertex, &vertex);
-        guMtxRotDeg(rot_mtx, 'y', rot_vec.y);
-        guVecMultiply(rot_mtx, &vertex, &vertex);
+            guMtxRotDeg(rot_mtx, 'x', rot_vec.x);
+            guVecMultiply(rot_mtx, &vertex, &vertex);
+            guMtxRotDeg(rot_mtx, 'y', rot_vec.y);
+            guVecMultiply(rot_mtx, &vertex, &vertex);
 
-        vertices[i] = Vertex(vertex, (x << 2) * BASE3D_PIXEL_UV_SCALE, (y << 2) * BASE3D_PIXEL_UV_SCALE);
+            billboard[i] = Vec3f(vertex);
+        }
+        billboard_rotation = rot_vec;
+        billboard_ready = true;
     }
 
-    // Draw particles on a per-type basis
-    for (int t = 0; t < PTYPE_MAX; t++)
-    {
-        // Enumerate visible particles
-        int visible_count = 0;
-        for (int i = 0; i < count; i++)
-        {
-            Particle &particle = particles[i];
-            if (particle.life_time && particle.type == t)
-                visible_count++;
-        }
+    // Each type is written into a list of its own that is kept between frames
+    static gertex::DisplayList<gertex::Vertex> *lists[PTYPE_MAX] = {nullptr};
+
+    gertex::GXState state = gertex::get_state();
+
+    // Use floats for vertex positions
+    gertex::set_pos_precision(GX_F32, 0);
 
-        if (visible_count == 0)
+    uint32_t visible_count = 0;
+    for (uint8_t t : particle_draw_order)
+    {
+        std::vector<uint16_t> &indices = visible[t];
+        if (indices.empty())
             continue;
+        visible_count += indices.size();
 
-        if (t == PTYPE_BLOCK_BREAK || t == PTYPE_GENERIC)
+        // One quad less than the list holds leaves room for the primitive header
+        uint16_t vertex_count = std::min<size_t>(indices.size() * 4, 0xFFF0);
+        gertex::DisplayList<gertex::Vertex> *&list = lists[t];
+        if (!list || list->max_vertices < vertex_count + 4)
         {
-            // Enable indexed colors
-            gertex::set_color_format(0, GX_INDEX8);
+            delete list;
+            uint32_t attrib_size = t == PTYPE_TINY_SMOKE ? VERTEX_ATTR_LENGTH_FLOATPOS_DIRECTCOLOR : VERTEX_ATTR_LENGTH_FLOATPOS;
+            list = new gertex::DisplayList<gertex::Vertex>(std::max(vertex_count + 4, 1024), attrib_size);
         }
-        else if (t == PTYPE_TINY_SMOKE)
-        {
-            // Enable direct colors
-            gertex::set_color_format(0, GX_DIRECT);
-        }
-
-        use_texture(t == 0 ? terrain_texture : particles_texture);
-
-        GX_BeginGroup(GX_QUADS, visible_count << 2);
+        list->rewind();
+        list->begin(GX_QUADS);
 
-        // Draw particles
-        for (int i = 0; i < count; i++)
+        for (uint16_t i = 0; i < vertex_count / 4; i++)
         {
-            Particle &particle = particles[i];
-            if (particle.life_time && particle.type == t)
+            uint16_t index = indices[i];
+            const Vec3f &position = system.positions[index];
+            const ParticleData &data = system.data[index];
+            uint8_t brightness = system.brightness[index];
+            float scale = system.sizes[index] / 64.f;
+            float brightness_value = ((brightness & 0xF) | (brightness >> 4)) * 0.0625f + 0.0625f;
+            for (int j = 0; j < 4; j++)
             {
-                for (int j = 0; j < 4; j++)
+                int x = (j == 0 || j == 3);
+                int y = (j > 1);
+                Vec3f pos = billboard[j] * scale + position;
+
+                gertex::Vertex vertex{};
+                vertex.x = pos.x;
+                vertex.y = pos.y;
+                vertex.z = pos.z;
+                vertex.nrm = 3;
+                if (t == PTYPE_BLOCK_BREAK)
                 {
-                    Vertex vertex = vertices[j];
-                    vertex.pos = vertex.pos * (particle.size / 64.f);
-                    vertex.pos = vertex.pos + particle.position;
-
-                    if (t == PTYPE_BLOCK_BREAK)
-                    {
-                        vertex.x_uv += particle.u * BASE3D_PIXEL_UV_SCALE;
-                        vertex.y_uv += particle.v * BASE3D_PIXEL_UV_SCALE;
-                        GX_VertexLitF(vertex, particle.brightness);
-                    }
-                    else if (t == PTYPE_TINY_SMOKE)
-                    {
-                        int x = (j == 0 || j == 3);
-                        int y = (j > 1);
-                        float brightness_value = ((particle.brightness & 0xF) | (particle.brightness >> 4)) * 0.0625f + 0.0625f;
-                        vertex.x_uv = ((x << 4) + (int(particle.life_time * 16.0f / float(particle.max_life_time)) << 4)) * BASE3D_PIXEL_UV_SCALE;
-                        vertex.y_uv = (y << 4) * BASE3D_PIXEL_UV_SCALE;
-                        vertex.color_r = particle.r * brightness_value;
-                        vertex.color_g = particle.g * brightness_value;
-                        vertex.color_b = particle.b * brightness_value;
-                        vertex.color_a = particle.a;
-                        GX_VertexF(vertex);
-                    }
-                    else if (t == PTYPE_GENERIC)
-                    {
-                        int x = (j == 0 || j == 3);
-                        int y = (j > 1);
-                        vertex.x_uv = ((x << 4) + particle.u) * BASE3D_PIXEL_UV_SCALE;
-                        vertex.y_uv = ((y << 4) + particle.v) * BASE3D_PIXEL_UV_SCALE;
-                        GX_VertexLitF(vertex, particle.brightness);
-                    }
+                    vertex.i = brightness;
+                    vertex.u = ((x << 2) + data.u) * BASE3D_PIXEL_UV_SCALE;
+                    vertex.v = ((y << 2) + data.v) * BASE3D_PIXEL_UV_SCALE;
                 }
+                else if (t == PTYPE_TINY_SMOKE)
+                {
+                    vertex.r = data.r * brightness_value;
+                    vertex.g = data.g * brightness_value;
+                    vertex.b = data.b * brightness_value;
+                    vertex.a = data.a;
+                    vertex.u = ((x << 4) + (int(system.life_times[index] * 16.0f / float(system.max_life_times[index])) << 4)) * BASE3D_PIXEL_UV_SCALE;
+                    vertex.v = (y << 4) * BASE3D_PIXEL_UV_SCALE;
+                }
+                else
+                {
+                    vertex.i = brightness;
+                    vertex.u = ((x << 4) + data.u) * BASE3D_PIXEL_UV_SCALE;
+                    vertex.v = ((y << 4) + data.v) * BASE3D_PIXEL_UV_SCALE;
+                }
+                list->put(vertex);
             }
         }
 
-        GX_EndGroup();
+        // Fill in the vertex count and pad the rest of the list with GX_NOP
+        std::memcpy(&list->buffer[1], &vertex_count, 2);
+        size_t length = list->aligned_size();
+        std::memset(list->ptr, 0, list->buffer + length - list->ptr);
+        DCFlushRange(list->buffer, length);
+
+        gertex::set_color_format(0, t == PTYPE_TINY_SMOKE ? GX_DIRECT : GX_INDEX8);
+        use_texture(t == PTYPE_BLOCK_BREAK ? terrain_texture : particles_texture);
+        gertex::call_display_list(list->buffer, length, list->attrib_size);
     }
     gertex::set_state(state);
+
+    system.stats.visible = visible_count;
+    system.stats.render_us = time_diff_us(start_time, time_get());
 }
 
 Vec3f cross(const Vec3f &a, const Vec3f &b)
@@ -847,15 +922,64 @@ void build_frustum(const Camera &cam, Frustum &frustum)
     frustum.planes[3] = make_plane(nbr, fbr, ftr); // Right
     frustum.planes[4] = make_plane(ntl, ntr, ftr); // Top
     frustum.planes[5] = make_plane(fbl, fbr, nbr); // Bottom
+
+    for (int i = 0; i < 6; i++)
+    {
+        frustum.normal_x[i] = frustum.planes[i].direction.x;
+        frustum.normal_y[i] = frustum.planes[i].direction.y;
+        frustum.normal_z[i] = frustum.planes[i].direction.z;
+        frustum.distance[i] = frustum.planes[i].distance;
+    }
 }
 
+// Immediate mode geometry recorded into a display list, so it is only built again when it changes
+struct CompiledList
+{
+    uint8_t *buffer = nullptr;
+    uint32_t capacity = 0;
+    uint32_t length = 0;
+    uint32_t vertex_size = 0;
+    uint32_t key = 0;
+
+    // Starts recording the GX commands into the list until end is called
+    void begin(uint32_t vertices, uint32_t vertex_size)
+    {
+        uint32_t size = ((vertices * vertex_size + 3 + 31) & ~31) + 32; // Room for the header and GX_EndDispList
+        if (size > capacity)
+        {
+            if (buffer)
+                ::operator delete[](buffer, std::align_val_t(32));
+            buffer = new (std::align_val_t(32)) uint8_t[size];
+            capacity = size;
+        }
+        this->vertex_size = vertex_size;
+        DCInvalidateRange(buffer, capacity);
+        GX_BeginDispList(buffer, capacity);
+        gertex::begin_recording();
+    }
+
+    void end()
+    {
+        gertex::end_recording();
+        length = GX_EndDispList();
+        if (length)
+            DCFlushRange(buffer, length);
+    }
+
+    void draw()
+    {
+        if (length)
+            gertex::call_display_list(buffer, length, vertex_size);
+    }
+};
+
 void draw_stars()
 {
     static bool generated = false;
-    static std::vector<Vec3f> vertices;
+    static CompiledList list;
     if (!generated)
     {
-        vertices.resize(6000); // 1500 quads
+        std::vector<Vec3f> vertices(6000); // 1500 quads
         javaport::Random rng(10842);
         size_t index = 0;
         for (size_t i = 0; i < 1500; i++)
@@ -900,15 +1024,23 @@ void draw_stars()
         }
         // Resize the vector to the actual number of vertices generated
         vertices.resize(index);
+
+        // The stars are white in the list and tinted to the current brightness when drawn
+        list.begin(vertices.size(), VERTEX_ATTR_LENGTH_DIRECTCOLOR);
+        GX_BeginGroup(GX_QUADS, vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+            GX_Vertex(Vertex(vertices[i ^ 3], 0, 0, 255, 255, 255, 255));
+        GX_EndGroup();
+        list.end();
         generated = true;
     }
-    int brightness_level = (get_star_brightness() * 255);
+    uint8_t brightness_level = (get_star_brightness() * 255);
     if (brightness_level > 0)
     {
-        GX_BeginGroup(GX_QUADS, vertices.size());
-        for (size_t i = 0; i < vertices.size(); i++)
-            GX_Vertex(Vertex(vertices[i ^ 3], 0, 0, brightness_level, brightness_level, brightness_level, brightness_level));
-        GX_EndGroup();
+        GXColor color_mul = gertex::get_color_mul();
+        gertex::set_color_mul(GXColor{brightness_level, brightness_level, brightness_level, 0xFF});
+        list.draw();
+        gertex::set_color_mul(color_mul);
     }
 }
 
@@ -1069,25 +1201,35 @@ void draw_sunrise()
     /*
     transform_view(mtx, get_camera().position);
     */
-    uint8_t quality = 16;
-    float centerX = 0.0f;
-    float centerY = 100.0f;
-    float centerZ = 0.0f;
+    // The glow only changes with the color, so it is recorded again only when that does
+    static CompiledList list;
+    uint32_t key = (uint32_t(r) << 24) | (g << 16) | (b << 8) | a;
+    if (!list.length || list.key != key)
+    {
+        uint8_t quality = 16;
+        float centerX = 0.0f;
+        float centerY = 100.0f;
+        float centerZ = 0.0f;
 
-    GX_BeginGroup(GX_TRIANGLEFAN, quality + 2);
+        list.begin(quality + 2, VERTEX_ATTR_LENGTH_FLOATPOS_DIRECTCOLOR);
+        GX_BeginGroup(GX_TRIANGLEFAN, quality + 2);
 
-    // Draw the center vertex
-    GX_VertexF(Vertex(Vec3f(centerX, centerY, centerZ), 0, 0, r, g, b, a));
+        // Draw the center vertex
+        GX_VertexF(Vertex(Vec3f(centerX, centerY, centerZ), 0, 0, r, g, b, a));
 
-    // Draw the outer vertices
-    for (int i = 0; i <= quality; ++i)
-    {
-        float v = (float)i * (float)M_PI * -2.0f / (float)quality;
-        float x = std::sin(v);
-        float z = std::cos(v);
-        GX_VertexF(Vertex(Vec3f(x * 120.0f, z * 120.0f, -z * 40.0f * sunrise_color[3]), 0, 0, r, g, b, 0));
+        // Draw the outer vertices
+        for (int i = 0; i <= quality; ++i)
+        {
+            float v = (float)i * (float)M_PI * -2.0f / (float)quality;
+            float x = std::sin(v);
+            float z = std::cos(v);
+            GX_VertexF(Vertex(Vec3f(x * 120.0f, z * 120.0f, -z * 40.0f * sunrise_color[3]), 0, 0, r, g, b, 0));
+        }
+        GX_EndGroup();
+        list.end();
+        list.key = key;
     }
-    GX_EndGroup();
+    list.draw();
 
     gertex::set_state(state);
 }
@@ -1131,22 +1273,34 @@ void draw_sky()
 
         float sky_dist = FOG_DISTANCE * 2 / BASE3D_POS_FRAC;
         GXColor sky_color = get_sky_color();
+        uint8_t top_alpha = uint8_t(sky_alpha * 255);
 
-        // Approach 2: Draw XZ cylinder (without caps) with radius = sky_dist, with 16 faces
-        GX_BeginGroup(GX_TRIANGLES, 48);
-        for (int i = 0; i < 16;)
+        // The vertex alpha can't be tinted when drawing, so the dome is recorded again when its colors change
+        static CompiledList dome;
+        uint32_t key = (uint32_t(sky_color.r) << 24) | (sky_color.g << 16) | (sky_color.b << 8) | top_alpha;
+        if (!dome.length || dome.key != key)
         {
-            float v1 = (float)i++ * (float)M_PI * 2.0f / 16.0f;
-            float v2 = (float)i * (float)M_PI * 2.0f / 16.0f;
-            float x1 = std::sin(v1);
-            float z1 = std::cos(v1);
-            float x2 = std::sin(v2);
-            float z2 = std::cos(v2);
-            GX_Vertex(Vertex(Vec3f(x1 * sky_dist, 0, z1 * sky_dist), 0, 1, sky_color.r, sky_color.g, sky_color.b, 0));
-            GX_Vertex(Vertex(Vec3f(x2 * sky_dist, 0, z2 * sky_dist), 1, 1, sky_color.r, sky_color.g, sky_color.b, 0));
-            GX_Vertex(Vertex(Vec3f(0, +1, 0), 1, 0, sky_color.r, sky_color.g, sky_color.b, uint8_t(sky_alpha * 255)));
+            dome.begin(48, VERTEX_ATTR_LENGTH_DIRECTCOLOR);
+
+            // Approach 2: Draw XZ cylinder (without caps) with radius = sky_dist, with 16 faces
+            GX_BeginGroup(GX_TRIANGLES, 48);
+            for (int i = 0; i < 16;)
+            {
+                float v1 = (float)i++ * (float)M_PI * 2.0f / 16.0f;
+                float v2 = (float)i * (float)M_PI * 2.0f / 16.0f;
+                float x1 = std::sin(v1);
+                float z1 = std::cos(v1);
+                float x2 = std::sin(v2);
+                float z2 = std::cos(v2);
+                GX_Vertex(Vertex(Vec3f(x1 * sky_dist, 0, z1 * sky_dist), 0, 1, sky_color.r, sky_color.g, sky_color.b, 0));
+                GX_Vertex(Vertex(Vec3f(x2 * sky_dist, 0, z2 * sky_dist), 1, 1, sky_color.r, sky_color.g, sky_color.b, 0));
+                GX_Vertex(Vertex(Vec3f(0, +1, 0), 1, 0, sky_color.r, sky_color.g, sky_color.b, top_alpha));
+            }
+            GX_EndGroup();
+            dome.end();
+            dome.key = key;
         }
-        GX_EndGroup();
+        dome.draw();
 
         // Restore previous blend params
         gertex::set_blending(gertex::GXBlendMode::additive);
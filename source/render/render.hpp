@@ -22,10 +22,11 @@
 #include <render/transform.hpp>
 #include <render/camera.hpp>
 
-extern mutex_t render_mutex;
-
 extern uint8_t light_map[1024];
 
+// Corners of each cube face in vertex order, -1 for the minimum and 1 for the maximum of an axis
+extern const Vec3i cube_vertices[6][4];
+
 struct Plane
 {
     Vec3f direction;
@@ -35,10 +36,22 @@ struct Plane
 struct Frustum
 {
     Plane planes[6]; // Six planes of the frustum
+
+    // The same planes one component per array, so the box tests run over plain float arrays
+    float normal_x[6];
+    float normal_y[6];
+    float normal_z[6];
+    float distance[6];
 };
 
+// Results of classify_boxes
+#define FRUSTUM_OUTSIDE 0
+#define FRUSTUM_PARTIAL 1
+#define FRUSTUM_INSIDE 2
+
 
 class World;
+struct SectionSnapshot;
 
 extern World *render_world;
 
@@ -50,9 +63,22 @@ void update_textures();
 
 void use_texture(GXTexObj &texture);
 
-int render_face(gertex::DisplayList<gertex::Vertex16> *list, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block = nullptr, uint8_t min_y = 0, uint8_t max_y = 16);
+// Sets up the vertex formats that section display lists are built with.
+void use_terrain_vertex_format();
+
+// Makes texture stage 0 repeat the tile of each face instead of sampling the atlas
+// directly, for the tiled pass of the sections. See BASE3D_TILED_VTXFMT.
+void use_tiled_terrain(bool enable);
 
-int render_back_face(gertex::DisplayList<gertex::Vertex16> *list, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block = nullptr, uint8_t min_y = 0, uint8_t max_y = 16);
+// Builds a face of the block at pos, lit from the snapshot. Without a snapshot the face takes the light of the block.
+void get_face(SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block, uint8_t min_y, uint8_t max_y, gertex::Vertex16 *out_vertices, uint8_t *out_lighting, uint8_t *out_ao);
+
+// Puts a face built by get_face into the list. The block breaking tiles (240-249) are always drawn at full brightness.
+int put_face(gertex::DisplayList<gertex::Vertex16> *list, uint8_t face, uint32_t texture_index, gertex::Vertex16 *vertices, uint8_t *lighting, uint8_t *ao, bool back_face = false);
+
+int render_face(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block = nullptr, uint8_t min_y = 0, uint8_t max_y = 16);
+
+int render_back_face(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, Vec3i pos, uint8_t face, uint32_t texture_index, BlockState *block = nullptr, uint8_t min_y = 0, uint8_t max_y = 16);
 
 void render_single_block_at(BlockState &selected_block, const Vec3i &pos, uint8_t frac_bits);
 
@@ -70,6 +96,10 @@ Vec3f vector_to_angles(const Vec3f &vec);
 
 bool is_cube_visible(const Frustum &frustum, const Vec3f &center, float size);
 
+// Classifies count boxes of the same half extent against the frustum. The box centers are
+// given one component per array and the results are written as FRUSTUM_OUTSIDE, FRUSTUM_PARTIAL or FRUSTUM_INSIDE.
+void classify_boxes(const Frustum &frustum, const float *center_x, const float *center_y, const float *center_z, const Vec3f &half_extent, int count, uint8_t *out);
+
 gertex::GXProjMatrix create_offset_perspective(const gertex::GXView &view, float x_pixel, float y_pixel);
 
 void build_frustum(const Camera &cam, Frustum &frustum);
@@ -82,7 +112,7 @@ GXColor get_fog_color();
 
 GXColor get_lightmap_color(uint8_t light);
 
-void draw_particles(Camera &camera, Particle *particles, int count);
+void draw_particles(Camera &camera, ParticleSystem &system);
 
 void draw_frustum(const Camera &cam);
 
@@ -1,77 +1,72 @@
 #include "render_blocks.hpp"
 
-#include <functional>
 #include <world/world.hpp>
 #include <world/chunk.hpp>
 #include <block/blocks.hpp>
 #include <registry/block_list.hpp>
 #include <render/render.hpp>
+#include <render/section_snapshot.hpp>
 #include <gertex/displaylist.hpp>
 #include <blocks/block_redstone_wire.hpp>
 
-static std::map<RenderType, std::function<int(gertex::DisplayList<gertex::Vertex16> *list, BlockState *, const Vec3i &)>> render_functions = {
-    {RenderType::full, render_cube},
-    {RenderType::full_special, render_cube_special},
-    {RenderType::cross, render_cross},
-    {RenderType::flat_ground, render_flat_ground},
-    {RenderType::slab, render_slab},
-    {RenderType::special, render_special},
-    {RenderType::fluid, render_nothing}};
+BlockMeshInfo block_mesh_table[256];
 
-int render_nothing(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+void build_block_mesh_table()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        BlockBase *block = block_list[i];
+        BlockMeshInfo &info = block_mesh_table[i];
+        info.render = block->render_func();
+        info.colored = block->colored();
+        info.full_cube = info.render == render_cube || info.render == render_cube_special;
+    }
+}
+
+int render_nothing(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     return 0;
 }
 
-int render_cube(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_cube_faces(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos, bool inverted, uint8_t *out_faces)
 {
     int vertexCount = 0;
+    uint8_t faces = 0;
     BlockBase *b = block_list[block->id];
     for (uint8_t i = 0; i < 6; i++)
     {
-        if (!render_world || b->should_render_side(render_world, pos, i))
-            vertexCount += render_face(list, pos, i, get_texture_index(render_world, pos, i, block), block);
+        if (snapshot && !b->should_render_side(snapshot, pos, i))
+            continue;
+        uint32_t texture_index = get_texture_index(snapshot, pos, i, block);
+        vertexCount += inverted ? render_back_face(list, snapshot, pos, i, texture_index, block) : render_face(list, snapshot, pos, i, texture_index, block);
+        faces |= 1 << i;
     }
+    if (out_faces)
+        *out_faces = faces;
     return vertexCount;
 }
 
-int render_inverted_cube(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_cube(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
-    int vertexCount = 0;
-    BlockBase *b = block_list[block->id];
-    for (uint8_t i = 0; i < 6; i++)
-    {
-        if (!render_world || b->should_render_side(render_world, pos, i))
-            vertexCount += render_back_face(list, pos, i, get_texture_index(render_world, pos, i, block), block);
-    }
-    return vertexCount;
+    return render_cube_faces(list, snapshot, block, pos, false);
 }
 
-int render_inverted_cube_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_inverted_cube(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
-    int vertexCount = 0;
-    BlockBase *b = block_list[block->id];
-    for (uint8_t i = 0; i < 6; i++)
-    {
-        if (!render_world || b->should_render_side(render_world, pos, i))
-            vertexCount += render_back_face(list, pos, i, get_texture_index(render_world, pos, i, block), block);
-    }
-    return vertexCount;
+    return render_cube_faces(list, snapshot, block, pos, true);
 }
 
-int render_cube_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_inverted_cube_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
-    int vertexCount = 0;
-    BlockBase *b = block_list[block->id];
-    for (uint8_t i = 0; i < 6; i++)
-    {
-        if (!render_world || b->should_render_side(render_world, pos, i))
-            vertexCount += render_face(list, pos, i, get_texture_index(render_world, pos, i, block), block);
-    }
-    return vertexCount;
+    return render_cube_faces(list, snapshot, block, pos, true);
 }
 
-int render_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_cube_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
+{
+    return render_cube_faces(list, snapshot, block, pos, false);
+}
+
+int render_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     switch (block->blockid)
     {
@@ -79,18 +74,18 @@ int render_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *bloc
     case BlockID::unlit_redstone_torch:
     case BlockID::redstone_torch:
     case BlockID::lever:
-        return render_torch(list, block, pos);
+        return render_torch(list, snapshot, block, pos);
     case BlockID::wooden_door:
     case BlockID::iron_door:
-        return render_door(list, block, pos);
+        return render_door(list, snapshot, block, pos);
     case BlockID::cactus:
-        return render_cactus(list, block, pos);
+        return render_cactus(list, snapshot, block, pos);
     default:
         return 0;
     }
 }
 
-int render_flat_ground(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_flat_ground(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     uint8_t lighting = block->light;
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
@@ -112,7 +107,7 @@ int render_flat_ground(gertex::DisplayList<gertex::Vertex16> *list, BlockState *
     return 4;
 }
 
-int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
     Vec3f vertex_pos(local_pos.x, local_pos.y, local_pos.z);
@@ -120,13 +115,13 @@ int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, BlockState *b
     int vertexCount = 4;
 
     // Top
-    render_face(list, pos, FACE_PY, texture_index, block, 0, 2);
+    render_face(list, snapshot, pos, FACE_PY, texture_index, block, 0, 2);
 
     BlockID neighbor_ids[6];
     {
-        BlockState *neighbors[6];
-        if (render_world)
-            render_world->get_neighbors(pos, neighbors);
+        BlockState *neighbors[6] = {nullptr};
+        if (snapshot)
+            snapshot->get_neighbors(pos, neighbors);
         for (int i = 0; i < 6; i++)
         {
             neighbor_ids[i] = neighbors[i] ? neighbors[i]->blockid : BlockID::air;
@@ -136,31 +131,31 @@ int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, BlockState *b
     if ((block->visibility_flags & VIS_NX) && neighbor_ids[FACE_NX] != BlockID::snow_layer)
     {
         // Negative X
-        render_face(list, pos, FACE_NX, texture_index, block, 0, 2);
+        render_face(list, snapshot, pos, FACE_NX, texture_index, block, 0, 2);
         vertexCount += 4;
     }
     if ((block->visibility_flags & VIS_PX) && neighbor_ids[FACE_PX] != BlockID::snow_layer)
     {
         // Positive X
-        render_face(list, pos, FACE_PX, texture_index, block, 0, 2);
+        render_face(list, snapshot, pos, FACE_PX, texture_index, block, 0, 2);
         vertexCount += 4;
     }
     if ((block->visibility_flags & VIS_NZ) && neighbor_ids[FACE_NZ] != BlockID::snow_layer)
     {
         // Negative Z
-        render_face(list, pos, FACE_NZ, texture_index, block, 0, 2);
+        render_face(list, snapshot, pos, FACE_NZ, texture_index, block, 0, 2);
         vertexCount += 4;
     }
     if ((block->visibility_flags & VIS_PZ) && neighbor_ids[FACE_PZ] != BlockID::snow_layer)
     {
         // Positive Z
-        render_face(list, pos, FACE_PZ, texture_index, block, 0, 2);
+        render_face(list, snapshot, pos, FACE_PZ, texture_index, block, 0, 2);
         vertexCount += 4;
     }
     return vertexCount;
 }
 
-int render_torch(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_torch(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
     Vec3f vertex_pos(local_pos.x, local_pos.y + 0.1875, local_pos.z);
@@ -222,7 +217,7 @@ int render_torch_with_angle(gertex::DisplayList<gertex::Vertex16> *list, BlockSt
     return 20;
 }
 
-int render_door(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_door(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     uint8_t lighting = block->light;
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
@@ -346,7 +341,7 @@ int render_door(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
     return 20;
 }
 
-int render_cactus(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_cactus(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
 
     uint8_t lighting = block->light;
@@ -412,7 +407,7 @@ int render_cactus(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block
     list->put(gertex::Vertex16{.x = x0, .y = y0, .z = int16_t(z0 + 1), .i = lighting, .nrm = FACE_NZ, .u = float(TEXTURE_PX(texture_index)), .v = float(TEXTURE_PY(texture_index))});
     return vertexCount;
 }
-int render_cross(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_cross(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     uint8_t lighting = block->light;
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
@@ -453,13 +448,13 @@ int render_cross(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
     return 16;
 }
 
-int render_slab(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_slab(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     Vec3i local_pos(pos.x & 0xF, pos.y & 0xF, pos.z & 0xF);
     Vec3f vertex_pos(local_pos.x, local_pos.y, local_pos.z);
 
     // Check for texture overrides
-    uint32_t texture_index = get_texture_index(render_world, pos, +BlockFace::PY, block);
+    uint32_t texture_index = get_texture_index(snapshot, pos, +BlockFace::PY, block);
     uint32_t top_index = texture_index;
     uint32_t side_index = top_index - 1;
     uint32_t bottom_index = top_index;
@@ -493,27 +488,33 @@ int render_slab(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
     if (texture_index != properties(block->id).m_texture_index)
         bottom_index = side_index = top_index = texture_index;
 
+    // Without a snapshot, as when drawn as an item, every side is shown
+    auto should_render_side = [&](uint8_t face) -> bool
+    {
+        return !snapshot || block_list[block->id]->should_render_side(snapshot, pos, face);
+    };
+
     int vertexCount = 0;
     int min_y = top_half ? 8 : 0;
     int max_y = min_y + 8;
     if (top_half)
     {
         vertex_pos = vertex_pos + Vec3f(0, 0.5, 0);
-        if (!block_list[block->id]->should_render_side(render_world, pos, +BlockFace::PY))
+        if (!should_render_side(+BlockFace::PY))
             render_top = false;
     }
     else
     {
-        if (!block_list[block->id]->should_render_side(render_world, pos, +BlockFace::NY))
+        if (!should_render_side(+BlockFace::NY))
             render_bottom = false;
     }
     bool faces[6] = {
-        block_list[block->id]->should_render_side(render_world, pos, +BlockFace::NX),
-        block_list[block->id]->should_render_side(render_world, pos, +BlockFace::PX),
+        should_render_side(+BlockFace::NX),
+        should_render_side(+BlockFace::PX),
         render_bottom,
         render_top,
-        block_list[block->id]->should_render_side(render_world, pos, +BlockFace::NZ),
-        block_list[block->id]->should_render_side(render_world, pos, +BlockFace::PZ)};
+        should_render_side(+BlockFace::NZ),
+        should_render_side(+BlockFace::PZ)};
 
     for (int i = 0; i < 6; i++)
     {
@@ -524,13 +525,13 @@ int render_slab(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
                 face_texture_index = bottom_index;
             else if (i == +BlockFace::PY)
                 face_texture_index = top_index;
-            vertexCount += render_face(list, pos, i, face_texture_index, block, min_y, max_y);
+            vertexCount += render_face(list, snapshot, pos, i, face_texture_index, block, min_y, max_y);
         }
     }
     return vertexCount;
 }
 
-int render_wire(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos)
+int render_wire(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos)
 {
     const Vec3i offsets[4]{
         {-1, 0, 0},
@@ -565,16 +566,21 @@ int render_wire(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
         false,
         false,
     };
-    bool has_opaque_above = block_at(render_world, pos + Vec3i{0, 1, 0})->is_opaque();
-
-    for (uint8_t i = 0; i < 4; i++)
-        has_connection[i] = BlockRedstoneWire::is_source_or_wire(render_world, pos + offsets[i]) ||
-                            (!block_at(render_world, pos + offsets[i])->is_opaque() && BlockRedstoneWire::is_source_or_wire(render_world, pos + offsets[i] - Vec3i{0, 1, 0}));
-
-    if (!has_opaque_above)
+    // Without a snapshot the wire is drawn unconnected
+    bool has_opaque_above = false;
+    if (snapshot)
     {
+        has_opaque_above = block_at(snapshot, pos + Vec3i{0, 1, 0})->is_opaque();
+
         for (uint8_t i = 0; i < 4; i++)
-            has_connection[i] |= (has_diagonal_connection[i] = (block_at(render_world, pos + offsets[i])->is_opaque() && BlockRedstoneWire::is_source_or_wire(render_world, pos + offsets[i] + Vec3i{0, 1, 0})));
+            has_connection[i] = BlockRedstoneWire::is_source_or_wire(snapshot, pos + offsets[i]) ||
+                                (!block_at(snapshot, pos + offsets[i])->is_opaque() && BlockRedstoneWire::is_source_or_wire(snapshot, pos + offsets[i] - Vec3i{0, 1, 0}));
+
+        if (!has_opaque_above)
+        {
+            for (uint8_t i = 0; i < 4; i++)
+                has_connection[i] |= (has_diagonal_connection[i] = (block_at(snapshot, pos + offsets[i])->is_opaque() && BlockRedstoneWire::is_source_or_wire(snapshot, pos + offsets[i] + Vec3i{0, 1, 0})));
+        }
     }
 
     int16_t x0 = x;
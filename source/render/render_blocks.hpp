@@ -4,23 +4,45 @@
 #include <cstdint>
 #include <math/vec3i.hpp>
 #include <gertex/displaylist.hpp>
+#include <block/block_base.hpp>
 
 class BlockState;
+struct SectionSnapshot;
 
-int render_nothing(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_cube(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_inverted_cube(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_cube_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_inverted_cube_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_special(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_flat_ground(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_torch(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
+// Per-block mesher data, looked up by block id instead of going through BlockBase.
+struct BlockMeshInfo
+{
+    BlockRenderFunc render;
+    bool colored;
+    bool full_cube; // Rendered by render_cube or render_cube_special
+};
+
+extern BlockMeshInfo block_mesh_table[256];
+
+// Fills the mesh table from the registered blocks. Call after registering blocks.
+void build_block_mesh_table();
+
+// The render functions read the neighbours from the snapshot of the section being
+// meshed. Without one, as for blocks drawn on their own, every side is put.
+
+// Puts the visible faces of a cube, the back faces if inverted. Sets a bit in
+// out_faces for every face that was put, in FACE_* order.
+int render_cube_faces(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos, bool inverted, uint8_t *out_faces = nullptr);
+
+int render_nothing(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_cube(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_inverted_cube(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_cube_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_inverted_cube_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_special(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_flat_ground(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_snow_layer(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_torch(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
 int render_torch_with_angle(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3f &vertex_pos, float ax, float az);
-int render_cactus(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_door(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_cross(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_slab(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
-int render_wire(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos);
+int render_cactus(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_door(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_cross(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_slab(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
+int render_wire(gertex::DisplayList<gertex::Vertex16> *list, SectionSnapshot *snapshot, BlockState *block, const Vec3i &pos);
 
 #endif
\ No newline at end of file
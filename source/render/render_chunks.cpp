@@ -4,145 +4,993 @@
 #include "render_fluids.hpp"
 #include "render.hpp"
 
+#include "section_snapshot.hpp"
+
+#include <deque>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <stdexcept>
 #include <util/lock.hpp>
+#include <util/timers.hpp>
+#include <util/worker_thread.hpp>
 #include <world/chunk.hpp>
 #include <world/world.hpp>
 #include <gertex/displaylist.hpp>
 #include <registry/block_list.hpp>
+#include <block/blocks.hpp>
 
 extern bool render_fast_leaves;
 
 namespace ChunkRenderer
 {
-    void render_section(Section &section, bool transparent, VBO &section_vbo)
+    static MeshStats mesh_stats[2];
+
+    // Scratch lists start out big enough for most sections and double in size
+    // when a section does not fit, up to the most vertices a section can have.
+    static constexpr uint16_t SCRATCH_MIN_VERTICES = 8192;
+    static constexpr uint16_t SCRATCH_MAX_VERTICES = 64000;
+
+    // Scratch display lists that the section meshes are written into before
+    // being copied to a buffer of their exact size. They are allocated when
+    // first used and reused for every section meshed by the same thread.
+    struct MeshScratch
     {
-        if (transparent)
-        {
-            gertex::DisplayList<gertex::Vertex16> colored_list(64000, VERTEX_ATTR_LENGTH_DIRECTCOLOR);
-            uint16_t quad_vertices = render_section_colored(&colored_list, section, transparent, 64000U);
-            std::memcpy(&colored_list.buffer[1], &quad_vertices, 2);
+        gertex::DisplayListCompact16 colored = gertex::DisplayListCompact16(SCRATCH_MIN_VERTICES, VERTEX_ATTR_LENGTH_TERRAIN_DIRECTCOLOR, BASE3D_TERRAIN_VTXFMT, BASE3D_TERRAIN_UV_FRAC_BITS);
+        gertex::DisplayListCompact16 blocks = gertex::DisplayListCompact16(SCRATCH_MIN_VERTICES, VERTEX_ATTR_LENGTH_TERRAIN, BASE3D_TERRAIN_VTXFMT, BASE3D_TERRAIN_UV_FRAC_BITS);
+        gertex::DisplayListCompact16 tiled = gertex::DisplayListCompact16(SCRATCH_MIN_VERTICES, VERTEX_ATTR_LENGTH_TERRAIN, BASE3D_TILED_VTXFMT, BASE3D_TILED_UV_FRAC_BITS);
+    };
+
+    // Plane axes (u, v) and slice axis for each face direction
+    static const uint8_t greedy_face_axes[6][3] = {
+        {2, 1, 0}, // FACE_NX
+        {2, 1, 0}, // FACE_PX
+        {0, 2, 1}, // FACE_NY
+        {0, 2, 1}, // FACE_PY
+        {0, 1, 2}, // FACE_NZ
+        {0, 1, 2}, // FACE_PZ
+    };
+
+    struct GreedyFace
+    {
+        bool valid;
+        uint8_t texture_index;
+        uint8_t lighting;
+        uint8_t ao;
+        gertex::Vertex16 vertices[4];
+    };
+
+    // Faces of a pass whose light can be patched later, see BufferPass::light_faces
+    struct LightRecords
+    {
+        std::vector<uint16_t> faces;
+        uint16_t counts[SECTION_SLAB_COUNT];
+        uint8_t patchable;
+    };
+
+    // Everything a thread needs to mesh sections on its own. The first
+    // context belongs to the chunk manager thread, the rest to the workers.
+    struct MeshContext
+    {
+        SectionSnapshot snapshot;
+        MeshScratch scratch;
+        GreedyFace greedy_mask[16][16];
+
+        // Faces written by render_section_blocks, in the order they were put
+        std::vector<uint16_t> face_records;
+
+        // Faces written by render_section_greedy, each followed by its size (see BufferPass::light_faces)
+        std::vector<uint16_t> tiled_face_records;
+        LightRecords light_records;
+        LightRecords tiled_records;
+        LightRecords colored_records;
+
+        // Vertices removed by merging faces in the current mesh
+        uint32_t saved_vertices = 0;
+
+        // New light indices while patching a section
+        std::vector<uint8_t> patch_light;
 
-            size_t colored_displist_size = colored_list.aligned_size();
-            uint8_t *colored_displist_buf = colored_list.build();
-            DCFlushRange(colored_displist_buf, colored_displist_size);
-            Lock lock(render_mutex);
-            section.colored.uncached.buffer = colored_displist_buf;
-            section.colored.uncached.length = colored_displist_size;
+        // Built from the snapshot when the first fluid of a section is meshed
+        FluidGrid fluid_grid;
+        bool fluid_grid_ready = false;
+    };
+
+    static_assert(MAX_MESH_WORKERS < MAX_SNAPSHOT_THREADS, "Each mesh worker needs its own snapshot");
+    static MeshContext mesh_contexts[MAX_SNAPSHOT_THREADS];
+
+    // Mesh worker threads and the sections queued for them. The workers sleep on
+    // the condition variable while the queue is empty.
+    struct MeshWorkers
+    {
+        Mutex mutex;
+        CondVar jobs_queued;
+        std::deque<Section *> jobs;
+        bool active = true;
+        WorkerThread *threads[MAX_MESH_WORKERS] = {nullptr};
+    };
+
+    static MeshWorkers *mesh_workers = nullptr;
+    static int mesh_worker_count = 0;
+
+    static uint32_t mesh_section(MeshContext &context, Section &section, bool transparent, BufferPass &pass);
+    static void release_context(MeshContext &context);
+    static uint16_t render_section_fluids(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count, int min_y, int max_y);
+    static uint16_t render_section_blocks(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, bool greedy, uint16_t max_vertex_count, int min_y, int max_y);
+    static uint16_t render_section_colored(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, uint16_t max_vertex_count, int min_y, int max_y);
+    static uint16_t render_section_greedy(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, uint16_t max_vertex_count, int min_y, int max_y);
+
+    MeshStats &get_mesh_stats(bool smooth_lighting)
+    {
+        return mesh_stats[smooth_lighting];
+    }
+
+    static void update_mesh_stats(bool smooth_lighting, uint64_t start_time, uint32_t vertex_count, uint32_t saved_vertices)
+    {
+        MeshStats &stats = mesh_stats[smooth_lighting];
+        stats.last_us = time_diff_us(start_time, time_get());
+        stats.last_vertices = vertex_count;
+        stats.last_saved_vertices = saved_vertices;
+        stats.average_us = stats.sections ? (stats.average_us * 15 + stats.last_us) / 16 : stats.last_us;
+        stats.average_vertices = stats.sections ? (stats.average_vertices * 15 + stats.last_vertices) / 16 : stats.last_vertices;
+        stats.average_saved_vertices = stats.sections ? (stats.average_saved_vertices * 15 + stats.last_saved_vertices) / 16 : stats.last_saved_vertices;
+        stats.sections++;
+    }
+
+    void render_section(Section &section, bool transparent, BufferPass &pass)
+    {
+        uint64_t start_time = time_get();
+        MeshContext &context = mesh_contexts[0];
+
+        // Copy the blocks the mesher can see so it never touches the live world.
+        bool smooth_lighting = section.chunk->world->smooth_lighting;
+        {
+            // The main thread unloads chunks while holding this lock, see mesh_worker_thread
+            Lock lock(section.chunk->world->chunk_mutex);
+            context.snapshot.build(section.chunk->world, Vec3i(section.x, section.y, section.z));
         }
 
-        gertex::DisplayList<gertex::Vertex16> list(64000, VERTEX_ATTR_LENGTH);
-        // Render the block mesh
-        uint16_t quad_vertices = render_section_blocks(&list, section, transparent, 64000U);
+        // The chunk of the section was unloaded meanwhile, so its mesh is not needed anymore
+        if (!context.snapshot.section_present())
+            return;
+        uint32_t vertex_count = mesh_section(context, section, transparent, pass);
+        update_mesh_stats(smooth_lighting, start_time, vertex_count, context.saved_vertices);
+    }
 
-        size_t tri_offset = list.size();
+    // Returns the next queued section, or nullptr once the workers are stopped.
+    static Section *next_mesh_job()
+    {
+        LockGuard lock(mesh_workers->mutex);
+        while (mesh_workers->active && mesh_workers->jobs.empty())
+            mesh_workers->jobs_queued.wait(mesh_workers->mutex);
+        if (!mesh_workers->active)
+            return nullptr;
+        Section *section = mesh_workers->jobs.front();
+        mesh_workers->jobs.pop_front();
+        return section;
+    }
 
-        if (tri_offset <= 3)
+    static void *mesh_worker_thread(MeshContext *context_ptr)
+    {
+        MeshContext &context = *context_ptr;
+        while (Section *section = next_mesh_job())
         {
-            // No quads drawn
-            tri_offset = 0;
-            list.rewind();
+            Chunk *chunk = section->chunk;
+            uint64_t start_time = time_get();
+            bool smooth_lighting = chunk->world->smooth_lighting;
+            bool loaded;
+            {
+                // Chunks are unloaded while holding this lock, so check that the chunk is still
+                // loaded and that its blocks made it into the snapshot before meshing it
+                Lock lock(chunk->world->chunk_mutex);
+                loaded = chunk->state == ChunkState::done;
+                if (loaded)
+                {
+                    context.snapshot.build(chunk->world, Vec3i(section->x, section->y, section->z));
+                    loaded = context.snapshot.section_present();
+                }
+            }
+            if (loaded)
+            {
+                // The buffers are only published once complete, and are swapped in at the start of a frame
+                uint32_t vertex_count = mesh_section(context, *section, false, section->solid);
+                update_mesh_stats(smooth_lighting, start_time, vertex_count, context.saved_vertices);
+
+                start_time = time_get();
+                vertex_count = mesh_section(context, *section, true, section->transparent);
+                update_mesh_stats(smooth_lighting, start_time, vertex_count, context.saved_vertices);
+            }
+            section->mesh_pending = false;
         }
+        return nullptr;
+    }
 
-        // Render the fluid mesh
-        uint16_t tri_vertices = render_section_fluids(&list, section, transparent, 64000U);
+    static void release_list(gertex::DisplayList<gertex::Vertex16> &list)
+    {
+        delete[] list.buffer;
+        list.buffer = list.ptr = nullptr;
+        list.max_vertices = SCRATCH_MIN_VERTICES;
+    }
 
-        if (list.size() <= 3)
+    // Frees the scratch lists and buffers of a context that no thread uses anymore.
+    static void release_context(MeshContext &context)
+    {
+        release_list(context.scratch.colored);
+        release_list(context.scratch.blocks);
+        release_list(context.scratch.tiled);
+        std::vector<uint16_t>().swap(context.face_records);
+        std::vector<uint16_t>().swap(context.tiled_face_records);
+        std::vector<uint16_t>().swap(context.light_records.faces);
+        std::vector<uint16_t>().swap(context.tiled_records.faces);
+        std::vector<uint8_t>().swap(context.patch_light);
+    }
+
+    void start_mesh_workers(int count)
+    {
+        stop_mesh_workers();
+        count = std::clamp(count, 0, MAX_MESH_WORKERS);
+        if (!count)
+            return;
+        mesh_workers = new MeshWorkers;
+        for (int i = 0; i < count; i++)
         {
-            // Displaylist is essentially empty, detach and clean it up later.
-            Lock lock(render_mutex);
-            section_vbo.detach();
+            mesh_workers->threads[i] = new WorkerThread;
+            mesh_workers->threads[i]->submit(mesh_worker_thread, &mesh_contexts[i + 1]);
+        }
+        mesh_worker_count = count;
+    }
+
+    void stop_mesh_workers()
+    {
+        if (!mesh_workers)
             return;
+        {
+            LockGuard lock(mesh_workers->mutex);
+            mesh_workers->active = false;
+            mesh_workers->jobs_queued.broadcast();
+        }
+
+        // Deleting a worker waits for it to finish the section it is meshing
+        for (WorkerThread *&thread : mesh_workers->threads)
+        {
+            delete thread;
+            thread = nullptr;
         }
 
-        // Fix quad count
-        std::memcpy(&list.buffer[1], &quad_vertices, 2);
+        // The contexts of the workers are not used until they are started again
+        for (int i = 0; i < mesh_worker_count; i++)
+            release_context(mesh_contexts[i + 1]);
+        mesh_worker_count = 0;
+
+        // Drop the jobs that were never started
+        for (Section *section : mesh_workers->jobs)
+            section->mesh_pending = false;
+        delete mesh_workers;
+        mesh_workers = nullptr;
+    }
+
+    int get_mesh_workers()
+    {
+        return mesh_worker_count;
+    }
+
+    bool queue_section(Section &section)
+    {
+        if (!mesh_workers)
+            return false;
+        LockGuard lock(mesh_workers->mutex);
+        if (mesh_workers->jobs.size() >= MAX_MESH_JOBS)
+            return false;
+        section.mesh_pending = true;
+        mesh_workers->jobs.push_back(&section);
+        mesh_workers->jobs_queued.signal();
+        return true;
+    }
 
-        // Fix triangle count (will override quad count automatically if no quads were drawn)
-        std::memcpy(&list.buffer[tri_offset + 1], &tri_vertices, 2);
+    size_t get_scratch_size()
+    {
+        size_t size = 0;
+        for (MeshContext &context : mesh_contexts)
+        {
+            if (context.scratch.colored.buffer)
+                size += context.scratch.colored.buffer_capacity();
+            if (context.scratch.blocks.buffer)
+                size += context.scratch.blocks.buffer_capacity();
+            if (context.scratch.tiled.buffer)
+                size += context.scratch.tiled.buffer_capacity();
+        }
+        return size;
+    }
 
-        size_t displist_size = list.aligned_size();
-        uint8_t *displist_buf = list.build();
+    // Copies the contents of the list into a new buffer of the exact aligned size.
+    static uint8_t *copy_display_list(gertex::DisplayList<gertex::Vertex16> &list, size_t &out_size)
+    {
+        out_size = list.aligned_size();
+        uint8_t *buffer = vbo_alloc(out_size);
+        if (!buffer)
+        {
+            out_size = 0;
+            return nullptr;
+        }
+        std::memcpy(buffer, list.buffer, list.size());
+        std::memset(buffer + list.size(), 0, out_size - list.size());
 
         // Invalidate any caches
-        DCFlushRange(displist_buf, displist_size);
+        DCFlushRange(buffer, out_size);
+        return buffer;
+    }
+
+    // Sets the vertex count of the primitive that begins at start, or removes the primitive if it has no vertices.
+    static void end_primitive(gertex::DisplayList<gertex::Vertex16> &list, size_t start, uint16_t vertices)
+    {
+        if (!vertices)
+        {
+            list.ptr = list.buffer + start;
+            return;
+        }
+        std::memcpy(&list.buffer[start + 1], &vertices, 2);
+    }
+
+    // Pads the slab that begins at start with GX_NOP commands so that it
+    // can be copied on its own later. Returns its size in 32-byte blocks.
+    static uint16_t end_slab(gertex::DisplayList<gertex::Vertex16> &list, size_t start)
+    {
+        while (list.size() & 31)
+            *list.ptr++ = 0;
+
+        // The padding may use up the slack at the end of the buffer that the next primitive header needs
+        if (list.size() > list.capacity())
+            throw std::overflow_error("DisplayList overflow");
+        return uint16_t((list.size() - start) >> 5);
+    }
+
+    // Gives a scratch list a larger buffer that fits the given size, keeping what
+    // was written to it. Returns false if the list cannot grow that large.
+    static bool grow_list(gertex::DisplayList<gertex::Vertex16> &list, size_t size)
+    {
+        uint32_t vertices = list.max_vertices;
+        while (vertices < SCRATCH_MAX_VERTICES && vertices * list.attrib_size < size)
+            vertices = std::min<uint32_t>(vertices * 2, SCRATCH_MAX_VERTICES);
+        if (vertices * list.attrib_size < size)
+            return false;
+        size_t written = list.size();
+        uint8_t *buffer = list.buffer;
+        list.max_vertices = vertices;
+        list.buffer = new (std::align_val_t(32)) uint8_t[list.buffer_capacity()];
+        std::memcpy(list.buffer, buffer, written);
+        list.ptr = list.buffer + written;
+        delete[] buffer;
+        return true;
+    }
+
+    // Copies an unchanged slab from the previous buffer of the pass.
+    static void copy_slab(gertex::DisplayList<gertex::Vertex16> &list, BufferPass &pass, int slab)
+    {
+        size_t offset = 0;
+        for (int i = 0; i < slab; i++)
+            offset += size_t(pass.slab_sizes[i]) << 5;
+        size_t length = size_t(pass.slab_sizes[slab]) << 5;
+        if (!length)
+            return;
+        if (list.size() + length > list.capacity() && !grow_list(list, list.size() + length))
+            throw std::overflow_error("DisplayList overflow");
+        std::memcpy(list.ptr, pass.uncached.buffer + offset, length);
+        list.ptr += length;
+    }
+
+    // Copies the light faces of an unchanged slab from the pass.
+    static void keep_light_faces(LightRecords &records, BufferPass &pass, int slab)
+    {
+        size_t first = 0;
+        for (int i = 0; i < slab; i++)
+            first += pass.light_face_counts[i];
+        uint16_t count = pass.light_face_counts[slab];
+        records.faces.insert(records.faces.end(), pass.light_faces.begin() + first, pass.light_faces.begin() + first + count);
+        records.counts[slab] = count;
+        records.patchable |= pass.patchable_slabs & (1 << slab);
+    }
+
+    // Replaces the uncached buffer of the pass with the contents of the list.
+    static void publish_pass(gertex::DisplayList<gertex::Vertex16> &list, BufferPass &pass, const uint16_t *slab_sizes, const LightRecords &records)
+    {
+        uint8_t *buffer = nullptr;
+        size_t size = 0;
+        if (list.size())
+            buffer = copy_display_list(list, size);
+        std::vector<uint16_t> light_faces(records.faces.begin(), records.faces.end());
+
+        // The renderer only reads the uncached buffer once the section is flagged as ready
+        pass.uncached.buffer = buffer;
+        pass.uncached.length = size;
+        std::memcpy(pass.slab_sizes, slab_sizes, sizeof(pass.slab_sizes));
+        pass.light_faces.swap(light_faces);
+        std::memcpy(pass.light_face_counts, records.counts, sizeof(pass.light_face_counts));
+        pass.patchable_slabs = records.patchable;
+
+        if (list.size() && !buffer)
+        {
+            // The arena is full and the heap may not be used, so the section is left empty
+            std::memset(pass.slab_sizes, 0, sizeof(pass.slab_sizes));
+            pass.light_faces.clear();
+            std::memset(pass.light_face_counts, 0, sizeof(pass.light_face_counts));
+            pass.patchable_slabs = 0;
+        }
+    }
+
+    // Prepares a scratch list for a new mesh, allocating its buffer if needed.
+    static void reset_list(gertex::DisplayList<gertex::Vertex16> &list)
+    {
+        if (!list.buffer)
+            list.begin(GX_QUADS);
+        list.rewind();
+    }
+
+    static void reset_light_records(LightRecords &records)
+    {
+        records.faces.clear();
+        std::memset(records.counts, 0, sizeof(records.counts));
+        records.patchable = 0;
+    }
+
+    // Writes the mesh into the scratch lists, then publishes the passes once every list is complete.
+    static uint32_t build_section_mesh(MeshContext &context, Section &section, bool transparent, BufferPass &pass)
+    {
+        // Slabs that are not being rebuilt are copied from the previous buffers
+        uint8_t slabs = section.mesh_slabs;
+        context.fluid_grid_ready = false;
+        uint16_t slab_sizes[SECTION_SLAB_COUNT];
+        uint16_t colored_sizes[SECTION_SLAB_COUNT];
+        MeshScratch &scratch = context.scratch;
+        LightRecords &records = context.light_records;
+        LightRecords &colored_records = context.colored_records;
+
+        uint32_t vertex_count = 0;
+        context.saved_vertices = 0;
+        gertex::DisplayList<gertex::Vertex16> &colored_list = scratch.colored;
+        if (transparent)
+        {
+            reset_list(colored_list);
+            reset_light_records(colored_records);
+            for (int slab = 0; slab < SECTION_SLAB_COUNT; slab++)
+            {
+                size_t slab_start = colored_list.size();
+                if (slabs & (1 << slab))
+                {
+                    int min_y = slab * SECTION_SLAB_HEIGHT;
+                    uint16_t quad_vertices = render_section_colored(context, &colored_list, section, colored_list.max_vertices, min_y, min_y + SECTION_SLAB_HEIGHT);
+                    end_primitive(colored_list, slab_start, quad_vertices);
+                    vertex_count += quad_vertices;
+                }
+                else
+                {
+                    copy_slab(colored_list, section.colored, slab);
+                }
+                colored_sizes[slab] = end_slab(colored_list, slab_start);
+
+                // Colored faces are not recorded, so only empty slabs can skip a rebuild
+                if (!colored_sizes[slab])
+                    colored_records.patchable |= 1 << slab;
+            }
+        }
+
+        // Faces merged by greedy meshing go to the tiled pass, which is built along with the solid pass
+        bool greedy = !transparent && section.chunk->world->greedy_meshing && terrain_tile_size;
+        gertex::DisplayList<gertex::Vertex16> &tiled_list = scratch.tiled;
+        LightRecords &tiled_records = context.tiled_records;
+        uint16_t tiled_sizes[SECTION_SLAB_COUNT];
+        if (!transparent)
+        {
+            reset_list(tiled_list);
+            reset_light_records(tiled_records);
+        }
 
-        // Apply the buffer to the VBO
-        Lock lock(render_mutex);
-        section_vbo.buffer = displist_buf;
-        section_vbo.length = displist_size;
+        gertex::DisplayList<gertex::Vertex16> &list = scratch.blocks;
+        reset_list(list);
+        reset_light_records(records);
+        for (int slab = 0; slab < SECTION_SLAB_COUNT; slab++)
+        {
+            size_t slab_start = list.size();
+            size_t tiled_start = tiled_list.size();
+            if (slabs & (1 << slab))
+            {
+                int min_y = slab * SECTION_SLAB_HEIGHT;
+
+                // Render the block mesh
+                size_t quad_start = list.size();
+                uint16_t quad_vertices = render_section_blocks(context, &list, section, transparent, greedy, list.max_vertices, min_y, min_y + SECTION_SLAB_HEIGHT);
+                end_primitive(list, quad_start, quad_vertices);
+
+                if (greedy)
+                {
+                    uint16_t tiled_vertices = render_section_greedy(context, &tiled_list, section, tiled_list.max_vertices, min_y, min_y + SECTION_SLAB_HEIGHT);
+                    end_primitive(tiled_list, tiled_start, tiled_vertices);
+                    vertex_count += tiled_vertices;
+
+                    // Every face of the tiled pass is recorded
+                    tiled_records.faces.insert(tiled_records.faces.end(), context.tiled_face_records.begin(), context.tiled_face_records.end());
+                    tiled_records.counts[slab] = uint16_t(context.tiled_face_records.size());
+                }
+                if (!transparent)
+                    tiled_records.patchable |= 1 << slab;
+
+                // Render the fluid mesh
+                size_t tri_start = list.size();
+                uint16_t tri_vertices = render_section_fluids(context, &list, section, transparent, list.max_vertices, min_y, min_y + SECTION_SLAB_HEIGHT);
+                end_primitive(list, tri_start, tri_vertices);
+
+                vertex_count += quad_vertices + tri_vertices;
+
+                // The light can only be patched if every vertex of the slab belongs to a recorded face
+                if (!tri_vertices && quad_vertices == context.face_records.size() * 4)
+                {
+                    records.faces.insert(records.faces.end(), context.face_records.begin(), context.face_records.end());
+                    records.counts[slab] = uint16_t(context.face_records.size());
+                    records.patchable |= 1 << slab;
+                }
+            }
+            else
+            {
+                copy_slab(list, pass, slab);
+                keep_light_faces(records, pass, slab);
+                if (!transparent)
+                {
+                    copy_slab(tiled_list, section.tiled, slab);
+                    keep_light_faces(tiled_records, section.tiled, slab);
+                }
+            }
+            slab_sizes[slab] = end_slab(list, slab_start);
+
+            if (!transparent)
+                tiled_sizes[slab] = end_slab(tiled_list, tiled_start);
+        }
+
+        // An empty list leaves the pass without a buffer
+        if (transparent)
+            publish_pass(colored_list, section.colored, colored_sizes, colored_records);
+        publish_pass(list, pass, slab_sizes, records);
+        if (!transparent)
+            publish_pass(tiled_list, section.tiled, tiled_sizes, tiled_records);
+        return vertex_count;
+    }
+
+    static uint32_t mesh_section(MeshContext &context, Section &section, bool transparent, BufferPass &pass)
+    {
+        MeshScratch &scratch = context.scratch;
+        while (true)
+        {
+            try
+            {
+                return build_section_mesh(context, section, transparent, pass);
+            }
+            catch (std::overflow_error &)
+            {
+                // Nothing is published before every list is complete, so the mesh can
+                // start over once the list that ran out of space has grown
+                bool grown = false;
+                for (gertex::DisplayList<gertex::Vertex16> *list : {&scratch.colored, &scratch.blocks, &scratch.tiled})
+                {
+                    if (list->buffer && list->size() + list->attrib_size > list->capacity())
+                        grown |= grow_list(*list, list->size() + list->attrib_size);
+                }
+                if (!grown)
+                    throw;
+            }
+        }
+    }
+
+    // Returns whether every block under a merged face of the tiled pass still gets the given flat light.
+    static bool merged_face_is_even(MeshContext &context, uint16_t key, uint16_t size, const Vec3i &section_offset, uint8_t light)
+    {
+        uint8_t face = key >> 12;
+        const uint8_t *axes = greedy_face_axes[face];
+        const int origin[3] = {key & 0xF, (key >> 8) & 0xF, (key >> 4) & 0xF};
+        int width = (size & 0xF) + 1;
+        int height = ((size >> 4) & 0xF) + 1;
+        for (int v = 0; v < height; v++)
+        {
+            for (int u = 0; u < width; u++)
+            {
+                int local[3] = {origin[0], origin[1], origin[2]};
+                local[axes[0]] += u;
+                local[axes[1]] += v;
+                uint8_t lighting[4];
+                uint8_t ao[4];
+                get_face(&context.snapshot, section_offset + Vec3i(local[0], local[1], local[2]), face, 0, context.snapshot.local(local[0], local[1], local[2]), 0, 16, nullptr, lighting, ao);
+                for (int i = 0; i < 4; i++)
+                {
+                    if (lighting[i] != light)
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Writes the current light of the recorded faces in the given slabs into a copy of the
+    // buffer of the pass and makes the copy its new uncached buffer. Returns false if the
+    // copy could not be allocated, or if a merged face of the tiled pass is no longer lit
+    // evenly and has to be split by a rebuild.
+    static bool patch_pass(MeshContext &context, BufferPass &pass, bool tiled, uint8_t slabs, const Vec3i &section_offset)
+    {
+        if (!pass.uncached.buffer)
+            return true;
+        std::vector<uint8_t> &light = context.patch_light;
+        light.clear();
+
+        // Work out the new light first so that the buffer is written in one go
+        size_t stride = tiled ? 2 : 1;
+        size_t first = 0;
+        for (int slab = 0; slab < SECTION_SLAB_COUNT; slab++)
+        {
+            uint16_t count = pass.light_face_counts[slab];
+            if (slabs & (1 << slab))
+            {
+                for (size_t i = first; i < first + count; i += stride)
+                {
+                    uint16_t key = pass.light_faces[i];
+                    int x = key & 0xF;
+                    int z = (key >> 4) & 0xF;
+                    int y = (key >> 8) & 0xF;
+                    uint8_t face = key >> 12;
+                    uint8_t lighting[4];
+                    uint8_t ao[4];
+                    get_face(&context.snapshot, section_offset + Vec3i(x, y, z), face, 0, context.snapshot.local(x, y, z), 0, 16, nullptr, lighting, ao);
+                    if (tiled && pass.light_faces[i + 1] && !merged_face_is_even(context, key, pass.light_faces[i + 1], section_offset, lighting[0]))
+                        return false;
+
+                    // Same corner order as put_face
+                    uint8_t index = (ao[0] + ao[3] > ao[1] + ao[2]);
+                    for (int j = 0; j < 4; j++)
+                        light.push_back(lighting[(index + j) & 3]);
+                }
+            }
+            first += count;
+        }
+
+        // The current buffer may be drawn this frame, so the patch goes into a copy
+        uint8_t *buffer = vbo_alloc(pass.uncached.length);
+        if (!buffer)
+            return false;
+        std::memcpy(buffer, pass.uncached.buffer, pass.uncached.length);
+
+        const uint8_t *src = light.data();
+        size_t offset = 0;
+        for (int slab = 0; slab < SECTION_SLAB_COUNT; slab++)
+        {
+            size_t length = size_t(pass.slab_sizes[slab]) << 5;
+            uint32_t vertices = uint32_t(pass.light_face_counts[slab] / stride) * 4;
+            if ((slabs & (1 << slab)) && vertices)
+            {
+                // The recorded faces are the only vertices of the slab, right after the primitive header
+                uint8_t *dst = buffer + offset + 3 + VERTEX_ATTR_OFFSET_TERRAIN_LIGHT;
+                for (uint32_t i = 0; i < vertices; i++, dst += VERTEX_ATTR_LENGTH_TERRAIN)
+                    *dst = *src++;
+            }
+            offset += length;
+        }
+        DCFlushRange(buffer, pass.uncached.length);
+
+        // The renderer retires the old buffer when it takes the new one
+        pass.uncached.buffer = buffer;
+        return true;
+    }
+
+    bool patch_section_light(Section &section, uint8_t slabs)
+    {
+        if ((section.solid.patchable_slabs & section.transparent.patchable_slabs & section.colored.patchable_slabs & section.tiled.patchable_slabs & slabs) != slabs)
+            return false;
+
+        MeshContext &context = mesh_contexts[0];
+        Vec3i section_offset(section.x, section.y, section.z);
+        {
+            // The main thread unloads chunks while holding this lock, see mesh_worker_thread
+            Lock lock(section.chunk->world->chunk_mutex);
+            context.snapshot.build(section.chunk->world, section_offset);
+        }
+
+        // The chunk of the section was unloaded meanwhile, so there is nothing to patch
+        if (!context.snapshot.section_present())
+            return true;
+
+        bool patched = patch_pass(context, section.solid, false, slabs, section_offset) &&
+                       patch_pass(context, section.transparent, false, slabs, section_offset) &&
+                       patch_pass(context, section.tiled, true, slabs, section_offset);
+
+        // Hand the patched buffers over like a rebuild, a pass that failed is rebuilt instead
+        section.mesh_ready = true;
+        return patched;
+    }
+
+    static bool can_merge_faces(BlockState *block)
+    {
+        BlockProperties &props = properties(block->id);
+        return block->id && props.m_render_type == RenderType::full && !props.m_transparent && !props.m_fluid && !block_mesh_table[block->id].colored;
+    }
+
+    // Stretches a face at (u, v) of its plane over width by height blocks and gives it the texture
+    // coordinates of the tiled pass (see BASE3D_TILED_VTXFMT), so that its tile repeats once per block.
+    static void stretch_tiled_face(gertex::Vertex16 *vertices, const uint8_t *axes, int u, int v, int width, int height, uint32_t texture_index)
+    {
+        const int origin[2] = {u << BASE3D_POS_FRAC_BITS, v << BASE3D_POS_FRAC_BITS};
+        const int size[2] = {width, height};
+        const vfloat_t tile[2] = {TEXTURE_X(texture_index), TEXTURE_Y(texture_index)};
+
+        // Which corner of the plane and of the tile each vertex is at
+        int corner[4][2];
+        int texel[4][2];
+        int base = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            const int coords[3] = {vertices[i].x, vertices[i].y, vertices[i].z};
+            const vfloat_t uv[2] = {vertices[i].u, vertices[i].v};
+            for (int j = 0; j < 2; j++)
+            {
+                corner[i][j] = coords[axes[j]] > origin[j];
+                texel[i][j] = int(std::lround((uv[j] - tile[j]) / BASE3D_BLOCK_UV_SCALE));
+            }
+            if (!corner[i][0] && !corner[i][1])
+                base = i;
+        }
+
+        // How the texture coordinates change along each axis of the plane, this keeps rotated and flipped tiles intact
+        int step[2][2] = {};
+        for (int i = 0; i < 4; i++)
+        {
+            if (corner[i][0] + corner[i][1] != 1)
+                continue;
+            int axis = corner[i][1];
+            for (int j = 0; j < 2; j++)
+                step[axis][j] = texel[i][j] - texel[base][j];
+        }
+
+        int repeat[4][2];
+        int min_repeat[2] = {0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            int coords[3] = {vertices[i].x, vertices[i].y, vertices[i].z};
+            for (int axis = 0; axis < 2; axis++)
+                if (corner[i][axis])
+                    coords[axes[axis]] += (size[axis] - 1) << BASE3D_POS_FRAC_BITS;
+            vertices[i].x = int16_t(coords[0]);
+            vertices[i].y = int16_t(coords[1]);
+            vertices[i].z = int16_t(coords[2]);
+
+            for (int j = 0; j < 2; j++)
+            {
+                repeat[i][j] = texel[base][j] + step[0][j] * corner[i][0] * size[0] + step[1][j] * corner[i][1] * size[1];
+                min_repeat[j] = i ? std::min(min_repeat[j], repeat[i][j]) : repeat[i][j];
+            }
+        }
+
+        // The whole part selects the tile and the fraction runs over the repeats in 1/16 steps
+        for (int i = 0; i < 4; i++)
+        {
+            vertices[i].u = vfloat_t(texture_index & 15) + (repeat[i][0] - min_repeat[0]) * BASE3D_BLOCK_UV_SCALE;
+            vertices[i].v = vfloat_t((texture_index >> 4) & 15) + (repeat[i][1] - min_repeat[1]) * BASE3D_BLOCK_UV_SCALE;
+        }
+    }
+
+    static uint16_t render_section_greedy(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, uint16_t max_vertex_count, int min_y, int max_y)
+    {
+        list->max_vertices = max_vertex_count;
+        list->begin(GX_QUADS);
+
+        SectionSnapshot &snapshot = context.snapshot;
+        GreedyFace (&mask)[16][16] = context.greedy_mask;
+
+        uint16_t vertex_count = 0;
+        Vec3i section_offset = Vec3i(section.x, section.y, section.z);
+        context.tiled_face_records.clear();
+
+        for (uint8_t face = 0; face < 6; face++)
+        {
+            const uint8_t *axes = greedy_face_axes[face];
+            for (int slice = 0; slice < 16; slice++)
+            {
+                // Collect the visible faces of this slice
+                for (int v = 0; v < 16; v++)
+                {
+                    for (int u = 0; u < 16; u++)
+                    {
+                        GreedyFace &entry = mask[v][u];
+                        entry.valid = false;
+
+                        int local[3];
+                        local[axes[0]] = u;
+                        local[axes[1]] = v;
+                        local[axes[2]] = slice;
+                        if (local[1] < min_y || local[1] >= max_y)
+                            continue;
+                        BlockState *block = snapshot.local(local[0], local[1], local[2]);
+                        if (!can_merge_faces(block))
+                            continue;
+
+                        Vec3i blockpos = Vec3i(local[0], local[1], local[2]) + section_offset;
+                        if (!block_list[block->id]->should_render_side(&snapshot, blockpos, face))
+                            continue;
+
+                        uint32_t texture_index = get_texture_index(&snapshot, blockpos, face, block);
+                        uint8_t lighting[4];
+                        uint8_t ao[4];
+                        get_face(&snapshot, blockpos, face, texture_index, block, 0, 16, entry.vertices, lighting, ao);
+
+                        // Only faces with flat lighting can be stretched, the rest go in as they are
+                        bool uniform = true;
+                        for (int i = 1; i < 4 && uniform; i++)
+                            uniform = lighting[i] == lighting[0] && ao[i] == ao[0];
+                        if (!uniform)
+                        {
+                            stretch_tiled_face(entry.vertices, axes, u, v, 1, 1, texture_index);
+                            vertex_count += put_face(list, face, texture_index, entry.vertices, lighting, ao);
+                            context.tiled_face_records.push_back(uint16_t(local[0] | (local[2] << 4) | (local[1] << 8) | (face << 12)));
+                            context.tiled_face_records.push_back(0);
+                            continue;
+                        }
+
+                        entry.valid = true;
+                        entry.texture_index = texture_index;
+                        entry.lighting = lighting[0];
+                        entry.ao = ao[0];
+                    }
+                }
+
+                // Merge the collected faces into rectangles
+                for (int v = 0; v < 16; v++)
+                {
+                    for (int u = 0; u < 16;)
+                    {
+                        GreedyFace &first = mask[v][u];
+                        if (!first.valid)
+                        {
+                            u++;
+                            continue;
+                        }
+
+                        auto matches = [&first](const GreedyFace &other)
+                        {
+                            return other.valid && other.texture_index == first.texture_index && other.lighting == first.lighting && other.ao == first.ao;
+                        };
+
+                        int width = 1;
+                        while (u + width < 16 && matches(mask[v][u + width]))
+                            width++;
+
+                        int height = 1;
+                        for (; v + height < 16; height++)
+                        {
+                            bool row_matches = true;
+                            for (int i = 0; i < width && row_matches; i++)
+                                row_matches = matches(mask[v + height][u + i]);
+                            if (!row_matches)
+                                break;
+                        }
+
+                        gertex::Vertex16 vertices[4];
+                        for (int i = 0; i < 4; i++)
+                            vertices[i] = first.vertices[i];
+                        stretch_tiled_face(vertices, axes, u, v, width, height, first.texture_index);
+                        uint8_t lighting[4] = {first.lighting, first.lighting, first.lighting, first.lighting};
+                        uint8_t ao[4] = {first.ao, first.ao, first.ao, first.ao};
+                        vertex_count += put_face(list, face, first.texture_index, vertices, lighting, ao);
+                        context.saved_vertices += (width * height - 1) * 4;
+
+                        int local[3];
+                        local[axes[0]] = u;
+                        local[axes[1]] = v;
+                        local[axes[2]] = slice;
+                        context.tiled_face_records.push_back(uint16_t(local[0] | (local[2] << 4) | (local[1] << 8) | (face << 12)));
+                        context.tiled_face_records.push_back(uint16_t((width - 1) | ((height - 1) << 4)));
+
+                        for (int j = 0; j < height; j++)
+                            for (int i = 0; i < width; i++)
+                                mask[v + j][u + i].valid = false;
+                        u += width;
+                    }
+                }
+            }
+        }
+        return vertex_count;
     }
 
-    uint16_t render_section_blocks(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count)
+    static uint16_t render_section_blocks(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, bool greedy, uint16_t max_vertex_count, int min_y, int max_y)
     {
         list->max_vertices = max_vertex_count;
         list->begin(GX_QUADS);
 
         uint16_t vertex_count = 0;
+        SectionSnapshot &snapshot = context.snapshot;
+        context.face_records.clear();
 
         // Build the mesh from the blockstates
         Vec3i section_offset = Vec3i(section.x, section.y, section.z);
-        BlockState *block = &section.chunk->blockstates[section.y << 8];
-        for (int _y = 0; _y < 16; _y++)
+        for (int _y = min_y; _y < max_y; _y++)
         {
             for (int _z = 0; _z < 16; _z++)
             {
-                for (int _x = 0; _x < 16; _x++, block++)
+                for (int _x = 0; _x < 16; _x++)
                 {
+                    BlockState *block = snapshot.local(_x, _y, _z);
+                    if (!block->id)
+                        continue;
+                    const BlockMeshInfo &info = block_mesh_table[block->id];
+                    if (info.colored || transparent != properties(block->id).m_transparent)
+                        continue;
+                    if (greedy && can_merge_faces(block))
+                        continue;
                     Vec3i blockpos = Vec3i(_x, _y, _z) + section_offset;
-                    BlockProperties &props = properties(block->id);
-                    if (transparent == props.m_transparent && !block_list[block->id]->colored())
-                        vertex_count += block_list[block->id]->render(list, block, blockpos);
+                    if (info.full_cube)
+                    {
+                        // Most blocks are plain cubes. Their faces are recorded so that their light can be patched later.
+                        uint8_t faces = 0;
+                        vertex_count += render_cube_faces(list, &snapshot, block, blockpos, false, &faces);
+                        for (uint8_t face = 0; face < 6; face++)
+                        {
+                            if (faces & (1 << face))
+                                context.face_records.push_back(uint16_t(_x | (_z << 4) | (_y << 8) | (face << 12)));
+                        }
+                        continue;
+                    }
+                    vertex_count += info.render(list, &snapshot, block, blockpos);
                 }
             }
         }
         return vertex_count;
     }
 
-    uint16_t render_section_colored(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count)
+    static uint16_t render_section_colored(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, uint16_t max_vertex_count, int min_y, int max_y)
     {
         list->max_vertices = max_vertex_count;
         list->begin(GX_QUADS);
 
         uint16_t vertex_count = 0;
+        SectionSnapshot &snapshot = context.snapshot;
 
         // Build the mesh from the blockstates
         Vec3i section_offset = Vec3i(section.x, section.y, section.z);
-        BlockState *block = &section.chunk->blockstates[section.y << 8];
-        for (int _y = 0; _y < 16; _y++)
+        for (int _y = min_y; _y < max_y; _y++)
         {
             for (int _z = 0; _z < 16; _z++)
             {
-                for (int _x = 0; _x < 16; _x++, block++)
+                for (int _x = 0; _x < 16; _x++)
                 {
-                    Vec3i blockpos = Vec3i(_x, _y, _z) + section_offset;
-                    if (block_list[block->id]->colored())
-                        vertex_count += block_list[block->id]->render(list, block, blockpos);
+                    BlockState *block = snapshot.local(_x, _y, _z);
+                    const BlockMeshInfo &info = block_mesh_table[block->id];
+                    if (info.colored)
+                        vertex_count += info.render(list, &snapshot, block, Vec3i(_x, _y, _z) + section_offset);
                 }
             }
         }
         return vertex_count;
     }
 
-    uint16_t render_section_fluids(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count)
+    static uint16_t render_section_fluids(MeshContext &context, gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count, int min_y, int max_y)
     {
         list->max_vertices = max_vertex_count;
         list->begin(GX_TRIANGLES);
 
         uint16_t vertex_count = 0;
+        SectionSnapshot &snapshot = context.snapshot;
 
         // Build the mesh from the blockstates
         Vec3i chunk_offset = Vec3i(section.x, section.y, section.z);
-        BlockState *block = &section.chunk->blockstates[section.y << 8];
-        for (int _y = 0; _y < 16; _y++)
+        for (int _y = min_y; _y < max_y; _y++)
         {
             for (int _z = 0; _z < 16; _z++)
             {
-                for (int _x = 0; _x < 16; _x++, block++)
+                for (int _x = 0; _x < 16; _x++)
                 {
+                    BlockState *block = snapshot.local(_x, _y, _z);
                     Vec3i blockpos = Vec3i(_x, _y, _z) + chunk_offset;
                     if (properties(block->id).m_fluid && transparent == properties(block->id).m_transparent)
-                        vertex_count += render_fluid(list, block, blockpos, section.chunk->world);
+                    {
+                        if (!context.fluid_grid_ready)
+                        {
+                            context.fluid_grid.build(snapshot);
+                            context.fluid_grid_ready = true;
+                        }
+                        vertex_count += render_fluid(list, block, blockpos, context.fluid_grid);
+                    }
                 }
             }
         }
@@ -1,12 +1,20 @@
 #ifndef RENDER_CHUNKS_HPP
 #define RENDER_CHUNKS_HPP
 
+#include <cstdint>
 #include <render/base3d.hpp>
 #include <gertex/displaylist.hpp>
 #include <render/buffer.hpp>
+#include <render/buffer_pass.hpp>
 
 class Section;
 
+// Upper limit of mesh worker threads, see SectionSnapshot for the thread limit
+#define MAX_MESH_WORKERS 3
+
+// Upper limit of sections waiting for a mesh worker
+#define MAX_MESH_JOBS 32
+
 enum class RenderPass
 {
     SOLID,
@@ -15,10 +23,41 @@ enum class RenderPass
 
 namespace ChunkRenderer
 {
-    void render_section(Section &section, bool transparent, VBO &section_vbo);
-    uint16_t render_section_fluids(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count);
-    uint16_t render_section_blocks(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count);
-    uint16_t render_section_colored(gertex::DisplayList<gertex::Vertex16> *list, Section &section, bool transparent, uint16_t max_vertex_count);
+    struct MeshStats
+    {
+        uint32_t sections = 0;
+        uint32_t last_us = 0;
+        uint32_t average_us = 0;
+        uint32_t last_vertices = 0;
+        uint32_t average_vertices = 0;
+        uint32_t last_saved_vertices = 0; // Vertices removed by greedy meshing
+        uint32_t average_saved_vertices = 0;
+    };
+
+    // Section meshing statistics, tracked separately for smooth and flat lighting.
+    MeshStats &get_mesh_stats(bool smooth_lighting);
+
+    // Returns the size of the scratch display lists used by the mesher.
+    size_t get_scratch_size();
+
+    // Meshes a pass of the section on the calling thread. Only the slabs in
+    // Section::mesh_slabs are rebuilt, the rest are kept from the previous mesh.
+    void render_section(Section &section, bool transparent, BufferPass &pass);
+
+    // Starts worker threads that mesh queued sections. Stops any running workers first.
+    void start_mesh_workers(int count);
+    void stop_mesh_workers();
+    int get_mesh_workers();
+
+    // Queues both passes of the section for meshing on a worker. The section stays
+    // mesh_pending until its buffers are published. Returns false if the queue is full.
+    bool queue_section(Section &section);
+
+    // Rewrites the light of the given slabs in copies of the buffers of the section without
+    // rebuilding them, then hands the copies to the renderer through Section::mesh_ready.
+    // Must be called from the chunk manager thread while the section is not being meshed
+    // and mesh_ready is clear. Returns false if a slab has to be rebuilt instead.
+    bool patch_section_light(Section &section, uint8_t slabs);
 };
 
 #endif
\ No newline at end of file
@@ -1,10 +1,10 @@
 #include "render_fluids.hpp"
 
-#include <world/world.hpp>
 #include <world/chunk.hpp>
 #include <block/blocks.hpp>
 #include <render/render.hpp>
 #include <gertex/displaylist.hpp>
+#include <cstring>
 
 inline static int DrawHorizontalQuad(gertex::DisplayList<gertex::Vertex16> *list, gertex::Vertex16 *vertices, uint8_t light)
 {
@@ -70,50 +70,97 @@ inline static int DrawVerticalQuad(gertex::DisplayList<gertex::Vertex16> *list,
     return faceCount;
 }
 
-int get_capped_fluid_level_at(World *world, Vec3i pos, BlockID src_id)
+void FluidGrid::build(SectionSnapshot &snapshot)
 {
-    BlockState *block = world->get_block_at(pos);
-    if (block && is_same_fluid(block->blockid, src_id))
+    this->snapshot = &snapshot;
+    for (int i = 0; i < SECTION_SNAPSHOT_VOLUME; i++)
     {
-        if (block->meta >= 8)
-            return 0;
-        return block->meta & 0xF;
+        BlockState *block = snapshot.get(i);
+        BlockID id = block ? block->blockid : BlockID::air;
+        fluids[i] = is_fluid(id) ? basefluid(id) : BlockID::air;
+        levels[i] = block ? (block->meta & 0xF) : 0;
+        solid[i] = is_solid(id);
     }
-    return -1;
+    std::memset(corner_levels, 0xFF, sizeof(corner_levels));
 }
 
-Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos)
+uint8_t FluidGrid::corner_level(int x, int y, int z, BlockID fluid)
 {
+    int corner = x + (z + y * 17) * 17;
+    if (corner_levels[corner] != 0xFF && corner_fluids[corner] == fluid)
+        return corner_levels[corner];
+
+    // Same as get_fluid_height, reading the four blocks that share the corner from the grid
+    int surrounding_water = 0;
+    float water_percentage = 0.0F;
+    float height = -1.0F;
+    for (int i = 0; i < 4; ++i)
+    {
+        int check_x = x - (i & 1);
+        int check_z = z - (i >> 1 & 1);
+        if (fluids[index(check_x, y + 1, check_z)] == fluid)
+        {
+            height = 1.0F;
+            break;
+        }
+
+        int check = index(check_x, y, check_z);
+        if (fluids[check] != fluid)
+        {
+            if (!solid[check])
+            {
+                ++water_percentage;
+                ++surrounding_water;
+            }
+        }
+        else
+        {
+            int fluid_level = levels[check];
+            if (fluid_level >= 8 || fluid_level == 0)
+            {
+                water_percentage += get_percent_air(fluid_level) * 10.0F;
+                surrounding_water += 10;
+            }
+
+            water_percentage += get_percent_air(fluid_level);
+            ++surrounding_water;
+        }
+    }
+    if (height < 0)
+        height = 1.0F - water_percentage / (float)surrounding_water;
 
-    uint8_t fluid_level = get_capped_fluid_level_at(world, pos, block->blockid);
+    corner_levels[corner] = FLOAT_TO_FLUIDMETA(height);
+    corner_fluids[corner] = fluid;
+    return corner_levels[corner];
+}
+
+Vec3f FluidGrid::direction(BlockState *block, int x, int y, int z, int world_y)
+{
+    // Same as get_fluid_direction, reading the neighbours from the grid
+    int center = index(x, y, z);
+    int fluid_level = capped_level(center);
     if ((fluid_level & 7) == 0)
         return Vec3f(0.0, -1.0, 0.0);
 
-    // Used to check block types around the fluid
-    BlockState *neighbors[6];
-    world->get_neighbors(pos, neighbors);
-
     Vec3f direction = Vec3f(0.0, 0.0, 0.0);
-
     for (int i = 0; i < 6; i++)
     {
         if (i == FACE_NY || i == FACE_PY)
             continue;
-        if (neighbors[i])
+        const Vec3i &offset = face_offsets[i];
+        int neighbor = index(x + offset.x, y, z + offset.z);
+        if (!snapshot->present[neighbor])
+            continue;
+        int fl = capped_level(neighbor);
+        if (fl >= 0)
+        {
+            direction = direction + Vec3f(offset.x, 0, offset.z) * (fl - fluid_level);
+        }
+        else if (world_y > 0 && !solid[neighbor])
         {
-            int fl = get_capped_fluid_level_at(world, pos + face_offsets[i], neighbors[i]->blockid);
+            fl = capped_level(index(x + offset.x, y - 1, z + offset.z));
             if (fl >= 0)
-            {
-                direction = direction + Vec3f(face_offsets[i].x, 0, face_offsets[i].z) * (fl - fluid_level);
-            }
-            else if (fl < 0 && pos.y > 0 && !is_solid(neighbors[i]->blockid))
-            {
-                fl = get_capped_fluid_level_at(world, pos + face_offsets[i] + Vec3i(0, -1, 0), neighbors[i][-256].blockid);
-                if (fl >= 0)
-                {
-                    direction = direction + Vec3f(face_offsets[i].x, 0, face_offsets[i].z) * (fl - fluid_level + 8);
-                }
-            }
+                direction = direction + Vec3f(offset.x, 0, offset.z) * (fl - fluid_level + 8);
         }
     }
 
@@ -123,7 +170,10 @@ Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos)
         {
             if (i == FACE_NY || i == FACE_PY)
                 continue;
-            if (neighbors[i] && ((neighbors[i][0].visibility_flags & (1 << (i ^ 1))) || (pos.y < MAX_WORLD_Y && (neighbors[i][256].visibility_flags & (1 << (i ^ 1))))))
+            const Vec3i &offset = face_offsets[i];
+            BlockState *side = snapshot->local(x + offset.x, y, z + offset.z);
+            BlockState *above = world_y < MAX_WORLD_Y ? snapshot->local(x + offset.x, y + 1, z + offset.z) : nullptr;
+            if (side && ((side->visibility_flags & (1 << (i ^ 1))) || (above && (above->visibility_flags & (1 << (i ^ 1))))))
             {
                 direction.y -= 6.0;
                 break;
@@ -133,7 +183,7 @@ Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos)
     return direction.fast_normalize();
 }
 
-int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos, World *world)
+int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos, FluidGrid &grid)
 {
     BlockID block_id = block->blockid;
 
@@ -152,10 +202,9 @@ int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
     float corner_bottoms[4];
     float corner_tops[4];
 
-    if (world)
-        world->get_neighbors(pos, neighbors);
     for (int x = 0; x < 6; x++)
     {
+        neighbors[x] = grid.snapshot->local(local_pos.x + face_offsets[x].x, local_pos.y + face_offsets[x].y, local_pos.z + face_offsets[x].z);
         neighbor_ids[x] = neighbors[x] ? neighbors[x]->blockid : BlockID::air;
     }
 
@@ -165,9 +214,11 @@ int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
         {1, 0, 1},
         {1, 0, 0},
     };
+    BlockID fluid = basefluid(block_id);
     for (int i = 0; i < 4; i++)
     {
-        corner_max[i] = (get_fluid_visual_level(world, pos + corner_offsets[i], block_id) << 1);
+        const Vec3i &corner = corner_offsets[i];
+        corner_max[i] = (grid.corner_level(local_pos.x + corner.x, local_pos.y, local_pos.z + corner.z, fluid) << 1);
         if (!corner_max[i])
             corner_max[i] = 1;
         corner_min[i] = 0;
@@ -208,7 +259,7 @@ int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block,
     if (!is_same_fluid(block_id, neighbor_ids[FACE_NY]) && (!is_solid(neighbor_ids[FACE_NY]) || properties(neighbor_ids[FACE_NY]).m_transparent))
         faceCount += DrawHorizontalQuad(list, bottomPlaneCoords, neighbors[FACE_NY] ? neighbors[FACE_NY]->light : light);
 
-    Vec3f direction = get_fluid_direction(world, block, pos);
+    Vec3f direction = grid.direction(block, local_pos.x, local_pos.y, local_pos.z, pos.y);
     float angle = -1000;
     float cos_angle = 8 * BASE3D_PIXEL_UV_SCALE;
     float sin_angle = 0;
@@ -3,12 +3,58 @@
 
 #include <cstdint>
 #include <math/vec3i.hpp>
+#include <math/vec3f.hpp>
+#include <block/block_id.hpp>
 #include <gertex/displaylist.hpp>
+#include <render/section_snapshot.hpp>
 
 class BlockState;
-class World;
 struct DisplayList;
 
-Vec3f get_fluid_direction(World *world, BlockState *block, Vec3i pos);
-int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos, World *world);
+#define FLUID_CORNER_COUNT (17 * 17 * 16)
+
+/**
+ * The fluids of a section and the blocks around it, taken from the section
+ * snapshot before the fluids are meshed so that the neighbour levels are not
+ * looked up again for every block. Coordinates are section-local from -1 to 16,
+ * the same as SectionSnapshot::local.
+ */
+struct FluidGrid
+{
+    SectionSnapshot *snapshot = nullptr;
+
+    // Base fluid of each block or air if it is not a fluid
+    BlockID fluids[SECTION_SNAPSHOT_VOLUME];
+
+    // Fluid level of each block, where 0 is a source and 8 or above is falling
+    uint8_t levels[SECTION_SNAPSHOT_VOLUME];
+    bool solid[SECTION_SNAPSHOT_VOLUME];
+
+    // Visual level at the minimum corner of each block in the section, filled in as needed
+    uint8_t corner_levels[FLUID_CORNER_COUNT];
+    BlockID corner_fluids[FLUID_CORNER_COUNT];
+
+    void build(SectionSnapshot &snapshot);
+
+    inline int index(int x, int y, int z) const
+    {
+        return (x + 1) + ((z + 1) + (y + 1) * SECTION_SNAPSHOT_SIZE) * SECTION_SNAPSHOT_SIZE;
+    }
+
+    // Returns the level of the fluid at the index with falling fluid counted as 0, or -1 if there is no fluid
+    inline int capped_level(int index) const
+    {
+        if (fluids[index] == BlockID::air)
+            return -1;
+        return levels[index] >= 8 ? 0 : levels[index];
+    }
+
+    // Returns the visual level (0 to 8) of the fluid at the corner with the minimum coordinates of the block.
+    uint8_t corner_level(int x, int y, int z, BlockID fluid);
+
+    // Returns the direction the fluid at the position flows in. The y is section-local.
+    Vec3f direction(BlockState *block, int x, int y, int z, int world_y);
+};
+
+int render_fluid(gertex::DisplayList<gertex::Vertex16> *list, BlockState *block, const Vec3i &pos, FluidGrid &grid);
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "section_snapshot.hpp"
+
+#include <world/world.hpp>
+#include <world/chunk_cache.hpp>
+
+void SectionSnapshot::build(World *world, const Vec3i &section_pos)
+{
+    origin = section_pos - Vec3i(1, 1, 1);
+    smooth_lighting = world->smooth_lighting;
+
+    ChunkCache chunk_cache = build_chunk_cache(world, section_pos.x >> 4, section_pos.z >> 4);
+    Chunk *chunk = nullptr;
+
+    int i = 0;
+    for (int y = 0; y < SECTION_SNAPSHOT_SIZE; y++)
+    {
+        for (int z = 0; z < SECTION_SNAPSHOT_SIZE; z++)
+        {
+            for (int x = 0; x < SECTION_SNAPSHOT_SIZE; x++, i++)
+            {
+                BlockState *block = get_block_cached(chunk_cache, origin.x + x, origin.y + y, origin.z + z, chunk);
+                present[i] = block != nullptr;
+                opaque[i] = block && properties(block->id).m_opacity == 15;
+                if (block)
+                    blocks[i] = *block;
+            }
+        }
+    }
+}
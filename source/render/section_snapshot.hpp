@@ -0,0 +1,87 @@
+#ifndef SECTION_SNAPSHOT_HPP
+#define SECTION_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <math/vec3i.hpp>
+#include <block/block_properties.hpp>
+#include <world/block_access.hpp>
+
+class World;
+
+#define SECTION_SNAPSHOT_SIZE 18
+#define SECTION_SNAPSHOT_VOLUME (SECTION_SNAPSHOT_SIZE * SECTION_SNAPSHOT_SIZE * SECTION_SNAPSHOT_SIZE)
+
+/**
+ * A padded 18x18x18 copy of the blocks (id, meta, light, visibility and
+ * opacity) around a section, taken when meshing starts. The extra layer on every
+ * side covers the neighbours that face culling, smooth lighting and fluid
+ * levels look at, so the mesher never has to read the live world. It is
+ * passed to the block code as its BlockAccess while meshing.
+ */
+struct SectionSnapshot : public BlockAccess
+{
+    Vec3i origin;
+    BlockState blocks[SECTION_SNAPSHOT_VOLUME];
+    bool present[SECTION_SNAPSHOT_VOLUME];
+
+    // Whether each block has full opacity, for smooth lighting and ambient occlusion
+    bool opaque[SECTION_SNAPSHOT_VOLUME];
+
+    // Copied from the world so the mesher does not have to look at it
+    bool smooth_lighting = false;
+
+    // Copies the section whose minimum corner is at section_pos and its neighbours.
+    void build(World *world, const Vec3i &section_pos);
+
+    // Returns the index of the position in the snapshot or -1 if outside.
+    inline int index(const Vec3i &pos) const
+    {
+        unsigned int x = pos.x - origin.x;
+        unsigned int y = pos.y - origin.y;
+        unsigned int z = pos.z - origin.z;
+        if (x >= SECTION_SNAPSHOT_SIZE || y >= SECTION_SNAPSHOT_SIZE || z >= SECTION_SNAPSHOT_SIZE)
+            return -1;
+        return x + (z + y * SECTION_SNAPSHOT_SIZE) * SECTION_SNAPSHOT_SIZE;
+    }
+
+    // Returns the copied block at the index or nullptr if it was not loaded.
+    inline BlockState *get(int index)
+    {
+        return present[index] ? &blocks[index] : nullptr;
+    }
+
+    // Returns whether the blocks of the section itself were copied. They are missing
+    // if its chunk was unloaded before the snapshot was taken.
+    inline bool section_present() const
+    {
+        return present[1 + (1 + SECTION_SNAPSHOT_SIZE) * SECTION_SNAPSHOT_SIZE];
+    }
+
+    // Returns the block at section-local coordinates (-1 to 16 inclusive).
+    inline BlockState *local(int x, int y, int z)
+    {
+        return get((x + 1) + ((z + 1) + (y + 1) * SECTION_SNAPSHOT_SIZE) * SECTION_SNAPSHOT_SIZE);
+    }
+
+    // Returns the copied block at the world position and whether it is opaque, or nullptr if it is outside the snapshot or was not loaded.
+    inline BlockState *get_block_at(const Vec3i &position, bool &is_opaque)
+    {
+        int i = index(position);
+        if (i < 0 || !present[i])
+            return nullptr;
+        is_opaque = opaque[i];
+        return &blocks[i];
+    }
+
+    // Returns the copied block at the world position, or nullptr if it is outside the snapshot or was not loaded.
+    BlockState *get_block_at(const Vec3i &position) override
+    {
+        int i = index(position);
+        return i >= 0 ? get(i) : nullptr;
+    }
+};
+
+// Upper limit of threads that can mesh sections at the same time, each with its own snapshot
+#define MAX_SNAPSHOT_THREADS 4
+
+#endif
@@ -14,9 +14,9 @@ void TexAnim::copy(void *src_ptr, uint32_t dst_x, uint32_t dst_y)
     {
         for (uint32_t x = dst_x; x < dst_x + tile_width; x += 4)
         {
-            void *dst_ptr = (void *)(u32(target) + (dst_width * 4 * y + x * 16));
+            void *dst_ptr = static_cast<uint8_t *>(target) + (dst_width * 4 * y + x * 16);
             memcpy(dst_ptr, src_ptr, 64);
-            src_ptr = (void *)(u32(src_ptr) + 64);
+            src_ptr = static_cast<uint8_t *>(src_ptr) + 64;
         }
     }
 }
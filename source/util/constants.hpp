@@ -7,6 +7,7 @@
 #define CHUNK_DISTANCE 5
 #define CHUNK_COUNT ((CHUNK_DISTANCE) * (CHUNK_DISTANCE + 1) * 4)
 #define FOG_DISTANCE (RENDER_DISTANCE - 16)
+#define ENTITY_RENDER_DISTANCE 64
 #define VERTICAL_SECTION_COUNT 8
 #define WORLD_HEIGHT (VERTICAL_SECTION_COUNT << 4)
 #define MAX_WORLD_Y (WORLD_HEIGHT - 1)
@@ -1,4 +1,5 @@
 #include "face_pair.hpp"
+#include <cstddef>
 // Store the 15 possible unordered face pairs
 static std::vector<std::pair<int, int>> face_pairs;
 
@@ -41,6 +41,7 @@ public:
 
     void wait(Mutex &m) { LWP_CondWait(c_, m.native()); }
     void signal() { LWP_CondSignal(c_); }
+    void broadcast() { LWP_CondBroadcast(c_); }
 
 private:
     cond_t c_;
@@ -0,0 +1,41 @@
+#ifndef BLOCK_ACCESS_HPP
+#define BLOCK_ACCESS_HPP
+
+#include <math/vec3i.hpp>
+#include <block/block_properties.hpp>
+
+extern const Vec3i face_offsets[];
+
+/**
+ * Read access to the blocks of a world. Implemented by the World itself and by
+ * the section snapshots, so that block code shared between the game logic and
+ * the mesher can be given either without knowing which one it reads from.
+ */
+class BlockAccess
+{
+public:
+    virtual ~BlockAccess() = default;
+
+    // Returns the block at the position or nullptr if it is not loaded.
+    virtual BlockState *get_block_at(const Vec3i &position) = 0;
+
+    BlockID get_block_id_at(const Vec3i &position, BlockID default_id = BlockID::air)
+    {
+        BlockState *block = get_block_at(position);
+        return block ? block->blockid : default_id;
+    }
+
+    uint8_t get_meta_at(const Vec3i &position)
+    {
+        BlockState *block = get_block_at(position);
+        return block ? block->meta : 0;
+    }
+
+    void get_neighbors(const Vec3i &pos, BlockState **neighbors)
+    {
+        for (int i = 0; i < 6; i++)
+            neighbors[i] = get_block_at(pos + face_offsets[i]);
+    }
+};
+
+#endif
@@ -142,23 +142,77 @@ void Chunk::recalculate_visibility(BlockState *block, const Vec3i &pos, ChunkCac
     block->visibility_flags = visibility;
 }
 
+// Returns true if the block hides the adjacent faces of opaque blocks
+inline static bool occludes(BlockState *block)
+{
+    if (!block || !visible(block->id))
+        return false;
+    BlockProperties &props = properties(block->id);
+    return !props.m_transparent && (props.m_render_type == RenderType::full || props.m_render_type == RenderType::full_special);
+}
+
+// Occluder rows of the section being refreshed and a one block border around it.
+// Bit x + 1 of section_occluders[y + 1][z + 1] is set if the block at (x, y, z) occludes.
+static uint32_t section_occluders[18][18];
+
 // recalculates the blockstates of a section
 void Chunk::refresh_section_block_visibility(int index)
 {
     ChunkCache cache = build_chunk_cache(world, x, z);
     Vec3i chunk_pos(this->x * 16, index * 16, this->z * 16);
 
+    // Build the occluder rows. Blocks inside the section are read directly,
+    // the border goes through the chunk cache.
+    Chunk *cached_chunk = nullptr;
+    for (int y = -1; y <= 16; y++)
+    {
+        for (int z = -1; z <= 16; z++)
+        {
+            uint32_t row = 0;
+            bool inside = y >= 0 && y < 16 && z >= 0 && z < 16;
+            for (int x = -1; x <= 16; x++)
+            {
+                BlockState *block;
+                if (inside && x >= 0 && x < 16)
+                    block = this->get_block(chunk_pos + Vec3i(x, y, z));
+                else
+                    block = get_block_cached(cache, chunk_pos.x + x, chunk_pos.y + y, chunk_pos.z + z, cached_chunk);
+                row |= uint32_t(occludes(block)) << (x + 1);
+            }
+            section_occluders[y + 1][z + 1] = row;
+        }
+    }
+
     BlockState *block = this->get_block(chunk_pos); // Gets the first block of the section
     for (int y = 0; y < 16; y++)
     {
         for (int z = 0; z < 16; z++)
         {
+            // The faces of opaque blocks are visible unless the neighbor occludes,
+            // so the visible faces of the whole row come from the neighboring rows.
+            uint32_t row = section_occluders[y + 1][z + 1];
+            uint32_t visible_faces[6] = {
+                ~(row << 1),                         // Negative X
+                ~(row >> 1),                         // Positive X
+                ~section_occluders[y][z + 1],        // Negative Y
+                ~section_occluders[y + 2][z + 1],    // Positive Y
+                ~section_occluders[y + 1][z],        // Negative Z
+                ~section_occluders[y + 1][z + 2]};   // Positive Z
+
             for (int x = 0; x < 16; x++, block++)
             {
                 if (!visible(block->id))
                     continue;
-                Vec3i pos = Vec3i(x, y, z);
-                this->recalculate_visibility(block, chunk_pos + pos, cache);
+                if (properties(block->id).m_transparent)
+                {
+                    // Transparent blocks depend on the neighbor type, use the slow path
+                    this->recalculate_visibility(block, chunk_pos + Vec3i(x, y, z), cache);
+                    continue;
+                }
+                uint8_t visibility = 0x40;
+                for (int i = 0; i < 6; i++)
+                    visibility |= ((visible_faces[i] >> (x + 1)) & 1) << i;
+                block->visibility_flags = visibility;
             }
         }
     }
@@ -418,9 +472,13 @@ void Chunk::tick_tile_entities()
     }
 }
 
-void Chunk::render_entities(float partial_ticks, bool transparency)
+void Chunk::collect_visible_entities(const Frustum *frustum, const Vec3f &camera_pos, std::vector<EntityPhysical *> &out)
 {
-    gertex::GXState state = gertex::get_state();
+    // Nothing in the chunk can be seen if none of its sections are visible
+    bool any_visible = false;
+    for (int i = 0; i < VERTICAL_SECTION_COUNT && !any_visible; i++)
+        any_visible = sections[i].visible;
+
     for (EntityPhysical *&entity : entities)
     {
         // Make sure the entity is valid
@@ -429,18 +487,33 @@ void Chunk::render_entities(float partial_ticks, bool transparency)
         // Skip rendering dead entities
         if (entity->dead)
             continue;
-        entity->render(partial_ticks, transparency);
 
-        // Restore the previous state after rendering the entity
-        gertex::set_state(state);
-    }
+        // Only draw the entity if one of the sections it touches is visible
+        if (!entity->visible_through_walls())
+        {
+            if (!any_visible)
+                continue;
+            int min_section = std::clamp(int(std::floor(entity->aabb.min.y)) >> 4, 0, VERTICAL_SECTION_COUNT - 1);
+            int max_section = std::clamp(int(std::floor(entity->aabb.max.y)) >> 4, 0, VERTICAL_SECTION_COUNT - 1);
+            bool visible = false;
+            for (int i = min_section; i <= max_section && !visible; i++)
+                visible = sections[i].visible;
+            if (!visible)
+                continue;
+        }
 
-    // Restore default texture
-    use_texture(terrain_texture);
+        Vec3f center = (entity->aabb.min + entity->aabb.max) * 0.5;
+        if ((center - camera_pos).sqr_magnitude() > ENTITY_RENDER_DISTANCE * ENTITY_RENDER_DISTANCE)
+            continue;
+
+        // Leave some room around the bounds for held items and swinging limbs
+        Vec3f extent = entity->aabb.max - entity->aabb.min;
+        float size = std::max(extent.x, std::max(extent.y, extent.z)) + 1.0f;
+        if (frustum && !is_cube_visible(*frustum, center, size))
+            continue;
 
-    // Restore default colors
-    gertex::set_color_mul(GXColor{255, 255, 255, 255});
-    gertex::set_color_add(GXColor{0, 0, 0, 255});
+        out.push_back(entity);
+    }
 }
 
 uint32_t Chunk::size()
@@ -794,13 +867,23 @@ void Chunk::read()
     // Mark chunk as dirty
     for (int vbo_index = 0; vbo_index < VERTICAL_SECTION_COUNT; vbo_index++)
     {
-        sections[vbo_index].dirty = true;
+        sections[vbo_index].mark_dirty();
+    }
+}
+
+bool Chunk::meshing()
+{
+    for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+    {
+        if (sections[i].mesh_pending)
+            return true;
     }
+    return false;
 }
 
 bool Section::stable()
 {
-    return this->solid.is_same() && this->transparent.is_same() && this->colored.is_same();
+    return this->solid.is_same() && this->transparent.is_same() && this->colored.is_same() && this->tiled.is_same();
 }
 
 void Section::refresh()
@@ -808,11 +891,12 @@ void Section::refresh()
     this->solid.refresh();
     this->transparent.refresh();
     this->colored.refresh();
+    this->tiled.refresh();
 }
 
 size_t Section::size()
 {
-    return sizeof(*this) + this->solid.size() + this->transparent.size() + this->colored.size();
+    return sizeof(*this) + this->solid.size() + this->transparent.size() + this->colored.size() + this->tiled.size();
 }
 
 void Section::clear()
@@ -820,4 +904,5 @@ void Section::clear()
     this->solid.clear();
     this->transparent.clear();
     this->colored.clear();
+    this->tiled.clear();
 }
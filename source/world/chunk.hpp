@@ -4,6 +4,7 @@
 #include <ogc/mutex.h>
 #include <ogc/gu.h>
 #include <cstddef>
+#include <atomic>
 #include <vector>
 #include <deque>
 #include <map>
@@ -69,6 +70,15 @@ class Section
 public:
     bool visible = false;
     bool dirty = false;
+
+    // Slabs that changed since the section was last meshed
+    uint8_t dirty_slabs = SECTION_ALL_SLABS;
+
+    // Slabs that are being rebuilt by the current mesh update
+    uint8_t mesh_slabs = 0;
+
+    // Slabs whose light changed but whose blocks did not
+    uint8_t light_slabs = 0;
     int32_t x = 0;
     uint8_t y = 0;
     int32_t z = 0;
@@ -76,8 +86,14 @@ public:
     BufferPass solid{};
     BufferPass transparent{};
     BufferPass colored{};
+
+    // Faces merged by greedy meshing, drawn with their tiles repeated
+    BufferPass tiled{};
     uint16_t visibility_flags = 0;
 
+    // Last visibility search that reached this section
+    uint32_t visibility_epoch = 0;
+
     bool has_solid_fluid = false;
     bool has_transparent_fluid = false;
 
@@ -85,14 +101,50 @@ public:
 
     bool has_updated = false;
 
+    // Set while a mesh worker has the section queued or is meshing it
+    volatile bool mesh_pending = false;
+
+    // Set by the section updates once all passes have new buffers and cleared by
+    // the renderer after taking them. The uncached buffers are not replaced while
+    // this is set, so neither side has to lock the other out.
+    std::atomic<bool> mesh_ready{false};
+
+    // Marks the given slabs for rebuilding, all of them by default
+    void mark_dirty(uint8_t slabs = SECTION_ALL_SLABS)
+    {
+        dirty_slabs |= slabs;
+        dirty = true;
+    }
+
+    // Marks the given slabs for relighting. If the section is not
+    // being rebuilt, the light is patched into the existing mesh.
+    void mark_light_dirty(uint8_t slabs)
+    {
+        light_slabs |= slabs;
+    }
+
     bool stable();
     void refresh();
     size_t size();
     void clear();
 };
 
+// Returns the slabs of the section starting at section_y that overlap the range from min_y to max_y
+inline uint8_t section_slabs_in_range(int section_y, int min_y, int max_y)
+{
+    uint8_t slabs = 0;
+    for (int i = 0; i < SECTION_SLAB_COUNT; i++)
+    {
+        int slab_min = section_y + i * SECTION_SLAB_HEIGHT;
+        if (slab_min <= max_y && slab_min + SECTION_SLAB_HEIGHT - 1 >= min_y)
+            slabs |= 1 << i;
+    }
+    return slabs;
+}
+
 class NBTTagCompound;
 class World;
+struct Frustum;
 class TileEntity;
 
 class Chunk
@@ -206,10 +258,15 @@ public:
     static void init_floodfill_startpoints();
     void vbo_visibility_flood_fill(Vec3i pos);
     void refresh_section_visibility(int index);
+
+    // Returns true if a mesh worker still has any section of this chunk
+    bool meshing();
     void update_entities();
     void tick_tile_entities();
 
-    void render_entities(float partial_ticks, bool transparency);
+    // Appends the entities that are within ENTITY_RENDER_DISTANCE of the camera,
+    // inside the frustum and in a section that the visibility search reached.
+    void collect_visible_entities(const Frustum *frustum, const Vec3f &camera_pos, std::vector<EntityPhysical *> &out);
 
     uint32_t size();
     Chunk(int32_t x, int32_t z, World *world) : x(x), z(z), world(world)
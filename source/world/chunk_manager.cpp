@@ -35,13 +35,29 @@ void ChunkManager::update_loop()
     {
         world->update_sections();
         Lock lock(world->chunk_mutex);
-        if (world->pending_chunks.empty() || !world->chunk_provider)
+        if (world->pending_chunks.empty())
         {
             lock.unlock();
             usleep(1000);
             continue;
         }
         Chunk *chunk = world->pending_chunks.back();
+        bool removing = chunk->state == ChunkState::saving || chunk->state == ChunkState::invalid;
+
+        // Unloading does not need the chunk provider, which a remote world may not have
+        if (!removing && !world->chunk_provider)
+        {
+            lock.unlock();
+            usleep(1000);
+            continue;
+        }
+        if (removing && chunk->meshing())
+        {
+            // Wait for the mesh workers to let go of the chunk before removing it
+            lock.unlock();
+            usleep(1000);
+            continue;
+        }
         switch (chunk->state)
         {
         case ChunkState::loading:
@@ -51,6 +67,7 @@ void ChunkManager::update_loop()
 
             // Move the chunk to the active list
             world->chunks.push_back(chunk);
+            world->visibility_generation++;
             world->pending_chunks.erase(std::find(world->pending_chunks.begin(), world->pending_chunks.end(), chunk));
             uint64_t key = uint32_pair(chunk->x, chunk->z);
             world->chunk_cache.insert_or_assign(key, chunk);
@@ -66,6 +83,7 @@ void ChunkManager::update_loop()
         {
             // Move the chunk to the active list
             world->chunks.push_back(chunk);
+            world->visibility_generation++;
             world->pending_chunks.erase(std::find(world->pending_chunks.begin(), world->pending_chunks.end(), chunk));
             uint64_t key = uint32_pair(chunk->x, chunk->z);
             world->chunk_cache.insert_or_assign(key, chunk);
@@ -88,7 +106,10 @@ void ChunkManager::update_loop()
         // Fall to removal case after saving
         case ChunkState::invalid:
         {
-            // Lock chunk_lock(world->chunk_mutex);
+            // No worker is meshing the sections anymore and this thread does not
+            // update them after unloading, so their buffers can be let go of here
+            for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+                chunk->sections[i].clear();
             world->pending_chunks.erase(std::find(world->pending_chunks.begin(), world->pending_chunks.end(), chunk));
             delete chunk;
             break;
@@ -102,7 +102,7 @@ void ChunkProviderOverworld::populate_chunk(Chunk *chunk)
                 // Update the VBOs of the neighboring chunks
                 for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
                 {
-                    neighbor->sections[i].dirty = true;
+                    neighbor->sections[i].mark_dirty();
                 }
             }
         }
@@ -6,7 +6,6 @@
 #include <world/chunk.hpp>
 #include <render/render.hpp>
 #include <render/render_gui.hpp>
-#include <render/render_fluids.hpp> // For fluid direction
 #include <block/blocks.hpp>
 #include <world/light.hpp>
 #include <world/particle.hpp>
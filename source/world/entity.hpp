@@ -97,6 +97,12 @@ public:
 
     virtual void render(float partial_ticks, bool transparency);
 
+    // Returns true if the entity draws something that can be seen through walls
+    virtual bool visible_through_walls()
+    {
+        return false;
+    }
+
     virtual size_t size()
     {
         return sizeof(*this);
@@ -330,6 +336,12 @@ public:
     virtual void tick();
 
     virtual void render(float partial_ticks, bool transparency);
+
+    // The name tag is drawn through walls
+    virtual bool visible_through_walls()
+    {
+        return true;
+    }
 };
 
 #endif
\ No newline at end of file
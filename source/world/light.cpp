@@ -9,6 +9,7 @@
 #include <registry/block_list.hpp>
 #include <util/lock.hpp>
 #include <util/timers.hpp>
+#include <util/debuglog.hpp>
 #include <cmath>
 #include <sys/unistd.h>
 #include <gccore.h>
@@ -73,11 +74,71 @@ void LightEngine::post(const Vec3i &location)
     Chunk *chunk = world->get_chunk_from_pos(location);
     if (!chunk)
         return;
-    while (pending_updates.size() >= 10000)
+    // A stopped engine never drains the queue on its own, see flush
+    while (thread_active && pending_updates.size() >= 10000)
         usleep(500);
     pending_updates.push_back(location);
 }
 
+void LightEngine::flush()
+{
+    while (pending_updates.size() > 0)
+    {
+        Vec3i current = pending_updates.front();
+        pending_updates.pop_front();
+        process(current);
+    }
+}
+
+uint8_t LightEngine::compute_light(ChunkCache &cache, int x, int y, int z, BlockState *state, Chunk *chunk)
+{
+    BlockBase *block = block_list[state->id];
+
+    uint8_t sky = 0;
+    uint8_t torch = block->light_luminance();
+
+    if (!world->hell && y >= chunk->height_map[(z & 15) << 4 | (x & 15)])
+        sky = 0xF;
+
+    if (!state->id || !block->is_opaque() || block->light_opacity() < 15)
+    {
+        int8_t opacity = std::max<int8_t>(block->light_opacity(), 1);
+
+        for (int i = 0; i < 6; i++)
+        {
+            const Vec3i &o = face_offsets[i];
+            Chunk *n_chunk;
+            BlockState *nb = get_block_cached(cache, x + o.x, y + o.y, z + o.z, n_chunk);
+            if (!nb)
+                continue;
+
+            sky = std::max<int8_t>(sky, std::max<int8_t>(nb->sky_light - opacity, 0));
+            torch = std::max<int8_t>(torch, std::max<int8_t>(nb->block_light - opacity, 0));
+        }
+    }
+
+    return (sky << 4) | torch;
+}
+
+#ifdef LIGHT_ENGINE_VERIFY
+uint32_t LightEngine::verify(ChunkCache &cache, const Vec3i &start, const Vec3i &volume)
+{
+    // A settled light field is its own fixed point: recomputing any block
+    // from its neighbours must give back the stored value.
+    uint32_t mismatches = 0;
+    for (int y = std::max(start.y - volume.y, 0); y <= std::min(start.y + volume.y, MAX_WORLD_Y); y++)
+        for (int z = start.z - volume.z; z <= start.z + volume.z; z++)
+            for (int x = start.x - volume.x; x <= start.x + volume.x; x++)
+            {
+                Chunk *chunk = nullptr;
+                BlockState *state = get_block_cached(cache, x, y, z, chunk);
+                if (state && compute_light(cache, x, y, z, state, chunk) != state->light)
+                    mismatches++;
+            }
+    return mismatches;
+}
+#endif
+
 void LightEngine::process(const Vec3i &start)
 {
     int start_cx = start.x >> 4;
@@ -87,6 +148,9 @@ void LightEngine::process(const Vec3i &start)
     Chunk *start_chunk = cache.chunks[1][1];
     if (!start_chunk)
         return;
+    uint64_t start_time = time_get();
+    uint32_t visited = 0;
+    size_t peak_queue = 1;
     std::deque<LightNode> stack;
     stack.push_back({start.x, start.y, start.z});
 
@@ -107,39 +171,15 @@ void LightEngine::process(const Vec3i &start)
     {
         LightNode n = stack.front();
         stack.pop_front();
+        visited++;
 
         Chunk *chunk = nullptr;
         BlockState *state = get_block_cached(cache, n.x, n.y, n.z, chunk);
         if (!state)
             continue;
-        BlockBase *block = block_list[state->id];
 
         uint8_t old_light = state->light;
-
-        uint8_t sky = 0;
-        uint8_t torch = block->light_luminance();
-
-        if (!world->hell && n.y >= chunk->height_map[(n.z & 15) << 4 | (n.x & 15)])
-            sky = 0xF;
-
-        if (!state->id || !block->is_opaque() || block->light_opacity() < 15)
-        {
-            int8_t opacity = std::max<int8_t>(block->light_opacity(), 1);
-
-            for (int i = 0; i < 6; i++)
-            {
-                const Vec3i &o = face_offsets[i];
-                Chunk *n_chunk;
-                BlockState *nb = get_block_cached(cache, n.x + o.x, n.y + o.y, n.z + o.z, n_chunk);
-                if (!nb)
-                    continue;
-
-                sky = std::max<int8_t>(sky, std::max<int8_t>(nb->sky_light - opacity, 0));
-                torch = std::max<int8_t>(torch, std::max<int8_t>(nb->block_light - opacity, 0));
-            }
-        }
-
-        uint8_t new_light = (sky << 4) | torch;
+        uint8_t new_light = compute_light(cache, n.x, n.y, n.z, state, chunk);
         if (new_light == old_light && !(n.x == start.x && n.y == start.y && n.z == start.z))
             continue;
 
@@ -153,13 +193,32 @@ void LightEngine::process(const Vec3i &start)
             if ((nblock = get_block_cached(cache, n.x + o.x, n.y + o.y, n.z + o.z, nchunk)))
             {
                 stack.push_back({n.x + o.x, n.y + o.y, n.z + o.z});
+                peak_queue = std::max(peak_queue, stack.size());
                 update_volume.x = std::max(update_volume.x, std::abs(n.x + o.x - start.x));
                 update_volume.y = std::max(update_volume.y, std::abs(n.y + o.y - start.y));
                 update_volume.z = std::max(update_volume.z, std::abs(n.z + o.z - start.z));
             }
         }
     }
-    start_chunk->sections[std::clamp(start.y >> 4, 0, VERTICAL_SECTION_COUNT - 1)].dirty = true;
+    // The start block may not have changed its light, but its neighbors still need to be re-meshed
+    Section &start_section = start_chunk->sections[std::clamp(start.y >> 4, 0, VERTICAL_SECTION_COUNT - 1)];
+    start_section.mark_dirty(section_slabs_in_range(start_section.y, start.y - 1, start.y + 1));
+
+    light_stats.updates++;
+    light_stats.last_visited = visited;
+    light_stats.last_peak_queue = peak_queue;
+    light_stats.last_us = time_diff_us(start_time, time_get());
+    light_stats.max_peak_queue = std::max<uint32_t>(light_stats.max_peak_queue, peak_queue);
+    light_stats.total_visited += visited;
+    light_stats.total_us += light_stats.last_us;
+#ifdef LIGHT_ENGINE_VERIFY
+    uint32_t mismatches = verify(cache, start, update_volume);
+    if (mismatches)
+    {
+        debug::print("Light update at %d %d %d left %u blocks unsettled\n", start.x, start.y, start.z, mismatches);
+        light_stats.mismatches += mismatches;
+    }
+#endif
 
     // Apply to neighbors if at chunk border
     if (world->smooth_lighting)
@@ -169,6 +228,10 @@ void LightEngine::process(const Vec3i &start)
         update_volume.z++;
     }
 
+    // Only the slabs within the update volume and one block around it need their light updated.
+    int min_y = start.y - update_volume.y - 1;
+    int max_y = start.y + update_volume.y + 1;
+
     // Update the (potentially) affected sections.
     for (int y = start.y - update_volume.y; y <= start.y + update_volume.y + 15; y += 16)
         for (int z = start.z - update_volume.z; z <= start.z + update_volume.z + 15; z += 16)
@@ -177,7 +240,15 @@ void LightEngine::process(const Vec3i &start)
                 Chunk *nchunk2 = nullptr;
                 if (get_block_cached(cache, x, y, z, nchunk2))
                 {
-                    nchunk2->sections[std::clamp(y >> 4, 0, VERTICAL_SECTION_COUNT - 1)].dirty = true;
+                    Section &section = nchunk2->sections[std::clamp(y >> 4, 0, VERTICAL_SECTION_COUNT - 1)];
+
+                    // Only the blocks right next to the start block can change shape, further away only the light changes
+                    uint8_t shape_slabs = 0;
+                    if (start.x + 1 >= section.x && start.x - 1 <= section.x + 15 && start.z + 1 >= section.z && start.z - 1 <= section.z + 15)
+                        shape_slabs = section_slabs_in_range(section.y, start.y - 1, start.y + 1);
+                    if (shape_slabs)
+                        section.mark_dirty(shape_slabs);
+                    section.mark_light_dirty(section_slabs_in_range(section.y, min_y, max_y) & ~shape_slabs);
                 }
             }
 
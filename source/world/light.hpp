@@ -7,6 +7,22 @@
 #include <deque>
 
 class World;
+class Chunk;
+class BlockState;
+struct ChunkCache;
+
+struct LightStats
+{
+    uint32_t updates = 0;         // Number of processed light updates
+    uint32_t last_visited = 0;    // Nodes visited by the last update
+    uint32_t last_peak_queue = 0; // Peak queue depth of the last update
+    uint32_t last_us = 0;         // Duration of the last update
+    uint32_t max_peak_queue = 0;  // Highest queue depth seen so far
+    uint64_t total_visited = 0;
+    uint64_t total_us = 0;
+    uint32_t mismatches = 0;      // Blocks found unsettled (LIGHT_ENGINE_VERIFY only)
+};
+
 class LightEngine
 {
 private:
@@ -15,8 +31,13 @@ private:
     World *world;
     std::deque<Vec3i> pending_updates;
     WorkerThread worker;
+    LightStats light_stats;
 
+    uint8_t compute_light(ChunkCache &cache, int x, int y, int z, BlockState *state, Chunk *chunk);
     void process(const Vec3i &start);
+#ifdef LIGHT_ENGINE_VERIFY
+    uint32_t verify(ChunkCache &cache, const Vec3i &start, const Vec3i &volume);
+#endif
 
 public:
     LightEngine(World *world = nullptr) : world(world) {}
@@ -27,8 +48,13 @@ public:
 
     void post(const Vec3i &location);
 
+    // Processes every posted update on the calling thread. Only for a stopped engine.
+    void flush();
+
     bool busy();
 
+    const LightStats &stats() const { return light_stats; }
+
     void update_loop();
 };
 enum LightType
@@ -2,52 +2,100 @@
 #include <world/chunk.hpp>
 #include <world/world.hpp>
 #include <block/block_properties.hpp>
+#include <util/timers.hpp>
+#include <algorithm>
+#include <cstring>
 
-void Particle::update(float dt)
+void ParticleSystem::set_capacity(size_t capacity)
 {
-    if (!life_time)
-        return;
-    if (physics & PPHYSIC_FLAG_GRAVITY)
+    m_capacity = std::clamp<size_t>(capacity, 1, PARTICLE_MAX_CAPACITY);
+    positions.clear();
+    velocities.clear();
+    life_times.clear();
+    max_life_times.clear();
+    physics.clear();
+    types.clear();
+    sizes.clear();
+    brightness.clear();
+    data.clear();
+    unlit.clear();
+    m_free_slots.clear();
+}
+
+// Particles of a burst are added next to each other and usually stay within a chunk or two,
+// so the chunk of the previous lookup is kept instead of going through the chunk cache every time
+struct ParticleBlockLookup
+{
+    World *world;
+    Chunk *chunk = nullptr;
+    int32_t chunk_x = 0;
+    int32_t chunk_z = 0;
+    bool valid = false;
+
+    BlockState *get(const Vec3i &pos)
     {
-        // Apply gravity
-        velocity.y -= ENTITY_GRAVITY * dt;
+        if (pos.y < 0 || pos.y > MAX_WORLD_Y)
+            return nullptr;
+        int32_t x = pos.x >> 4;
+        int32_t z = pos.z >> 4;
+        if (!valid || x != chunk_x || z != chunk_z)
+        {
+            chunk = world->get_chunk(x, z);
+            chunk_x = x;
+            chunk_z = z;
+            valid = true;
+        }
+        return chunk ? chunk->get_block(pos) : nullptr;
     }
+};
 
-    if (physics & PPHYSIC_FLAG_FRICTION)
+void ParticleSystem::update(float dt)
+{
+    uint64_t start_time = time_get();
+    ParticleBlockLookup lookup{world};
+    m_update_count++;
+    size_t count = life_times.size();
+    for (size_t i = 0; i < count; i++)
     {
-        // Apply friction on X and Z axis
-        velocity.x *= 0.85f;
-        velocity.z *= 0.85f;
+        if (!life_times[i])
+            continue;
 
-        // Set terminal velocity on y axis
-        const float terminal_velocity = 20.0f;
-        if (velocity.y > terminal_velocity)
+        Vec3f &position = positions[i];
+        Vec3f &velocity = velocities[i];
+        uint8_t flags = physics[i];
+
+        if (flags & PPHYSIC_FLAG_GRAVITY)
         {
-            velocity.y = terminal_velocity;
+            // Apply gravity
+            velocity.y -= ENTITY_GRAVITY * dt;
         }
-        else if (velocity.y < -terminal_velocity)
+
+        if (flags & PPHYSIC_FLAG_FRICTION)
         {
-            velocity.y = -terminal_velocity;
+            // Apply friction on X and Z axis
+            velocity.x *= 0.85f;
+            velocity.z *= 0.85f;
+
+            // Set terminal velocity on y axis
+            const float terminal_velocity = 20.0f;
+            velocity.y = std::clamp<vfloat_t>(velocity.y, -terminal_velocity, terminal_velocity);
         }
-    }
 
-    // Used for collision detection
-    Vec3i old_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
+        // Used for collision detection
+        Vec3i old_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
 
-    // Update position
-    position = position + velocity * dt;
+        // Update position
+        position = position + velocity * dt;
 
-    // Check if the particle has moved
-    Vec3i new_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
+        // Check if the particle has moved
+        Vec3i new_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
 
-    // Get the block at the particle's position
-    BlockState *block = world->get_block_at(new_pos);
-    if (block)
-    {
-        if (old_pos != new_pos)
+        // Get the block at the particle's position
+        BlockState *block = lookup.get(new_pos);
+        if (block && old_pos != new_pos)
         {
             // Check if the block is solid
-            if ((physics & PPHYSIC_FLAG_COLLIDE) && block_properties[block->id].m_opacity > 1)
+            if ((flags & PPHYSIC_FLAG_COLLIDE) && block_properties[block->id].m_opacity > 1)
             {
                 // Place the particle on the surface of the block
                 Vec3f old_vel = velocity;
@@ -73,42 +121,76 @@ void Particle::update(float dt)
                     position.z = old_pos.z - .5f;
                 else
                     velocity.z = old_vel.z;
+
+                // Only look the block up again if the particle was moved out of it
+                new_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
+                block = lookup.get(new_pos);
             }
         }
-    }
-    new_pos = Vec3i(std::round(position.x), std::round(position.y), std::round(position.z));
-    block = world->get_block_at(new_pos);
-    if (block)
-    {
-        brightness = block->light;
-        if (block_properties[block->id].m_opacity > 1)
+
+        uint8_t life_time = life_times[i];
+        if (block)
         {
-            life_time = 0;
+            // The light is sampled less often than the physics, staggered across the particles.
+            // New particles sample it right away so they don't show up full bright in the dark.
+            if (unlit[i] || ((i + m_update_count) % PARTICLE_LIGHT_INTERVAL) == 0)
+            {
+                brightness[i] = block->light;
+                unlit[i] = false;
+            }
+            if (block_properties[block->id].m_opacity > 1)
+                life_time = 0;
         }
-    }
 
-    // Update lifetime
-    if (life_time > 0)
-        life_time--;
+        // Update lifetime and give the slot back once the particle is gone
+        if (life_time > 0)
+            life_time--;
+        life_times[i] = life_time;
+        if (!life_time)
+            m_free_slots.push_back(i);
+    }
+    stats.update_us = time_diff_us(start_time, time_get());
 }
 
-void ParticleSystem::update(float dt)
+void ParticleSystem::add_particle(const Particle &part)
 {
-    for (int i = 0; i < 256; i++)
+    if (!part.life_time)
+        return;
+
+    size_t slot;
+    if (!m_free_slots.empty())
     {
-        particles[i].update(dt);
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
     }
-}
-
-void ParticleSystem::add_particle(Particle part)
-{
-    for (int i = 0; i < 256; i++)
+    else if (life_times.size() < m_capacity)
     {
-        if (particles[i].life_time == 0)
-        {
-            particles[i] = part;
-            particles[i].world = world;
-            return;
-        }
+        slot = life_times.size();
+        positions.emplace_back();
+        velocities.emplace_back();
+        life_times.emplace_back();
+        max_life_times.emplace_back();
+        physics.emplace_back();
+        types.emplace_back();
+        sizes.emplace_back();
+        brightness.emplace_back();
+        data.emplace_back();
+        unlit.emplace_back();
+    }
+    else
+    {
+        stats.dropped++;
+        return;
     }
-}
\ No newline at end of file
+
+    positions[slot] = part.position;
+    velocities[slot] = part.velocity;
+    life_times[slot] = part.life_time;
+    max_life_times[slot] = part.max_life_time;
+    physics[slot] = part.physics;
+    types[slot] = part.type;
+    sizes[slot] = part.size;
+    brightness[slot] = part.brightness;
+    unlit[slot] = true;
+    std::memcpy(&data[slot], part.color, sizeof(ParticleData));
+}
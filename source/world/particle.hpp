@@ -13,21 +13,50 @@
 
 #define PTYPE_MAX 3
 
-#include "entity.hpp"
+// Number of particles that can be alive at once unless configured otherwise
+#define PARTICLE_DEFAULT_CAPACITY 1024
+#define PARTICLE_MAX_CAPACITY 8192
 
-class Particle : public EntityBase
+// Particles sample the light of their block every this many updates
+#define PARTICLE_LIGHT_INTERVAL 4
+
+#include <cstdint>
+#include <vector>
+#include <math/vec3f.hpp>
+
+class World;
+
+// Extra information about a particle whose meaning depends on its type,
+// for example the color of the particle or the UV coordinates of the texture
+union ParticleData
 {
-public:
-    uint8_t max_life_time;
-    uint8_t life_time;
-    uint8_t physics;
-    uint8_t type;
-    uint8_t size;
-    uint8_t brightness;
-
-    // The data union is used to store extra information about the particle
-    // For example, the color of the particle or the UV coordinates of the texture
-    // Alternatively, the data union can be used to store a pointer to a custom data structure
+    struct
+    {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+        uint8_t a;
+    };
+    uint8_t color[4];
+    struct
+    {
+        uint16_t u;
+        uint16_t v;
+    };
+};
+
+// Describes a particle to be added to a ParticleSystem
+struct Particle
+{
+    Vec3f position = Vec3f(0, 0, 0);
+    Vec3f velocity = Vec3f(0, 0, 0);
+    uint8_t max_life_time = 0;
+    uint8_t life_time = 0;
+    uint8_t physics = 0;
+    uint8_t type = 0;
+    uint8_t size = 64;
+    uint8_t brightness = 255;
+
     // The behavior of the data union is determined by the type of the particle
     union
     {
@@ -38,44 +67,68 @@ public:
             uint8_t b;
             uint8_t a;
         };
-        uint8_t color[4];
-        void *data;
+        uint8_t color[4] = {0};
         struct
         {
             uint16_t u;
             uint16_t v;
         };
     };
-    World *world = nullptr;
-
-    Particle() {}
-    Particle(World *world) : EntityBase(), life_time(0), physics(0), type(0), size(64), brightness(255), u(0), v(0), world(world) {}
-
-    ~Particle() {}
+};
 
-    void update(float dt);
+struct ParticleStats
+{
+    uint32_t visible = 0;
+    uint32_t update_us = 0;
+    uint32_t render_us = 0;
 
+    // Particles that were not added because the system was full
+    uint32_t dropped = 0;
 };
 
+/**
+ * Stores the particles as parallel arrays indexed by slot. The arrays
+ * grow as needed up to the capacity, and the slots of dead particles
+ * are kept on a free list for reuse. A slot is in use while its life
+ * time is above zero.
+ */
 class ParticleSystem
 {
 public:
-    Particle particles[256];
+    std::vector<Vec3f> positions;
+    std::vector<Vec3f> velocities;
+    std::vector<uint8_t> life_times;
+    std::vector<uint8_t> max_life_times;
+    std::vector<uint8_t> physics;
+    std::vector<uint8_t> types;
+    std::vector<uint8_t> sizes;
+    std::vector<uint8_t> brightness;
+    std::vector<ParticleData> data;
+
+    // Set until the first update has sampled the light of the particle
+    std::vector<bool> unlit;
     World *world = nullptr;
 
-    ParticleSystem(World *world)
-    {
-        this->world = world;
-        for (int i = 0; i < 256; i++)
-        {
-            particles[i] = Particle(world);
-        }
-    }
+    // Particle count and timings of the most recent frame
+    ParticleStats stats;
+
+    ParticleSystem(World *world) : world(world) {}
 
-    size_t size() { return 256; }
+    // Returns the number of slots, including the ones of dead particles
+    size_t size() { return life_times.size(); }
+
+    size_t capacity() { return m_capacity; }
+
+    // Removes all particles and limits the system to the given number of particles
+    void set_capacity(size_t capacity);
 
     void update(float dt);
-    void add_particle(Particle part);
+    void add_particle(const Particle &part);
+
+private:
+    std::vector<uint16_t> m_free_slots;
+    size_t m_capacity = PARTICLE_DEFAULT_CAPACITY;
+    uint32_t m_update_count = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,6 +1,8 @@
 #include "world.hpp"
 
 #include <algorithm>
+#include <typeindex>
+#include <typeinfo>
 #include <unistd.h>
 #include <ported/Random.hpp>
 #include <ported/SystemTime.hpp>
@@ -29,7 +31,6 @@
 #include <util/face_pair.hpp>
 #include <util/debuglog.hpp>
 #include <light_nether_rgba.h>
-#include <unordered_set>
 
 extern bool should_destroy_block;
 extern bool should_place_block;
@@ -118,6 +119,7 @@ bool World::tick()
     {
         memory_usage += chunk ? chunk->size() : 0;
     }
+    memory_usage += m_far_terrain.size();
 
     if (m_sound_system)
         m_sound_system->update(angles_to_vector(0, get_camera().transform.get_rotation().y + 90), player.get_position(std::fmod(partial_ticks, 1)), true);
@@ -186,6 +188,10 @@ void World::update_chunks()
                 continue;
             chunk->tick_tile_entities();
 
+            // Keep the surface of every lit chunk for the far terrain
+            if (far_terrain && chunk->lit_state && !m_far_terrain.contains(chunk->x, chunk->z))
+                m_far_terrain.record(chunk);
+
             if (!chunk->lit_state && light_up_calls < 5)
             {
                 light_up_calls++;
@@ -195,7 +201,12 @@ void World::update_chunks()
                 continue;
             for (uint8_t i = 0; i < VERTICAL_SECTION_COUNT; i++)
             {
-                chunk->sections[i].refresh();
+                Section &section = chunk->sections[i];
+                if (section.mesh_ready)
+                {
+                    section.refresh();
+                    section.mesh_ready = false;
+                }
             }
         }
     }
@@ -210,6 +221,28 @@ void World::update_chunks()
     }
 }
 
+void World::swap_section_buffers()
+{
+    if (sync_section_updates)
+        return;
+
+    // The replaced buffers are retired and freed once this frame has been drawn
+    for (Chunk *&chunk : chunks)
+    {
+        if (!chunk || chunk->state != ChunkState::done)
+            continue;
+        for (int i = 0; i < VERTICAL_SECTION_COUNT; i++)
+        {
+            Section &section = chunk->sections[i];
+            if (section.mesh_ready)
+            {
+                section.refresh();
+                section.mesh_ready = false;
+            }
+        }
+    }
+}
+
 void World::try_update_sections()
 {
     uint64_t start_time = time_get();
@@ -337,7 +370,19 @@ bool World::update_sections()
             {
                 Section &current = chunk->sections[j];
                 if (!current.dirty)
+                {
+                    // Light changes are written into copies of the buffers when the blocks stayed the
+                    // same. Like a rebuild, this waits for the renderer to take the previous buffers.
+                    if (!current.light_slabs || current.mesh_pending || current.mesh_ready || chunk->light_pending || !has_nearby_chunks(current.x, current.y, current.z))
+                        continue;
+                    uint8_t slabs = current.light_slabs;
+                    current.light_slabs = 0;
+                    if (!ChunkRenderer::patch_section_light(current, slabs))
+                        current.mark_dirty(slabs);
+                    if (++update_count > max_updates)
+                        break;
                     continue;
+                }
 
                 bool processed = true;
                 switch (current.phase)
@@ -357,7 +402,27 @@ bool World::update_sections()
                         break;
                     }
 
-                    ChunkRenderer::render_section(current, false, current.solid.uncached);
+                    // The renderer has not taken the previous buffers yet
+                    if (current.mesh_ready)
+                    {
+                        processed = false;
+                        break;
+                    }
+
+                    // Take the slabs to rebuild, edits made from now on are picked up by the next update
+                    current.mesh_slabs |= current.dirty_slabs | current.light_slabs;
+                    current.dirty_slabs = 0;
+                    current.light_slabs = 0;
+
+                    if (ChunkRenderer::get_mesh_workers())
+                    {
+                        // A worker meshes both passes, so skip straight to the flush
+                        processed = ChunkRenderer::queue_section(current);
+                        if (processed)
+                            current.phase++;
+                        break;
+                    }
+                    ChunkRenderer::render_section(current, false, current.solid);
                     break;
                 case SectionUpdatePhase::TRANSPARENT:
                     if (chunk->light_pending || !current.visible || !has_nearby_chunks(current.x, current.y, current.z))
@@ -365,28 +430,39 @@ bool World::update_sections()
                         processed = false;
                         break;
                     }
-                    ChunkRenderer::render_section(current, true, current.transparent.uncached);
+                    ChunkRenderer::render_section(current, true, current.transparent);
                     break;
                 case SectionUpdatePhase::FLUSH:
-                    if (!sync_section_updates)
+                    if (current.mesh_pending)
                     {
-                        Lock lock(render_mutex);
-                        current.refresh();
+                        processed = false;
+                        break;
                     }
+                    current.mesh_slabs = 0;
+
+                    // Hand the new buffers over to the renderer
+                    current.mesh_ready = true;
                     break;
                 case SectionUpdatePhase::SECTION_VISIBILITY:
+                {
                     if (!has_nearby_sections(current.x, current.y, current.z))
                     {
                         processed = false;
                         break;
                     }
+                    uint16_t old_flags = current.visibility_flags;
                     chunk->refresh_section_visibility(j);
 
+                    // Let the visibility search run again if the paths through the section changed
+                    if (current.visibility_flags != old_flags)
+                        visibility_generation++;
+
                     if (current.has_updated)
                         current.dirty = false;
 
                     current.has_updated = true;
                     break;
+                }
                 default:
                     processed = false;
                     break;
@@ -411,17 +487,38 @@ bool World::update_sections()
  * https://tomcc.github.io/index.html
  */
 
-struct SectionNode
-{
-    Section *sect;
-    int8_t from;     // The face we entered the VBO from
-    uint8_t dirs[6]; // For preventing revisits of the same face
-};
-
 void World::calculate_visibility()
 {
-    init_face_pairs();
-    // Reset visibility status for all VBOs
+    // The search is independent of the camera rotation and its position
+    // within a section, so the previous result holds until either changes
+    Vec3f fpos = get_camera().transform.get_position();
+    Vec3i origin(int(std::floor(fpos.x)) & ~15, int(std::floor(fpos.y)) & ~15, int(std::floor(fpos.z)) & ~15);
+    uint32_t generation = visibility_generation;
+    if (origin == m_visibility_origin && generation == m_visibility_searched_generation)
+    {
+        m_visibility_stats.skipped++;
+        return;
+    }
+    m_visibility_origin = origin;
+    m_visibility_searched_generation = generation;
+    uint64_t start_time = time_get();
+
+    // Look up the face pair flags once
+    static uint16_t exit_flags[6][6];
+    static bool exit_flags_ready = false;
+    if (!exit_flags_ready)
+    {
+        init_face_pairs();
+        for (int i = 0; i < 6; i++)
+            for (int j = 0; j < 6; j++)
+                exit_flags[i][j] = face_pair_to_flag(i, j);
+        exit_flags_ready = true;
+    }
+
+    // Reset visibility status for all VBOs and find the chunks around the camera
+    const int center_x = origin.x >> 4;
+    const int center_z = origin.z >> 4;
+    m_visibility_grid.assign(VISIBILITY_GRID_SIZE * VISIBILITY_GRID_SIZE, nullptr);
     for (Chunk *&chunk : chunks)
     {
         if (chunk)
@@ -430,32 +527,43 @@ void World::calculate_visibility()
             {
                 chunk->sections[i].visible = false;
             }
+            int gx = chunk->x - center_x + VISIBILITY_GRID_RADIUS;
+            int gz = chunk->z - center_z + VISIBILITY_GRID_RADIUS;
+            if (gx >= 0 && gz >= 0 && gx < VISIBILITY_GRID_SIZE && gz < VISIBILITY_GRID_SIZE)
+                m_visibility_grid[gx + gz * VISIBILITY_GRID_SIZE] = chunk;
         }
     }
 
     // Gets the VBO at the given position
-    auto section_at = [this](const Vec3i &pos) -> Section *
+    auto section_at = [this, center_x, center_z](const Vec3i &pos) -> Section *
     {
         // Out of bounds check for Y coordinate
         if (pos.y < 0 || pos.y >= WORLD_HEIGHT)
             return nullptr;
 
-        // Get the chunk from the position
-        Chunk *chunk = get_chunk_from_pos(pos);
+        int gx = (pos.x >> 4) - center_x + VISIBILITY_GRID_RADIUS;
+        int gz = (pos.z >> 4) - center_z + VISIBILITY_GRID_RADIUS;
+        if (gx < 0 || gz < 0 || gx >= VISIBILITY_GRID_SIZE || gz >= VISIBILITY_GRID_SIZE)
+            return nullptr;
 
         // If the chunk doesn't exist, neither does the VBO
+        Chunk *chunk = m_visibility_grid[gx + gz * VISIBILITY_GRID_SIZE];
         if (!chunk)
             return nullptr;
 
         return &chunk->sections[pos.y >> 4];
     };
 
-    Vec3f fpos = get_camera().transform.get_position();
-    std::deque<SectionNode> queue;
-    std::unordered_set<Section *> visited;
+    // Sections are marked as visited by setting their epoch to the current one
+    uint32_t epoch = ++m_visibility_epoch;
+    m_visibility_queue.resize(VISIBILITY_QUEUE_SIZE);
+    const size_t mask = VISIBILITY_QUEUE_SIZE - 1;
+    size_t head = 0;
+    size_t tail = 0;
+    uint32_t visited = 0;
 
     SectionNode start{};
-    start.sect = section_at(Vec3i(int(fpos.x), int(fpos.y), int(fpos.z)));
+    start.sect = section_at(origin);
     start.from = -1;
     std::memset(start.dirs, 0, sizeof(start.dirs));
 
@@ -463,17 +571,17 @@ void World::calculate_visibility()
     if (!start.sect)
         return;
 
-    queue.push_back(start);
-    visited.insert(start.sect);
+    start.sect->visibility_epoch = epoch;
+    m_visibility_queue[tail++ & mask] = start;
 
-    while (!queue.empty())
+    while (head != tail)
     {
-        SectionNode node = queue.front();
-        queue.pop_front();
+        SectionNode node = m_visibility_queue[head++ & mask];
 
         node.sect->visible = true;
+        visited++;
 
-        Vec3i origin(node.sect->x, node.sect->y, node.sect->z);
+        Vec3i section_pos(node.sect->x, node.sect->y, node.sect->z);
 
         for (int dir = 0; dir < 6; ++dir)
         {
@@ -481,54 +589,26 @@ void World::calculate_visibility()
             if (node.dirs[dir ^ 1])
                 continue;
 
-            Vec3i neighbor_pos = origin + face_offsets[dir] * 16;
-            Section *neighbor = section_at(neighbor_pos);
-
-            if (!neighbor)
+            // Portal / visibility check: can we go from the entry face to the exit face
+            if (node.from != -1 && !(node.sect->visibility_flags & exit_flags[node.from][dir]))
                 continue;
 
-            if (visited.count(neighbor))
-                continue;
-
-            int enter_face = dir ^ 1; // how we enter the neighbor
-
-            // Portal / visibility check
-            if (node.from != -1)
-            {
-                // Check if we can go from entry face -> exit face
-                if (!(node.sect->visibility_flags &
-                      face_pair_to_flag(node.from, dir)))
-                {
-                    continue;
-                }
-            }
-
             // Distance check
-            Vec3f offset = Vec3f(neighbor_pos.x + 8,
-                                 neighbor_pos.y + 8,
-                                 neighbor_pos.z + 8) -
-                           fpos;
-
-            if (std::abs(offset.x) + std::abs(offset.z) > RENDER_DISTANCE)
+            Vec3i neighbor_pos = section_pos + face_offsets[dir] * 16;
+            if (std::abs(neighbor_pos.x - origin.x) + std::abs(neighbor_pos.z - origin.z) > RENDER_DISTANCE)
                 continue;
 
-            // Frustum check
-            if (!is_cube_visible(*frustum,
-                                 Vec3f(neighbor_pos.x + 8,
-                                       neighbor_pos.y + 8,
-                                       neighbor_pos.z + 8),
-                                 16.0f))
-            {
+            Section *neighbor = section_at(neighbor_pos);
+            if (!neighbor || neighbor->visibility_epoch == epoch)
                 continue;
-            }
 
             // Mark visited
-            visited.insert(neighbor);
+            neighbor->visibility_epoch = epoch;
 
             // Build next node
             SectionNode next{};
             next.sect = neighbor;
-            next.from = enter_face;
+            next.from = dir ^ 1; // how we enter the neighbor
 
             // Copy exit usage
             std::memcpy(next.dirs, node.dirs, sizeof(node.dirs));
@@ -536,9 +616,14 @@ void World::calculate_visibility()
             // Mark that we used this exit direction
             next.dirs[dir] = 1;
 
-            queue.push_back(next);
+            m_visibility_queue[tail++ & mask] = next;
         }
     }
+
+    m_visibility_stats.last_visited = visited;
+    m_visibility_stats.last_us = time_diff_us(start_time, time_get());
+    m_visibility_stats.average_us = m_visibility_stats.searches ? (m_visibility_stats.average_us * 15 + m_visibility_stats.last_us) / 16 : m_visibility_stats.last_us;
+    m_visibility_stats.searches++;
 }
 
 void World::edit_blocks()
@@ -737,12 +822,12 @@ int World::prepare_chunks(int count)
 
 void World::save_and_clean_chunk(Chunk *chunk)
 {
+    // Refresh the far terrain with any changes made while the chunk was loaded
+    if (far_terrain && chunk->lit_state)
+        m_far_terrain.record(chunk);
+    // The buffers are freed by the chunk manager once no mesh worker is writing to them
     for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
-    {
-        Section &current = chunk->sections[j];
-        current.visible = false;
-        current.clear();
-    }
+        chunk->sections[j].visible = false;
     save_chunk(chunk);
 }
 
@@ -911,9 +996,10 @@ void World::draw(Camera &camera)
 
     // Draw particles
     gertex::set_alpha_cutoff(1);
-    draw_particles(camera, m_particle_system.particles, m_particle_system.size());
+    draw_particles(camera, m_particle_system);
 
     // Draw chunks
+    update_draw_list(camera);
     gertex::set_alpha_cutoff(0);
     draw_scene(true);
 
@@ -927,89 +1013,214 @@ void World::draw(Camera &camera)
     draw_scene(false);
 }
 
-void World::draw_scene(bool opaque)
+void World::update_draw_list(Camera &camera)
 {
-    // Use terrain texture
-    use_texture(terrain_texture);
+    uint64_t cull_start = time_get();
+    uint32_t culled_columns = 0;
+    uint32_t partial_columns = 0;
+
+    // The section centers of a column only differ in y
+    float section_x[VERTICAL_SECTION_COUNT];
+    float section_y[VERTICAL_SECTION_COUNT];
+    float section_z[VERTICAL_SECTION_COUNT];
+    uint8_t section_results[VERTICAL_SECTION_COUNT];
+    for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
+        section_y[j] = (j << 4) + 8;
 
-    gertex::set_color_format(0, GX_INDEX8);
-    gertex::set_pos_precision(GX_S16, BASE3D_POS_FRAC_BITS);
+    // Gather the columns that can be drawn and classify them all at once
+    m_cull_chunks.clear();
+    m_cull_x.clear();
+    m_cull_z.clear();
+    for (Chunk *&chunk : chunks)
+    {
+        if (chunk && chunk->state == ChunkState::done && chunk->lit_state)
+        {
+            m_cull_chunks.push_back(chunk);
+            m_cull_x.push_back((chunk->x << 4) + 8);
+            m_cull_z.push_back((chunk->z << 4) + 8);
+        }
+    }
+    size_t column_count = m_cull_chunks.size();
+    m_cull_y.assign(column_count, WORLD_HEIGHT / 2);
+    m_cull_results.assign(column_count, FRUSTUM_INSIDE);
 
-    std::deque<std::pair<Section *, VBO *>> sections_to_draw;
-    std::deque<std::pair<Section *, VBO *>> colored_sections_to_draw;
+    // The visibility search does not look at the camera direction, so cull against the frustum here.
+    // The whole columns are tested first and the sections only when their column is partially visible.
+    if (frustum && column_count)
+        classify_boxes(*frustum, m_cull_x.data(), m_cull_y.data(), m_cull_z.data(), Vec3f(8, WORLD_HEIGHT / 2, 8), int(column_count), m_cull_results.data());
 
-    // Draw the solid pass
-    if (opaque)
+    m_draw_members_next.clear();
+    for (size_t i = 0; i < column_count; i++)
     {
-        for (Chunk *&chunk : chunks)
+        Chunk *chunk = m_cull_chunks[i];
+        uint8_t column_result = m_cull_results[i];
+        if (column_result == FRUSTUM_OUTSIDE)
+        {
+            culled_columns++;
+            continue;
+        }
+        if (column_result == FRUSTUM_PARTIAL)
         {
-            if (chunk && chunk->state == ChunkState::done && chunk->lit_state)
+            partial_columns++;
+            for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
             {
-                for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
-                {
-                    Section &current = chunk->sections[j];
-                    if (current.visible && current.solid.cached)
-                        sections_to_draw.push_back(std::make_pair(&current, &current.solid.cached));
-                }
+                section_x[j] = m_cull_x[i];
+                section_z[j] = m_cull_z[i];
             }
+            classify_boxes(*frustum, section_x, section_y, section_z, Vec3f(8, 8, 8), VERTICAL_SECTION_COUNT, section_results);
+        }
+
+        for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
+        {
+            Section &current = chunk->sections[j];
+            if (current.visible && (column_result == FRUSTUM_INSIDE || section_results[j] != FRUSTUM_OUTSIDE))
+                m_draw_members_next.push_back(std::make_pair(&current, Vec3i(current.x, current.y, current.z)));
         }
     }
-    // Draw the transparent pass
-    else
+    m_visibility_stats.culled_columns = culled_columns;
+    m_visibility_stats.partial_columns = partial_columns;
+    m_visibility_stats.cull_us = time_diff_us(cull_start, time_get());
+
+    // The sorting and matrices stay valid until the camera or the sections change
+    bool camera_moved = std::memcmp(camera.view, m_draw_view, sizeof(Mtx)) != 0;
+    if (!camera_moved && m_draw_members_next == m_draw_members)
+        return;
+    m_draw_members.swap(m_draw_members_next);
+    guMtxCopy(camera.view, m_draw_view);
+
+    const guVector &eye = camera.transform.get_position();
+    m_draw_list.resize(m_draw_members.size());
+    for (size_t i = 0; i < m_draw_members.size(); i++)
     {
-        for (Chunk *&chunk : chunks)
+        SectionDraw &entry = m_draw_list[i];
+        entry.section = m_draw_members[i].first;
+        entry.position = m_draw_members[i].second;
+
+        Vec3f center = Vec3f(entry.position.x + 8.0f, entry.position.y + 8.0f, entry.position.z + 8.0f);
+        Vec3f delta = center - Vec3f(eye.x, eye.y, eye.z);
+        entry.distance = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+
+        Transform transform;
+        transform.set_position({entry.position.x + 0.5f, entry.position.y + 0.5f, entry.position.z + 0.5f});
+        entry.matrix = camera.apply_transform(transform);
+    }
+    std::sort(m_draw_list.begin(), m_draw_list.end(), [](const SectionDraw &a, const SectionDraw &b)
+              { return a.distance < b.distance; });
+}
+
+void World::draw_entities(bool transparency)
+{
+    m_entity_batch.clear();
+    Vec3f camera_pos = Vec3f(get_camera().transform.get_position());
+    for (Chunk *&chunk : chunks)
+    {
+        if (chunk)
+            chunk->collect_visible_entities(frustum, camera_pos, m_entity_batch);
+    }
+
+    if (!m_entity_batch.empty())
+    {
+        // Group the entities by type so models of the same kind are drawn one after another
+        std::stable_sort(m_entity_batch.begin(), m_entity_batch.end(), [](EntityPhysical *a, EntityPhysical *b)
+                         { return std::type_index(typeid(*a)) < std::type_index(typeid(*b)); });
+
+        // Entities of the same type leave the state the same way, so only the colors
+        // need resetting between them. The full state is restored between groups.
+        gertex::GXState state = gertex::get_state();
+        for (size_t i = 0; i < m_entity_batch.size(); i++)
         {
-            if (chunk && chunk->state == ChunkState::done && chunk->lit_state)
+            EntityPhysical *entity = m_entity_batch[i];
+            if (i > 0)
             {
-                for (int j = 0; j < VERTICAL_SECTION_COUNT; j++)
+                if (typeid(*entity) != typeid(*m_entity_batch[i - 1]))
+                    gertex::set_state(state);
+                else
                 {
-                    Section &current = chunk->sections[j];
-                    if (current.visible && current.transparent.cached)
-                        sections_to_draw.push_back(std::make_pair(&current, &current.transparent.cached));
-                    if (current.visible && current.colored.cached)
-                        colored_sections_to_draw.push_back(std::make_pair(&current, &current.colored.cached));
+                    gertex::set_color_mul(state.color_multiply);
+                    gertex::set_color_add(state.color_add);
                 }
             }
+            entity->render(partial_ticks, transparency);
         }
+        gertex::set_state(state);
     }
 
-    for (Chunk *&chunk : chunks)
-    {
-        chunk->render_entities(partial_ticks, !opaque);
-    }
+    // Restore default texture
+    use_texture(terrain_texture);
 
-    Camera &camera = get_camera();
+    // Restore default colors
+    gertex::set_color_mul(GXColor{255, 255, 255, 255});
+    gertex::set_color_add(GXColor{0, 0, 0, 255});
+}
+
+void World::draw_scene(bool opaque)
+{
+    // Use terrain texture
+    use_texture(terrain_texture);
 
-    // Draw the vbos
-    for (std::pair<Section *, VBO *> &pair : sections_to_draw)
+    gertex::set_color_format(0, GX_INDEX8);
+    gertex::set_pos_precision(GX_S16, BASE3D_POS_FRAC_BITS);
+    use_terrain_vertex_format();
+
+    draw_entities(!opaque);
+
+    // Draw the vbos, solid ones front to back and transparent ones back to front
+    if (opaque)
     {
-        Section *&sect = pair.first;
-        VBO *&buffer = pair.second;
+        for (SectionDraw &entry : m_draw_list)
+        {
+            VBO &buffer = entry.section->solid.cached;
+            if (!buffer)
+                continue;
+            gertex::use_matrix(entry.matrix);
+            gertex::call_display_list(buffer.buffer, buffer.length, VERTEX_ATTR_LENGTH_TERRAIN);
+        }
 
-        Transform transform;
-        transform.set_position({sect->x + 0.5f, sect->y + 0.5f, sect->z + 0.5f});
-        gertex::use_matrix(camera.apply_transform(transform));
+        // Faces merged by greedy meshing repeat their tile with the indirect stage
+        if (terrain_tile_size)
+        {
+            use_tiled_terrain(true);
+            for (SectionDraw &entry : m_draw_list)
+            {
+                VBO &buffer = entry.section->tiled.cached;
+                if (!buffer)
+                    continue;
+                gertex::use_matrix(entry.matrix);
+                gertex::call_display_list(buffer.buffer, buffer.length, VERTEX_ATTR_LENGTH_TERRAIN);
+            }
+            use_tiled_terrain(false);
+        }
 
-        GX_CallDispList(buffer->buffer, buffer->length);
+        // The far terrain is behind everything else
+        if (far_terrain)
+            m_far_terrain.draw(get_camera());
     }
-
+    else
     {
+        for (auto it = m_draw_list.rbegin(); it != m_draw_list.rend(); ++it)
+        {
+            VBO &buffer = it->section->transparent.cached;
+            if (!buffer)
+                continue;
+            gertex::use_matrix(it->matrix);
+            gertex::call_display_list(buffer.buffer, buffer.length, VERTEX_ATTR_LENGTH_TERRAIN);
+        }
+
         gertex::GXState state = gertex::get_state();
         gertex::set_color_format(0, GX_DIRECT);
-        for (std::pair<Section *, VBO *> &pair : colored_sections_to_draw)
+        for (auto it = m_draw_list.rbegin(); it != m_draw_list.rend(); ++it)
         {
-            Section *&sect = pair.first;
-            VBO *&buffer = pair.second;
-
-            Transform transform;
-            transform.set_position({sect->x + 0.5f, sect->y + 0.5f, sect->z + 0.5f});
-            gertex::use_matrix(camera.apply_transform(transform));
-
-            GX_CallDispList(buffer->buffer, buffer->length);
+            VBO &buffer = it->section->colored.cached;
+            if (!buffer)
+                continue;
+            gertex::use_matrix(it->matrix);
+            gertex::call_display_list(buffer.buffer, buffer.length, VERTEX_ATTR_LENGTH_TERRAIN_DIRECTCOLOR);
         }
         gertex::set_state(state);
     }
 
+    Camera &camera = get_camera();
+
     if (player.raycast_target_found && should_destroy_block && player.mining_tick > 0)
     {
         Chunk *targeted_chunk = get_chunk_from_pos(player.raycast_target_pos);
@@ -1705,6 +1916,7 @@ void World::save_chunk(Chunk *chunk)
 
     // Remove the chunk from the active list
     chunks.erase(std::remove(chunks.begin(), chunks.end(), chunk), chunks.end());
+    visibility_generation++;
 
     // Remove the chunk from the cache
     uint64_t key = uint32_pair(chunk->x, chunk->z);
@@ -1749,6 +1961,7 @@ bool World::add_chunk(int32_t x, int32_t z)
 
 void World::deinit_chunk_manager()
 {
+    ChunkRenderer::stop_mesh_workers();
     if (chunk_manager.active())
         chunk_manager.stop();
 }
@@ -1756,7 +1969,10 @@ void World::deinit_chunk_manager()
 void World::init_chunk_manager()
 {
     if (!chunk_manager.active())
+    {
         chunk_manager.start(this);
+        ChunkRenderer::start_mesh_workers(mesh_workers);
+    }
 }
 
 BlockID World::get_block_id_at(const Vec3i &position, BlockID default_id)
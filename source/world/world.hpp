@@ -6,11 +6,14 @@
 #include <math/vec2i.hpp>
 #include <math/vec3f.hpp>
 #include <math/math_utils.h>
+#include <util/constants.hpp>
 #include <ported/Random.hpp>
 #include <crapper/client.hpp>
 #include <set>
 #include <map>
+#include <vector>
 
+#include <world/entity.hpp>
 #include <world/particle.hpp>
 #include "sound.hpp"
 #include <item/inventory.hpp>
@@ -18,6 +21,9 @@
 #include <mcregion.hpp>
 #include <world/chunk_manager.hpp>
 #include <world/light.hpp>
+#include <world/block_access.hpp>
+#include <render/far_terrain.hpp>
+#include <gertex/gertex.hpp>
 
 class Chunk;
 class EntityPhysical;
@@ -27,8 +33,45 @@ class ChunkProvider;
 class Frustum;
 class TileEntity;
 struct Progress;
+class Section;
 
-class World
+// A section waiting in the visibility search queue
+struct SectionNode
+{
+    Section *sect;
+    int8_t from;     // The face we entered the VBO from
+    uint8_t dirs[6]; // For preventing revisits of the same face
+};
+
+// Chunks around the camera that the visibility search can reach
+#define VISIBILITY_GRID_RADIUS (RENDER_DISTANCE / 16 + 1)
+#define VISIBILITY_GRID_SIZE (VISIBILITY_GRID_RADIUS * 2 + 1)
+
+// Size of the visibility search queue, a power of two that fits every section in the grid
+#define VISIBILITY_QUEUE_SIZE 2048
+
+struct VisibilityStats
+{
+    uint32_t searches = 0;        // Number of searches run
+    uint32_t skipped = 0;         // Ticks that reused the previous result
+    uint32_t last_visited = 0;    // Sections reached by the last search
+    uint32_t last_us = 0;         // Duration of the last search
+    uint32_t average_us = 0;
+    uint32_t cull_us = 0;         // Frustum culling time of the last draw list update
+    uint32_t culled_columns = 0;  // Chunk columns entirely outside the frustum
+    uint32_t partial_columns = 0; // Chunk columns whose sections were tested one by one
+};
+
+// A section in the draw list with its modelview matrix for the current camera
+struct SectionDraw
+{
+    Section *section;
+    Vec3i position;
+    float distance;
+    gertex::GXMatrix matrix;
+};
+
+class World final : public BlockAccess
 {
 public:
     uint32_t ticks = 0;
@@ -45,8 +88,14 @@ public:
     ChunkProvider *chunk_provider = nullptr;
     bool sync_section_updates = false;
     bool smooth_lighting = false;
+    bool greedy_meshing = false;
+    int mesh_workers = 1;
+    bool far_terrain = false;
     bool section_updates_in_tick = false;
 
+    // Bumped when chunks are added or removed or the visibility of a section changes
+    volatile uint32_t visibility_generation = 0;
+
     std::map<int32_t, EntityPhysical *> world_entities;
     std::deque<Chunk *> chunks;
     std::map<uint64_t, Chunk *> chunk_cache;
@@ -75,6 +124,7 @@ public:
     void update();
     void update_frustum(Camera &camera);
     void update_chunks();
+    void swap_section_buffers();
     void try_update_sections();
     bool update_sections();
     void calculate_visibility();
@@ -96,7 +146,7 @@ public:
     void deinit_chunk_manager();
     void set_hell(bool hell);
     BlockID get_block_id_at(const Vec3i &position, BlockID default_id = BlockID::air);
-    BlockState *get_block_at(const Vec3i &vec);
+    BlockState *get_block_at(const Vec3i &vec) override;
     uint8_t get_meta_at(const Vec3i &position);
     void set_block_at(const Vec3i &pos, BlockID id);
     void set_meta_at(const Vec3i &pos, uint8_t meta);
@@ -116,8 +166,14 @@ public:
     void remove_entity(int32_t entity_id);
     EntityPhysical *get_entity_by_id(int32_t entity_id);
 
+    const VisibilityStats &visibility_stats() const { return m_visibility_stats; }
+    const ParticleStats &particle_stats() const { return m_particle_system.stats; }
+    void set_particle_capacity(size_t capacity) { m_particle_system.set_capacity(capacity); }
+
     void draw(Camera &camera);
+    void update_draw_list(Camera &camera);
     void draw_scene(bool opaque);
+    void draw_entities(bool transparency);
     void draw_selected_block();
     void draw_bounds(AABB *bounds);
 
@@ -130,6 +186,33 @@ public:
 private:
     ParticleSystem m_particle_system = ParticleSystem(this);
     SoundSystem *m_sound_system = nullptr;
+    FarTerrain m_far_terrain;
+
+    // State of the visibility search, which only runs again when the camera
+    // enters another section or visibility_generation changes
+    VisibilityStats m_visibility_stats;
+    std::vector<SectionNode> m_visibility_queue;
+    std::vector<Chunk *> m_visibility_grid;
+    uint32_t m_visibility_epoch = 0;
+    uint32_t m_visibility_searched_generation = 0;
+    Vec3i m_visibility_origin = Vec3i(0, -1, 0);
+
+    // Visible sections sorted front to back. Only rebuilt when the camera
+    // or the set of visible sections changes.
+    std::vector<SectionDraw> m_draw_list;
+    std::vector<std::pair<Section *, Vec3i>> m_draw_members;
+    std::vector<std::pair<Section *, Vec3i>> m_draw_members_next;
+    Mtx m_draw_view = {{0}};
+
+    // Chunk columns and their centers, classified against the frustum in one go
+    std::vector<Chunk *> m_cull_chunks;
+    std::vector<float> m_cull_x;
+    std::vector<float> m_cull_y;
+    std::vector<float> m_cull_z;
+    std::vector<uint8_t> m_cull_results;
+
+    // Entities that passed the culling this frame, grouped by type when drawn
+    std::vector<EntityPhysical *> m_entity_batch;
 
     void update_entities();
     void update_player();